@@ -0,0 +1,62 @@
+// the lights with their assignment to the clusters of the view frustum, see
+// the light_registry and light_clusters classes for the buffer layouts
+
+#define LIGHT_OMNI  0
+#define SPOTLIGHT   1
+#define SPHERICAL   2
+#define DIRECTIONAL 3
+
+struct light_t
+{
+    vec3 position;
+    float intensity;
+    vec3 direction;
+    float range;
+    vec3 color;
+    uint type;
+};
+
+layout(std430, binding = 0) buffer lights_buffer { light_t[] lights; };
+
+// see light_clusters class for the layout
+layout(std430, binding = 1) buffer clusters_buffer
+{
+    mat4 cluster_view_matrix;
+    uvec4 cluster_grid_size;
+    // near, far, slice scale, slice bias
+    vec4 cluster_depth_params;
+    vec4 cluster_screen_size;
+    // offset and count of the light indices per cluster
+    uvec2[] clusters;
+};
+
+layout(std430, binding = 2) buffer cluster_lights_buffer
+{
+    uint[] cluster_light_indices;
+};
+
+uint cluster_index()
+{
+    float depth = -(cluster_view_matrix * vec4(fragment_position, 1.0)).z;
+    depth = clamp(depth, cluster_depth_params.x, cluster_depth_params.y);
+    uint slice = uint(max(
+        log(depth) * cluster_depth_params.z + cluster_depth_params.w, 0.0));
+    uvec2 tile = uvec2(gl_FragCoord.xy / cluster_screen_size.xy *
+                       vec2(cluster_grid_size.xy));
+    uvec3 cluster = min(uvec3(tile, slice), cluster_grid_size.xyz - 1);
+    return cluster.x +
+           cluster_grid_size.x * (cluster.y + cluster_grid_size.y * cluster.z);
+}
+
+// smoothly fade the light out towards its range
+float range_falloff(light_t light, float distance)
+{
+    if (light.type == DIRECTIONAL)
+    {
+        return 1.0;
+    }
+
+    float ratio = distance / light.range;
+    float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    return window * window;
+}
@@ -0,0 +1,78 @@
+#version 460 core
+
+in vec2 fragment_uv;
+
+uniform sampler2D u_image;
+uniform vec2 u_texel_size;
+// the part of the image occupied by the frame
+uniform vec2 u_uv_scale;
+
+out vec4 o_fragment_color;
+
+// the contrast below which the pixel is not considered to be on an edge
+const float EDGE_THRESHOLD_MIN = 0.0312;
+const float EDGE_THRESHOLD_MAX = 0.125;
+// the farthest the edge is sampled along, in pixels
+const float SPAN_MAX = 8.0;
+const float REDUCE_MUL = 1.0 / 8.0;
+const float REDUCE_MIN = 1.0 / 128.0;
+
+float luma(vec3 color) { return dot(color, vec3(0.299, 0.587, 0.114)); }
+
+vec3 sample_color(vec2 offset)
+{
+    // don't sample outside of the frame region
+    vec2 uv = clamp(fragment_uv * u_uv_scale + offset,
+                    u_texel_size * 0.5,
+                    u_uv_scale - u_texel_size * 0.5);
+    return texture(u_image, uv).rgb;
+}
+
+void main()
+{
+    vec3 color_m = sample_color(vec2(0.0));
+    float luma_m = luma(color_m);
+    float luma_nw = luma(sample_color(vec2(-1.0, 1.0) * u_texel_size));
+    float luma_ne = luma(sample_color(vec2(1.0, 1.0) * u_texel_size));
+    float luma_sw = luma(sample_color(vec2(-1.0, -1.0) * u_texel_size));
+    float luma_se = luma(sample_color(vec2(1.0, -1.0) * u_texel_size));
+
+    float luma_min =
+        min(luma_m, min(min(luma_nw, luma_ne), min(luma_sw, luma_se)));
+    float luma_max =
+        max(luma_m, max(max(luma_nw, luma_ne), max(luma_sw, luma_se)));
+
+    // leave the flat areas untouched
+    if (luma_max - luma_min <
+        max(EDGE_THRESHOLD_MIN, luma_max * EDGE_THRESHOLD_MAX))
+    {
+        o_fragment_color = vec4(color_m, 1.0);
+        return;
+    }
+
+    // the blur direction goes along the edge
+    vec2 direction = vec2(-((luma_nw + luma_ne) - (luma_sw + luma_se)),
+                          ((luma_nw + luma_sw) - (luma_ne + luma_se)));
+    float direction_reduce =
+        max((luma_nw + luma_ne + luma_sw + luma_se) * 0.25 * REDUCE_MUL,
+            REDUCE_MIN);
+    float inverse_direction_min =
+        1.0 / (min(abs(direction.x), abs(direction.y)) + direction_reduce);
+    direction = clamp(direction * inverse_direction_min,
+                      vec2(-SPAN_MAX),
+                      vec2(SPAN_MAX)) *
+                u_texel_size;
+
+    vec3 color_near = 0.5 * (sample_color(direction * (1.0 / 3.0 - 0.5)) +
+                             sample_color(direction * (2.0 / 3.0 - 0.5)));
+    vec3 color_far = color_near * 0.5 +
+                     0.25 * (sample_color(direction * -0.5) +
+                             sample_color(direction * 0.5));
+
+    // the far samples crossed another edge, fall back to the near ones
+    float luma_far = luma(color_far);
+    o_fragment_color =
+        vec4(luma_far < luma_min || luma_far > luma_max ? color_near
+                                                        : color_far,
+             1.0);
+}
@@ -0,0 +1,4 @@
+// the id of the drawn object for the picking, the background keeps 0
+uniform uint u_object_id;
+
+layout(location = 1) out uint o_object_id;
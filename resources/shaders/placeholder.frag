@@ -0,0 +1,16 @@
+#version 460 core
+
+in vec3 fragment_normal;
+
+layout(location = 0) out vec4 fragment_color;
+
+#include "object_id.glsl"
+
+// drawn while the actual shader of the material is still compiling
+void main()
+{
+    vec3 normal = normalize(fragment_normal);
+    float shade = 0.4 + 0.3 * (normal.y * 0.5 + 0.5);
+    fragment_color = vec4(vec3(shade), 1.0);
+    o_object_id = u_object_id;
+}
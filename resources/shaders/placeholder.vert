@@ -0,0 +1,15 @@
+#version 460 core
+
+layout(location = 0) in vec3 i_vertex_position;
+layout(location = 1) in vec3 i_vertex_normal;
+
+uniform mat4 u_model_matrix;
+uniform mat4 u_vp_matrix;
+
+out vec3 fragment_normal;
+
+void main()
+{
+    gl_Position = u_vp_matrix * u_model_matrix * vec4(i_vertex_position, 1.0);
+    fragment_normal = mat3(u_model_matrix) * i_vertex_normal;
+}
@@ -6,40 +6,36 @@ in vec2 fragment_uv;
 in vec3 fragment_tangent;
 in vec3 fragment_bitangent;
 
+// the texture fetches are compiled in only for the materials using them, see
+// the features declared in standard.shader
+#ifdef HAS_ALBEDO_TEXTURE
 uniform sampler2D u_albedo_texture;
 uniform float u_albedo_texture_strength;
+#endif
 uniform vec4 u_albedo_color;
 uniform sampler2D u_normal_texture;
 uniform float u_normal_texture_strength;
 uniform float u_metallic;
+#ifdef HAS_METALLIC_TEXTURE
 uniform sampler2D u_metallic_texture;
 uniform float u_metallic_texture_strength;
+#endif
+#ifdef HAS_ROUGHNESS_TEXTURE
 uniform sampler2D u_roughness_texture;
 uniform float u_roughness_texture_strength;
+#endif
 uniform float u_roughness;
 uniform float u_ambient_occlusion;
 
 uniform vec3 u_camera_position;
 
-#define LIGHT_OMNI  0
-#define SPOTLIGHT   1
-#define SPHERICAL   2
-#define DIRECTIONAL 3
 const float PI = 3.14159265359;
 
-struct light_t
-{
-    vec3 position;
-    float intensity;
-    vec3 direction;
-    float radius;
-    vec3 color;
-    uint type;
-};
+#include "clustered_lighting.glsl"
 
-layout(std430, binding = 0) buffer lights_buffer { light_t[] lights; };
+layout(location = 0) out vec4 fragment_color;
 
-out vec4 fragment_color;
+#include "object_id.glsl"
 
 vec2 confragment_from_blenders_uv_map(vec2 blender_uv)
 {
@@ -53,9 +49,35 @@ vec2 confragment_from_blenders_uv_map(vec2 blender_uv)
 
 vec4 albedo_mixed_color(vec2 uv_coord)
 {
+#ifdef HAS_ALBEDO_TEXTURE
     return mix(u_albedo_color,
                texture(u_albedo_texture, uv_coord),
                u_albedo_texture_strength);
+#else
+    return u_albedo_color;
+#endif
+}
+
+float roughness_mixed(vec2 uv_coord)
+{
+#ifdef HAS_ROUGHNESS_TEXTURE
+    return mix(u_roughness,
+               texture(u_roughness_texture, uv_coord).r,
+               u_roughness_texture_strength);
+#else
+    return u_roughness;
+#endif
+}
+
+float metallic_mixed(vec2 uv_coord)
+{
+#ifdef HAS_METALLIC_TEXTURE
+    return mix(u_metallic,
+               texture(u_metallic_texture, uv_coord).r,
+               u_metallic_texture_strength);
+#else
+    return u_metallic;
+#endif
 }
 
 vec3 surface_normal(vec2 uv_coord) { return fragment_normal; }
@@ -130,8 +152,10 @@ vec3 direct_light_contribution(light_t light,
     vec3 half_vector = normalize(view_direction + light_to_fragment_direction);
     float light_to_fragment_distance =
         length(light.position - fragment_position);
-    float attenuation = light.intensity / (light_to_fragment_distance *
-                                           light_to_fragment_distance);
+    float attenuation = light.intensity /
+                        (light_to_fragment_distance *
+                         light_to_fragment_distance) *
+                        range_falloff(light, light_to_fragment_distance);
     vec3 radiance = light.color * attenuation;
 
     // cook-torrance brdf
@@ -167,19 +191,18 @@ void main()
 
     vec3 direct_fresnel = vec3(0.04);
     vec3 albedo = albedo_mixed_color(fragment_uv).xyz;
-    float roughness = mix(u_roughness,
-                          texture(u_roughness_texture, fragment_uv).r,
-                          u_albedo_texture_strength);
-    float metallic = mix(u_metallic,
-                         texture(u_metallic_texture, fragment_uv).r,
-                         u_albedo_texture_strength);
+    float roughness = roughness_mixed(fragment_uv);
+    float metallic = metallic_mixed(fragment_uv);
     direct_fresnel = mix(direct_fresnel, albedo.rgb, metallic);
 
     // reflectance equation
+    // only the lights assigned to the cluster of the fragment can reach it
     vec3 direct_light = vec3(0.0);
-    for (int i = 0; i < lights.length(); ++i)
+    uvec2 cluster = clusters[ cluster_index() ];
+    for (uint i = cluster.x; i < cluster.x + cluster.y; ++i)
     {
-        direct_light += direct_light_contribution(lights[ i ],
+        light_t light = lights[ cluster_light_indices[ i ] ];
+        direct_light += direct_light_contribution(light,
                                                   albedo,
                                                   surface_normal,
                                                   view_direction,
@@ -195,4 +218,5 @@ void main()
     color = pow(color, vec3(1.0 / 2.2));
 
     fragment_color = vec4(color, 1.0);
+    o_object_id = u_object_id;
 }
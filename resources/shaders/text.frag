@@ -2,7 +2,9 @@
 
 in vec2 fragment_uv;
 
-out vec4 o_fragment_color;
+layout(location = 0) out vec4 o_fragment_color;
+
+#include "object_id.glsl"
 
 uniform sampler2D u_text;
 uniform vec3 u_text_color;
@@ -11,4 +13,5 @@ void main()
 {
     vec4 sampled = vec4(1.0, 1.0, 1.0, texture(u_text, fragment_uv).r);
     o_fragment_color = vec4(u_text_color, 1.0) * sampled;
+    o_object_id = u_object_id;
 }
@@ -0,0 +1,2 @@
+../shaders/surface.vert
+../shaders/fxaa.frag
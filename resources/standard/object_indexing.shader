@@ -0,0 +1,2 @@
+../object_indexing.vert
+../object_indexing.frag
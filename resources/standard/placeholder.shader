@@ -0,0 +1,2 @@
+../shaders/placeholder.vert
+../shaders/placeholder.frag
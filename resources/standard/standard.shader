@@ -1,2 +1,5 @@
 ../shaders/standard.frag
 ../shaders/standard.vert
+#feature HAS_ALBEDO_TEXTURE u_albedo_texture_strength
+#feature HAS_METALLIC_TEXTURE u_metallic_texture_strength
+#feature HAS_ROUGHNESS_TEXTURE u_roughness_texture_strength
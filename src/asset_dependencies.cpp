@@ -0,0 +1,100 @@
+#include "asset_dependencies.hpp"
+
+void asset_dependencies::set_dependencies(
+    std::string_view asset, const std::vector<std::string>& files)
+{
+    std::string key = normalize(asset);
+    std::vector<std::string> normalized { key };
+    for (const auto& file : files)
+    {
+        normalized.push_back(normalize(file));
+    }
+
+    std::unique_lock lock { _mutex };
+    if (auto it = _dependencies.find(key); it != _dependencies.end())
+    {
+        for (const auto& file : it->second)
+        {
+            _dependents[ file ].erase(key);
+        }
+    }
+
+    for (const auto& file : normalized)
+    {
+        _dependents[ file ].insert(key);
+    }
+    _dependencies[ key ] = std::move(normalized);
+}
+
+bool asset_dependencies::contains(std::string_view asset) const
+{
+    std::unique_lock lock { _mutex };
+    return _dependencies.contains(normalize(asset));
+}
+
+std::vector<std::string>
+asset_dependencies::get_affected(std::string_view file) const
+{
+    std::unique_lock lock { _mutex };
+
+    // the assets of the changed file, then the assets built from them
+    std::set<std::string> affected;
+    std::vector<std::string> queue { normalize(file) };
+    while (!queue.empty())
+    {
+        std::string current = std::move(queue.back());
+        queue.pop_back();
+        auto it = _dependents.find(current);
+        if (it == _dependents.end())
+        {
+            continue;
+        }
+
+        for (const auto& asset : it->second)
+        {
+            if (affected.insert(asset).second)
+            {
+                queue.push_back(asset);
+            }
+        }
+    }
+
+    std::set<std::string> visited;
+    std::vector<std::string> result;
+    for (const auto& asset : affected)
+    {
+        append_ordered(asset, affected, visited, result);
+    }
+    return result;
+}
+
+std::string asset_dependencies::normalize(std::string_view path)
+{
+    return std::filesystem::absolute(std::filesystem::path(path))
+        .lexically_normal()
+        .generic_string();
+}
+
+void asset_dependencies::append_ordered(const std::string& asset,
+                                        const std::set<std::string>& affected,
+                                        std::set<std::string>& visited,
+                                        std::vector<std::string>& result) const
+{
+    // the visited mark is set before the recursion, so the cycles end here
+    if (!visited.insert(asset).second)
+    {
+        return;
+    }
+
+    if (auto it = _dependencies.find(asset); it != _dependencies.end())
+    {
+        for (const auto& file : it->second)
+        {
+            if (file != asset && affected.contains(file))
+            {
+                append_ordered(file, affected, visited, result);
+            }
+        }
+    }
+    result.push_back(asset);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <mutex>
+
+/**
+ * @brief Tracks the files the loaded assets are built from
+ *
+ * Every asset depends on its own file and on the files its loader reported,
+ * e.g. a material on its shader description and a shader description on the
+ * stage sources and the files they include. As the assets are identified by
+ * their paths, an asset depending on another one gets affected by the files
+ * of the other one too.
+ *
+ * The paths are compared in their absolute normalized form. Safe to use from
+ * multiple threads.
+ */
+class asset_dependencies
+{
+public:
+    /**
+     * @brief Replace the recorded dependencies of the asset
+     *
+     * @param asset the path of the asset
+     * @param files the paths of the files the asset was built from
+     */
+    void set_dependencies(std::string_view asset,
+                          const std::vector<std::string>& files);
+
+    bool contains(std::string_view asset) const;
+
+    /**
+     * @brief Get the assets to reload after the file has changed
+     *
+     * @param file the path of the changed file
+     * @return std::vector<std::string> the affected assets, each one after
+     * the affected assets it depends on
+     */
+    std::vector<std::string> get_affected(std::string_view file) const;
+
+    static std::string normalize(std::string_view path);
+
+private:
+    void append_ordered(const std::string& asset,
+                        const std::set<std::string>& affected,
+                        std::set<std::string>& visited,
+                        std::vector<std::string>& result) const;
+
+private:
+    // asset -> the files it's built from
+    std::unordered_map<std::string, std::vector<std::string>> _dependencies;
+    // file -> the assets built from it
+    std::unordered_map<std::string, std::set<std::string>> _dependents;
+    mutable std::mutex _mutex;
+};
@@ -18,6 +18,72 @@
 #include "mesh.hpp"
 #include "scene.hpp"
 
+namespace
+{
+// the parameters the imported materials are built from. the nodes sharing a
+// definition share the base material and get lightweight instances of it
+struct material_definition
+{
+    std::string_view shader;
+    float albedo_texture_strength;
+    glm::vec4 albedo_color;
+    float normal_texture_strength;
+
+    size_t hash() const
+    {
+        size_t result = std::hash<std::string_view> {}(shader);
+        auto combine = [ &result ](size_t value)
+        { result ^= value + 0x9e3779b9 + (result << 6) + (result >> 2); };
+        combine(std::hash<float> {}(albedo_texture_strength));
+        combine(std::hash<glm::vec4> {}(albedo_color));
+        combine(std::hash<float> {}(normal_texture_strength));
+        return result;
+    }
+};
+
+material* create_base_material(const material_definition& definition)
+{
+    material* mat = new material;
+    mat->set_shader_program(
+        asset_manager::default_asset_manager()->get_shader(definition.shader));
+    mat->declare_property("u_albedo_texture_strength",
+                          material_property::data_type::type_float);
+    mat->declare_property("u_albedo_color",
+                          material_property::data_type::type_float_vector_4);
+    mat->declare_property("u_normal_texture_strength",
+                          material_property::data_type::type_float);
+    mat->declare_property("u_model_matrix",
+                          material_property::data_type::unknown);
+    mat->declare_property("u_vp_matrix", material_property::data_type::unknown);
+    mat->set_property_value("u_albedo_texture_strength",
+                            definition.albedo_texture_strength);
+    mat->set_property_value("u_albedo_color",
+                            definition.albedo_color.x,
+                            definition.albedo_color.y,
+                            definition.albedo_color.z,
+                            definition.albedo_color.w);
+    mat->set_property_value("u_normal_texture_strength",
+                            definition.normal_texture_strength);
+    return mat;
+}
+
+// deduplicates the definitions across all the imported files through the
+// asset manager
+material* get_base_material(const material_definition& definition)
+{
+    auto* am = asset_manager::default_asset_manager();
+    std::string name = std::format("fbx_material_{:016x}", definition.hash());
+    if (material* existing = am->get_material(name))
+    {
+        return existing;
+    }
+
+    material* mat = create_base_material(definition);
+    am->register_asset(name, mat);
+    return mat;
+}
+} // namespace
+
 glm::vec3 convert(aiVector3D ai_vec3)
 {
     return { ai_vec3.x, ai_vec3.y, ai_vec3.z };
@@ -33,14 +99,52 @@ glm::vec3 convert(aiColor3D ai_quat)
     return { ai_quat.r, ai_quat.g, ai_quat.b };
 }
 
+asset_loader_FBX::asset_loader_FBX() = default;
+
+asset_loader_FBX::~asset_loader_FBX() = default;
+
 void asset_loader_FBX::load(std::string_view path)
 {
+    read(path);
+    build();
+    store();
+}
+
+void asset_loader_FBX::read(std::string_view path)
+{
+    static constexpr uint32_t import_flags =
+        aiProcess_CalcTangentSpace | aiProcess_Triangulate |
+        aiProcess_JoinIdenticalVertices | aiProcess_SortByPType |
+        aiProcess_EmbedTextures;
+
+    auto log = get_logger("fbx_loader");
+    _cache_key = mesh_cache::make_key(path, import_flags, _lod_levels);
+    if (auto cached = mesh_cache::load(_cache_key))
+    {
+        log->info("Loaded {} from the mesh cache", path);
+        _imported = std::move(cached);
+        _from_cache = true;
+        return;
+    }
+
     Assimp::Importer importer;
-    const aiScene* ai_scene =
-        importer.ReadFile(path.data(),
-                          aiProcess_CalcTangentSpace | aiProcess_Triangulate |
-                              aiProcess_JoinIdenticalVertices |
-                              aiProcess_SortByPType | aiProcess_EmbedTextures);
+    const aiScene* ai_scene = importer.ReadFile(path.data(), import_flags);
+    if (!ai_scene)
+    {
+        log->error(
+            "Failed to import {}: {}", path, importer.GetErrorString());
+        return;
+    }
+
+    convert_scene(ai_scene);
+}
+
+void asset_loader_FBX::build()
+{
+    if (!_imported)
+    {
+        return;
+    }
 
     scene* s = nullptr;
     if (feature_flags::get_flag(feature_flags::flag_name::load_fbx_as_scene))
@@ -48,7 +152,58 @@ void asset_loader_FBX::load(std::string_view path)
         s = new scene;
     }
 
+    for (auto& node : _imported->nodes)
+    {
+        game_object* obj = new game_object;
+        mesh* m = create_mesh(node);
+        asset_manager::default_asset_manager()->register_asset(
+            std::format("{}_mesh", node.name), m);
+
+        material_definition definition {
+            "standard", 0.0f, { 0.8f, 0.353f, 0.088f, 1.0f }, 0.0f
+        };
+        material* mat = new material(get_base_material(definition));
+
+        obj->create_component<mesh_renderer_component>()->set_material(mat);
+        obj->create_component<mesh_component>()->set_mesh(m);
+        obj->set_name(node.name);
+        if (s)
+        {
+            s->add_object(obj);
+        }
+    }
+
+    for (const auto& record : _imported->cameras)
+    {
+        create_camera(record);
+    }
+
+    for (const auto& record : _imported->lights)
+    {
+        create_light(record);
+    }
+
+    // the cache entry of a fresh import is written by the store, the loaded
+    // one isn't needed anymore
+    if (_from_cache)
+    {
+        _imported.reset();
+    }
+}
+
+void asset_loader_FBX::store()
+{
+    if (_imported && !_from_cache)
+    {
+        mesh_cache::store(_cache_key, *_imported);
+    }
+    _imported.reset();
+}
+
+void asset_loader_FBX::convert_scene(const aiScene* ai_scene)
+{
     auto log = get_logger("fbx_loader");
+    _imported.emplace();
     std::queue<aiNode*> dfs_queue;
     dfs_queue.push(ai_scene->mRootNode);
     while (!dfs_queue.empty())
@@ -63,52 +218,21 @@ void asset_loader_FBX::load(std::string_view path)
         log->info("Node: {} meshes: {}", node->mName.C_Str(), node->mNumMeshes);
         if (node->mNumMeshes > 0)
         {
-            game_object* obj = new game_object;
-            mesh* m = nullptr;
-            {
-                std::vector<const aiMesh*> ai_submeshes;
-                for (int i = 0; i < node->mNumMeshes; ++i)
-                {
-                    ai_submeshes.push_back(
-                        ai_scene->mMeshes[ node->mMeshes[ i ] ]);
-                }
-
-                m = load_mesh(std::move(ai_submeshes));
-                asset_manager::default_asset_manager()->register_asset(
-                    std::format("{}_mesh", node->mName.C_Str()), m);
-            }
-            material* mat = new material;
-            mat->set_shader_program(
-                asset_manager::default_asset_manager()->get_shader("standard"));
-            mat->declare_property("u_albedo_texture_strength",
-                                  material_property::data_type::type_float);
-            mat->declare_property(
-                "u_albedo_color",
-                material_property::data_type::type_float_vector_4);
-            mat->declare_property("u_normal_texture_strength",
-                                  material_property::data_type::type_float);
-            mat->declare_property("u_model_matrix",
-                                  material_property::data_type::unknown);
-            mat->declare_property("u_vp_matrix",
-                                  material_property::data_type::unknown);
-            mat->set_property_value("u_albedo_texture_strength", 0.0f);
-            mat->set_property_value(
-                "u_albedo_color", 0.8f, 0.353f, 0.088f, 1.0f);
-            mat->set_property_value("u_normal_texture_strength", 0.0f);
-
-            obj->create_component<mesh_renderer_component>()->set_material(mat);
-            obj->create_component<mesh_component>()->set_mesh(m);
-            obj->set_name(node->mName.C_Str());
-            if (s)
+            std::vector<const aiMesh*> ai_submeshes;
+            for (int i = 0; i < node->mNumMeshes; ++i)
             {
-                s->add_object(obj);
+                ai_submeshes.push_back(ai_scene->mMeshes[ node->mMeshes[ i ] ]);
             }
+
+            auto& imported_node = _imported->nodes.emplace_back();
+            imported_node.name = node->mName.C_Str();
+            imported_node.levels.push_back(
+                convert_mesh(std::move(ai_submeshes)));
         }
     }
 
     for (int i = 0; i < ai_scene->mNumCameras; ++i)
     {
-        auto cam = load_camera(ai_scene->mCameras[ i ]);
         const auto& ai_camera = *ai_scene->mCameras[ i ];
         const auto& ai_camera_node =
             *ai_scene->mRootNode->FindNode(ai_camera.mName);
@@ -120,15 +244,14 @@ void asset_loader_FBX::load(std::string_view path)
         aiVector3D scale;
         aiQuaternion rot;
         final.Decompose(scale, rot, pos);
-        auto& t = cam->get_transform();
-        t.set_position(convert(pos) / convert(scale));
-        t.set_rotation(convert(rot));
+        _imported->cameras.push_back({ ai_camera.mHorizontalFOV * 2.0f,
+                                       convert(pos) / convert(scale),
+                                       convert(rot) });
         log->info("Camera: {}", ai_camera.mName.C_Str());
     }
 
     for (int i = 0; i < ai_scene->mNumLights; ++i)
     {
-        auto l = new light;
         const auto& ai_light = *ai_scene->mLights[ i ];
         const auto& ai_light_node =
             *ai_scene->mRootNode->FindNode(ai_light.mName);
@@ -137,23 +260,23 @@ void asset_loader_FBX::load(std::string_view path)
         aiVector3D scale;
         aiQuaternion rot;
         mat.Decompose(scale, rot, pos);
-        l->get_transform().set_position(convert(ai_light.mPosition + pos) /
-                                        100.0f);
         glm::vec3 combined_intensity_color = convert(ai_light.mColorDiffuse);
         auto intensity = std::max(
             std::max(combined_intensity_color.x, combined_intensity_color.y),
             combined_intensity_color.z);
-        l->set_color(combined_intensity_color / intensity);
-        l->set_intensity(intensity / 100);
+        _imported->lights.push_back({ convert(ai_light.mPosition + pos) /
+                                          100.0f,
+                                      combined_intensity_color / intensity,
+                                      intensity / 100 });
     }
 }
 
-mesh* asset_loader_FBX::load_mesh(std::vector<const aiMesh*> ai_submeshes)
+mesh_cache::level
+asset_loader_FBX::convert_mesh(std::vector<const aiMesh*> ai_submeshes)
 {
-    mesh* result;
-    std::vector<vertex3d> vertices;
-    std::vector<int> indices;
-    std::vector<mesh::submesh_info> submeshes;
+    mesh_cache::level result;
+    auto& vertices = result.vertices;
+    auto& indices = result.indices;
 
     for (auto ai_mesh : ai_submeshes)
     {
@@ -165,7 +288,6 @@ mesh* asset_loader_FBX::load_mesh(std::vector<const aiMesh*> ai_submeshes)
              ++vertex_index)
         {
             vertices.push_back({});
-            constexpr char position_name[] = "position";
             vertices.back().position() = {
                 ai_mesh->mVertices[ vertex_index ].x,
                 ai_mesh->mVertices[ vertex_index ].y,
@@ -188,28 +310,88 @@ mesh* asset_loader_FBX::load_mesh(std::vector<const aiMesh*> ai_submeshes)
                                   info.vertex_index_offset);
         }
 
-        submeshes.push_back(std::move(info));
+        result.submeshes.push_back(std::move(info));
     }
 
-    result = new mesh;
-    result->set_vertices(std::move(vertices));
-    result->set_indices(std::move(indices));
-    result->set_submeshes(std::move(submeshes));
-    result->init();
+    return result;
+}
+
+mesh* asset_loader_FBX::create_mesh(mesh_cache::node& node)
+{
+    auto create_level = [](mesh_cache::level& level)
+    {
+        auto result = std::make_unique<mesh>();
+        result->set_submeshes(std::move(level.submeshes));
+        if (!level.vertex_data.empty())
+        {
+            // the simplified levels are uploaded from the mapped entry
+            result->init(level.vertex_data, level.index_data, level.bounds);
+            return result;
+        }
+
+        result->set_vertices(std::move(level.vertices));
+        result->set_indices(std::move(level.indices));
+        result->init(level.bounds);
+        return result;
+    };
 
+    if (!_from_cache)
+    {
+        // freshly imported, the data is kept in the mesh itself and read
+        // back for the cache, including the generated levels
+        mesh* result = new mesh;
+        result->set_vertices(std::move(node.levels[ 0 ].vertices));
+        result->set_indices(std::move(node.levels[ 0 ].indices));
+        result->set_submeshes(std::move(node.levels[ 0 ].submeshes));
+        result->init();
+        result->generate_lods(_lod_levels);
+
+        node.levels.clear();
+        for (size_t i = 0; i < result->get_lod_count(); ++i)
+        {
+            const mesh* lod = result->get_lod(i);
+            node.levels.push_back({ result->get_lod_screen_size(i),
+                                    lod->get_bounds(),
+                                    lod->get_submeshes(),
+                                    lod->get_vertices(),
+                                    lod->get_indices() });
+        }
+        return result;
+    }
+
+    mesh* result = create_level(node.levels[ 0 ]).release();
+    for (size_t i = 1; i < node.levels.size(); ++i)
+    {
+        result->add_lod(create_level(node.levels[ i ]),
+                        node.levels[ i ].screen_size);
+    }
     return result;
 }
 
-camera* asset_loader_FBX::load_camera(const aiCamera* ai_camera)
+camera* asset_loader_FBX::create_camera(const mesh_cache::camera_record& record)
 {
     camera* result = new camera;
-    result->set_fov(ai_camera->mHorizontalFOV * 2.0f);
+    result->set_fov(record.fov);
     result->set_ortho(false);
+    auto& t = result->get_transform();
+    t.set_position(record.position);
+    t.set_rotation(record.rotation);
     return result;
 }
 
-light* asset_loader_FBX::load_light(const aiLight* ai_light)
+light* asset_loader_FBX::create_light(const mesh_cache::light_record& record)
 {
     light* result = new light;
+    result->get_transform().set_position(record.position);
+    result->set_color(record.color);
+    result->set_intensity(record.intensity);
     return result;
 }
+
+void asset_loader_FBX::set_lod_levels(std::vector<mesh::lod_level> levels)
+{
+    _lod_levels = std::move(levels);
+}
+
+std::vector<mesh::lod_level> asset_loader_FBX::_lod_levels =
+    mesh::default_lod_levels();
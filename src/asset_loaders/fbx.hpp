@@ -3,26 +3,67 @@
 #include <vector>
 
 #include "asset_loaders/asset_loader.hpp"
+#include "mesh.hpp"
+#include "mesh_cache.hpp"
 
-class mesh;
 class camera;
 class light;
 
 class aiMesh;
 class aiCamera;
 class aiLight;
+class aiScene;
 
 class asset_loader_FBX : public asset_loader
 {
 public:
-    ~asset_loader_FBX() = default;
+    asset_loader_FBX();
+    ~asset_loader_FBX();
     void load(std::string_view path) override;
 
+    /**
+     * @brief Import the file without touching the GL context
+     *
+     * Reads the mesh cache entry of the file if it's there, otherwise
+     * imports the file. Safe to call on any thread, the scene is created by
+     * @ref build.
+     */
+    void read(std::string_view path);
+
+    /**
+     * @brief Create the meshes, materials and the objects of the read file
+     *
+     * Must be called on the thread owning the GL context.
+     */
+    void build();
+
+    /**
+     * @brief Write the freshly imported file to the mesh cache
+     *
+     * Safe to call on any thread after @ref build, does nothing for a file
+     * loaded from the cache.
+     */
+    void store();
+
+    /**
+     * @brief Set the levels of detail generated for the imported meshes
+     *
+     * @param levels the levels ordered from the finest to the coarsest, empty
+     * to disable the generation
+     */
+    static void set_lod_levels(std::vector<mesh::lod_level> levels);
+
 private:
-    mesh* load_mesh(std::vector<const aiMesh*> ai_submeshes);
-    camera* load_camera(const aiCamera* ai_camera);
-    light* load_light(const aiLight* ai_light);
+    void convert_scene(const aiScene* ai_scene);
+    static mesh_cache::level
+    convert_mesh(std::vector<const aiMesh*> ai_submeshes);
+    mesh* create_mesh(mesh_cache::node& node);
+    camera* create_camera(const mesh_cache::camera_record& record);
+    light* create_light(const mesh_cache::light_record& record);
 
 private:
-    mesh* _mesh;
+    std::optional<mesh_cache::entry> _imported;
+    std::string _cache_key;
+    bool _from_cache { false };
+    static std::vector<mesh::lod_level> _lod_levels;
 };
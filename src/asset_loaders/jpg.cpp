@@ -9,7 +9,9 @@
 
 #include "asset_loaders/jpg.hpp"
 
+#include "file_view.hpp"
 #include "image.hpp"
+#include "image_conversion.hpp"
 
 struct my_error_mgr
 {
@@ -30,52 +32,53 @@ my_error_exit(j_common_ptr cinfo)
 
 void asset_loader_JPG::load(std::string_view path)
 {
-    struct jpeg_decompress_struct cinfo;
-    struct my_error_mgr jerr;
-    FILE* infile;      /* source file */
-    JSAMPARRAY buffer; /* Output row buffer */
-    int row_stride;    /* physical row width in output buffer */
-
-    if ((infile = fopen(path.data(), "rb")) == NULL)
+    file_view content { path };
+    if (!content)
     {
-        fprintf(stderr, "can't open %s\n", path.data());
         return;
     }
 
+    load(content.data());
+}
+
+void asset_loader_JPG::load(std::span<const std::byte> contents)
+{
+    struct jpeg_decompress_struct cinfo;
+    struct my_error_mgr jerr;
+    JSAMPARRAY rows; /* rows of the image storage */
+    int row_stride;  /* physical row width in output buffer */
+
     cinfo.err = jpeg_std_error(&jerr.pub);
     jerr.pub.error_exit = my_error_exit;
 
     if (setjmp(jerr.setjmp_buffer))
     {
         jpeg_destroy_decompress(&cinfo);
-        fclose(infile);
+        delete _image;
+        _image = nullptr;
         return;
     }
 
     jpeg_create_decompress(&cinfo);
-    jpeg_stdio_src(&cinfo, infile);
+    // older versions of the library take a non-const pointer, the data is
+    // read only either way
+    jpeg_mem_src(&cinfo,
+                 const_cast<unsigned char*>(
+                     reinterpret_cast<const unsigned char*>(contents.data())),
+                 static_cast<unsigned long>(contents.size()));
     (void)jpeg_read_header(&cinfo, TRUE);
-    (void)jpeg_start_decompress(&cinfo);
-    row_stride = cinfo.output_width * cinfo.output_components;
-    buffer = (*cinfo.mem->alloc_sarray)(
-        (j_common_ptr)&cinfo, JPOOL_IMAGE, row_stride, 1);
-    char* data = new char[ cinfo.image_height * row_stride ];
-    char* data_iterator = data;
-    while (cinfo.output_scanline < cinfo.output_height)
+    // the decoder converts YCCK to CMYK, which is handled by the conversions
+    if (cinfo.jpeg_color_space == JCS_YCCK)
     {
-        (void)jpeg_read_scanlines(&cinfo, buffer, 1);
-        for (int i = 0; i < row_stride; ++i)
-        {
-            *(data_iterator++) = static_cast<char>(buffer[ 0 ][ i ]);
-        }
+        cinfo.out_color_space = JCS_CMYK;
     }
-
+    (void)jpeg_start_decompress(&cinfo);
     image::metadata md;
     md._file_format = image::file_format::JPG;
     md._width = cinfo.output_width;
     md._height = cinfo.output_height;
     md._channel_count = cinfo.out_color_components;
-    md._bits_per_pixel = 8;
+    md._bits_per_pixel = 8 * cinfo.out_color_components;
     md._bytes_per_row = cinfo.output_width * cinfo.output_components;
     switch (cinfo.out_color_space)
     {
@@ -111,13 +114,108 @@ void asset_loader_JPG::load(std::string_view path)
     }
     }
 
+    // the scanlines are decoded right into the storage of the image, as many
+    // at once as the decoder is willing to produce
     _image = new image;
     _image->init(md);
-    _image->set_data(data);
+    row_stride = md._bytes_per_row;
+    char* data = _image->allocate(row_stride);
+    rows = static_cast<JSAMPARRAY>((*cinfo.mem->alloc_small)(
+        (j_common_ptr)&cinfo,
+        JPOOL_IMAGE,
+        cinfo.output_height * sizeof(JSAMPROW)));
+    for (JDIMENSION i = 0; i < cinfo.output_height; ++i)
+    {
+        rows[ i ] = reinterpret_cast<JSAMPROW>(data + i * row_stride);
+    }
+    while (cinfo.output_scanline < cinfo.output_height)
+    {
+        (void)jpeg_read_scanlines(&cinfo,
+                                  rows + cinfo.output_scanline,
+                                  cinfo.output_height - cinfo.output_scanline);
+    }
 
     (void)jpeg_finish_decompress(&cinfo);
     jpeg_destroy_decompress(&cinfo);
-    fclose(infile);
+}
+
+void asset_loader_JPG::save(std::string_view path)
+{
+    if (_image == nullptr || _image->get_width() == 0 ||
+        _image->get_height() == 0)
+    {
+        return;
+    }
+
+    struct jpeg_compress_struct cinfo;
+    struct my_error_mgr jerr;
+    FILE* outfile;
+
+    if ((outfile = fopen(path.data(), "wb")) == NULL)
+    {
+        fprintf(stderr, "can't open %s\n", path.data());
+        return;
+    }
+
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = my_error_exit;
+
+    if (setjmp(jerr.setjmp_buffer))
+    {
+        jpeg_destroy_compress(&cinfo);
+        fclose(outfile);
+        return;
+    }
+
+    jpeg_create_compress(&cinfo);
+    jpeg_stdio_dest(&cinfo, outfile);
+
+    // the input is 8-bit RGBA, as saved by the png loader
+    const auto& md = _image->get_metadata();
+    cinfo.image_width = md._width;
+    cinfo.image_height = md._height;
+#ifdef JCS_EXTENSIONS
+    // libjpeg-turbo drops the alpha channel by itself
+    cinfo.input_components = 4;
+    cinfo.in_color_space = JCS_EXT_RGBA;
+#else
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+#endif
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, _quality, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+
+    const auto* data = _image->get_data<uint8_t>();
+#ifdef JCS_EXTENSIONS
+    while (cinfo.next_scanline < cinfo.image_height)
+    {
+        JSAMPROW row = const_cast<JSAMPROW>(
+            data + cinfo.next_scanline * md._bytes_per_row);
+        (void)jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+#else
+    std::vector<uint8_t> packed(md._width * 3);
+    while (cinfo.next_scanline < cinfo.image_height)
+    {
+        pack_rgba_to_rgb(data + cinfo.next_scanline * md._bytes_per_row,
+                         packed.data(),
+                         md._width);
+        JSAMPROW row = packed.data();
+        (void)jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+#endif
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    fclose(outfile);
 }
 
 image* asset_loader_JPG::get_image() { return _image; }
+
+void asset_loader_JPG::set_image(image* img) { _image = img; }
+
+void asset_loader_JPG::set_quality(int quality)
+{
+    _quality = std::clamp(quality, 1, 100);
+}
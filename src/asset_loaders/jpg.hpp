@@ -9,9 +9,21 @@ class asset_loader_JPG : public asset_loader
 public:
     ~asset_loader_JPG() = default;
     void load(std::string_view path) override;
+    /**
+     * @brief Decode the image from the contents of a file
+     */
+    void load(std::span<const std::byte> contents);
+    void save(std::string_view path) override;
 
     image* get_image();
+    void set_image(image* img);
+
+    /**
+     * @brief Set the quality of the saved images, in range [1, 100]
+     */
+    void set_quality(int quality);
 
 private:
     image* _image = nullptr;
+    int _quality = 90;
 };
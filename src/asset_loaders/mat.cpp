@@ -4,7 +4,7 @@
 #include "asset_loaders/mat.hpp"
 
 #include "asset_manager.hpp"
-#include "file.hpp"
+#include "file_view.hpp"
 #include "logging.hpp"
 #include "material.hpp"
 
@@ -34,33 +34,63 @@ std::tuple<Args...> from_json(const nlohmann::json& args,
 
 void asset_loader_MAT::load(std::string_view path)
 {
-    std::string content = file::read_all(path);
-    json mat_struct = json::parse(content);
+    file_view content { path };
+    std::string_view text = content.text();
+    json mat_struct = json::parse(text.begin(), text.end());
 
-    std::string shader_exclusive_name =
-        mat_struct[ "shader" ].get<std::string>();
     auto* am = asset_manager::default_asset_manager();
-    shader_program* sh;
     std::filesystem::path dir = std::filesystem::path(path).parent_path();
-    std::string shader_name = (dir / shader_exclusive_name).string();
-    std::string shader_path = shader_name + ".shader";
-
-    if (sh = am->get_shader(shader_name); !sh)
+    if (mat_struct.contains("parent"))
     {
-        am->load_asset(shader_path);
-    }
+        // an instance, the program and the defaults come from the parent
+        std::string parent_name = mat_struct[ "parent" ].get<std::string>();
+        std::string parent_path = (dir / (parent_name + ".mat")).string();
+        _dependencies.push_back(parent_path);
+        material* parent = am->get_material(parent_name);
+        if (!parent)
+        {
+            am->load_asset(parent_path);
+            parent = am->get_material(parent_name);
+        }
 
-    if (sh = am->get_shader(shader_exclusive_name); !sh)
-    {
-        log()->error(
-            "(Shader file '{}' required by material '{}' could not be found) ",
-            shader_path,
-            path);
-        return;
+        if (!parent)
+        {
+            log()->error("(Parent material '{}' required by material '{}' "
+                         "could not be found) ",
+                         parent_name,
+                         path);
+            return;
+        }
+
+        _material = new material(parent);
     }
+    else
+    {
+        std::string shader_exclusive_name =
+            mat_struct[ "shader" ].get<std::string>();
+        shader_program* sh;
+        std::string shader_name = (dir / shader_exclusive_name).string();
+        std::string shader_path = shader_name + ".shader";
+        _dependencies.push_back(shader_path);
+
+        // the programs are registered by their file names
+        if (sh = am->get_shader(shader_exclusive_name); !sh)
+        {
+            am->load_asset(shader_path);
+        }
+
+        if (sh = am->get_shader(shader_exclusive_name); !sh)
+        {
+            log()->error("(Shader file '{}' required by material '{}' could "
+                         "not be found) ",
+                         shader_path,
+                         path);
+            return;
+        }
 
-    _material = new material;
-    _material->set_shader_program(sh);
+        _material = new material;
+        _material->set_shader_program(sh);
+    }
 
     for (auto& prop : mat_struct[ "properties" ])
     {
@@ -83,7 +113,11 @@ void asset_loader_MAT::load(std::string_view path)
             }
         }
 
-        _material->declare_property(prop_name, prop_type);
+        // the instances only override the values of the inherited ones
+        if (!_material->has_property(prop_name))
+        {
+            _material->declare_property(prop_name, prop_type);
+        }
         if (prop.contains("value"))
         {
             switch (prop_type)
@@ -117,3 +151,8 @@ void asset_loader_MAT::load(std::string_view path)
 }
 
 material* asset_loader_MAT::get_material() { return _material; }
+
+const std::vector<std::string>& asset_loader_MAT::get_dependencies() const
+{
+    return _dependencies;
+}
@@ -11,7 +11,13 @@ public:
     void load(std::string_view path) override;
 
     material* get_material();
+    /**
+     * @brief Get the paths of the parent material or the shader description
+     * the material was built from
+     */
+    const std::vector<std::string>& get_dependencies() const;
 
 private:
-    material* _material;
+    material* _material = nullptr;
+    std::vector<std::string> _dependencies;
 };
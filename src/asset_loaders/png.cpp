@@ -2,25 +2,70 @@
 
 #include "asset_loaders/png.hpp"
 
+#include "file_view.hpp"
 #include "image.hpp"
 
+namespace
+{
+struct memory_source
+{
+    std::span<const std::byte> data;
+    size_t offset = 0;
+};
+
+void read_from_memory(png_structp png, png_bytep target, png_size_t length)
+{
+    auto* source = static_cast<memory_source*>(png_get_io_ptr(png));
+    if (length > source->data.size() - source->offset)
+    {
+        png_error(png, "Read past the end of the data");
+    }
+
+    std::memcpy(target, source->data.data() + source->offset, length);
+    source->offset += length;
+}
+} // namespace
+
 void asset_loader_PNG::load(std::string_view path)
 {
-    FILE* fp = fopen(path.data(), "rb");
+    file_view content { path };
+    if (!content)
+    {
+        return;
+    }
+
+    load(content.data());
+}
 
+void asset_loader_PNG::load(std::span<const std::byte> contents)
+{
     png_structp png =
         png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
     if (!png)
-        abort();
+    {
+        return;
+    }
 
     png_infop info = png_create_info_struct(png);
     if (!info)
-        abort();
+    {
+        png_destroy_read_struct(&png, NULL, NULL);
+        return;
+    }
 
+    // declared before the jump target, so the jump skips no destructors
+    memory_source source { contents };
+    std::vector<png_bytep> rows;
     if (setjmp(png_jmpbuf(png)))
-        abort();
+    {
+        // a broken or partially written file isn't worth crashing on
+        png_destroy_read_struct(&png, &info, NULL);
+        delete _image;
+        _image = nullptr;
+        return;
+    }
 
-    png_init_io(png, fp);
+    png_set_read_fn(png, &source, read_from_memory);
 
     png_read_info(png, info);
 
@@ -37,19 +82,10 @@ void asset_loader_PNG::load(std::string_view path)
         png_set_expand_gray_1_2_4_to_8(png);
     if (png_get_valid(png, info, PNG_INFO_tRNS))
         png_set_tRNS_to_alpha(png);
+    // passes of the interlaced images are merged by png_read_image
+    png_set_interlace_handling(png);
     png_read_update_info(png, info);
 
-    char* buffer = new char[ height * png_get_rowbytes(png, info) ];
-    for (int i = 0; i < height; ++i)
-    {
-        png_read_row(png,
-                     reinterpret_cast<png_bytep>(
-                         buffer + i * png_get_rowbytes(png, info)),
-                     nullptr);
-    }
-
-    fclose(fp);
-
     image::metadata md;
 
     width = png_get_image_width(png, info);
@@ -112,14 +148,21 @@ void asset_loader_PNG::load(std::string_view path)
     }
 
     md._bits_per_pixel = bit_depth * md._channel_count;
-    md._bytes_per_row = png_get_rowbytes(png, info);
     md._file_format = image::file_format::PNG;
 
-    png_destroy_read_struct(&png, &info, NULL);
-
+    // the rows are decoded right into the storage of the image
     _image = new image;
     _image->init(md);
-    _image->set_data(reinterpret_cast<char*>(buffer));
+    const size_t row_bytes = png_get_rowbytes(png, info);
+    char* data = _image->allocate(row_bytes);
+    rows.resize(height);
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        rows[ i ] = reinterpret_cast<png_bytep>(data + i * row_bytes);
+    }
+    png_read_image(png, rows.data());
+
+    png_destroy_read_struct(&png, &info, NULL);
 }
 
 void asset_loader_PNG::save(std::string_view path)
@@ -146,6 +189,15 @@ void asset_loader_PNG::save(std::string_view path)
         abort();
 
     png_init_io(png, fp);
+    if (_compression_level >= 0)
+    {
+        png_set_compression_level(png, _compression_level);
+        if (_compression_level <= 3)
+        {
+            // the cheap filter keeps the fast levels fast
+            png_set_filter(png, PNG_FILTER_TYPE_BASE, PNG_FILTER_SUB);
+        }
+    }
 
     // Output is 8bit depth, RGBA format.
     png_set_IHDR(png,
@@ -159,11 +211,11 @@ void asset_loader_PNG::save(std::string_view path)
                  PNG_FILTER_TYPE_DEFAULT);
     png_write_info(png, info);
 
-    for (size_t i = _image->get_height(); i > 0; --i)
+    for (size_t i = 0; i < _image->get_height(); ++i)
     {
         png_write_row(png,
                       _image->get_data<unsigned char>() +
-                          (i - 1) * _image->get_metadata()._bytes_per_row);
+                          i * _image->get_metadata()._bytes_per_row);
     }
 
     png_write_end(png, NULL);
@@ -175,3 +227,8 @@ void asset_loader_PNG::save(std::string_view path)
 image* asset_loader_PNG::get_image() { return _image; }
 
 void asset_loader_PNG::set_image(image* img) { _image = img; }
+
+void asset_loader_PNG::set_compression_level(int level)
+{
+    _compression_level = level;
+}
@@ -9,11 +9,26 @@ class asset_loader_PNG : public asset_loader
 public:
     ~asset_loader_PNG() = default;
     void load(std::string_view path) override;
+    /**
+     * @brief Decode the image from the contents of a file
+     */
+    void load(std::span<const std::byte> contents);
     void save(std::string_view path) override;
 
     image* get_image();
     void set_image(image* img);
 
+    /**
+     * @brief Set the zlib compression level of the saved images
+     *
+     * The lower levels encode considerably faster at the cost of the file
+     * size, which suits the frequent captures.
+     *
+     * @param level the level in range [0, 9], -1 for the zlib default
+     */
+    void set_compression_level(int level);
+
 private:
     image* _image = nullptr;
+    int _compression_level = -1;
 };
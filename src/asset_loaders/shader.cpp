@@ -2,28 +2,114 @@
 
 #include "../shader.hpp"
 #include "file.hpp"
+#include "file_view.hpp"
+#include "logging.hpp"
 
-void asset_loader_SHADER::load(std::string_view path)
+namespace
 {
-    std::string content = file::read_all(path);
-    std::stringstream ss(content);
-    std::string shader_line;
-    shader_program* prog = new shader_program();
-    prog->init();
-    while (std::getline(ss, shader_line, '\n'))
+static inline logger log() { return get_logger("asset_loader_shader"); }
+
+struct shader_description
+{
+    std::vector<std::string> sources;
+    std::vector<shader_program::feature> features;
+    std::set<std::filesystem::path> visited;
+};
+
+// the description lists the stage sources line by line, the lines may also
+// include other descriptions or declare the features of the shader:
+//   #include common.shader
+//   #feature HAS_ALBEDO_TEXTURE u_albedo_texture_strength
+void parse_description(const std::filesystem::path& path,
+                       shader_description& description)
+{
+    if (!description.visited.insert(path.lexically_normal()).second)
+    {
+        return;
+    }
+
+    file_view content { path.string() };
+    std::string_view remaining = content.text();
+    std::filesystem::path dir = path.parent_path();
+    while (!remaining.empty())
     {
-        std::filesystem::path dir = std::filesystem::path(path).parent_path();
+        size_t line_end = remaining.find('\n');
+        std::string shader_line { remaining.substr(0, line_end) };
+        remaining.remove_prefix(
+            line_end == std::string_view::npos ? remaining.size()
+                                               : line_end + 1);
+        if (!shader_line.empty() && shader_line.back() == '\r')
+        {
+            shader_line.pop_back();
+        }
+
+        std::stringstream line_stream(shader_line);
+        std::string directive;
+        line_stream >> directive;
+        if (directive == "#include")
+        {
+            std::string included;
+            line_stream >> included;
+            parse_description(dir / included, description);
+            continue;
+        }
+
+        if (directive == "#feature")
+        {
+            shader_program::feature feature;
+            line_stream >> feature.define >> feature.property;
+            if (feature.property.empty())
+            {
+                log()->warn("Incomplete feature declaration \"{}\" in {}",
+                            shader_line,
+                            path.string());
+                continue;
+            }
+
+            description.features.push_back(std::move(feature));
+            continue;
+        }
+
         std::string shader_name = (dir / shader_line).string();
         if (file::exists(shader_name))
         {
-            prog->add_shader(shader_name);
+            description.sources.push_back(std::move(shader_name));
         }
     }
+}
+} // namespace
+
+void asset_loader_SHADER::load(std::string_view path)
+{
+    shader_description description;
+    parse_description(std::filesystem::path(path), description);
+
+    shader_program* prog = new shader_program();
+    prog->init();
+    // the features must be known before compiling the shaders
+    for (auto& feature : description.features)
+    {
+        prog->declare_feature(std::move(feature.define),
+                              std::move(feature.property));
+    }
 
+    for (const auto& source : description.sources)
+    {
+        prog->add_shader(source);
+    }
+
+    // only submitted here, the loading of the other assets continues while
+    // the driver compiles
     prog->link();
-    if (prog->linked())
+    _shader_program = prog;
+
+    for (const auto& visited : description.visited)
     {
-        _shader_program = prog;
+        _dependencies.push_back(visited.string());
+    }
+    for (const auto& source : prog->get_source_files())
+    {
+        _dependencies.push_back(source.string());
     }
 }
 
@@ -31,3 +117,8 @@ shader_program* asset_loader_SHADER::get_shader_program()
 {
     return _shader_program;
 }
+
+const std::vector<std::string>& asset_loader_SHADER::get_dependencies() const
+{
+    return _dependencies;
+}
@@ -11,7 +11,13 @@ public:
     void load(std::string_view path) override;
 
     shader_program* get_shader_program();
+    /**
+     * @brief Get the files the program was built from, the included
+     * descriptions and the stage sources with their includes
+     */
+    const std::vector<std::string>& get_dependencies() const;
 
 private:
     shader_program* _shader_program = nullptr;
+    std::vector<std::string> _dependencies;
 };
@@ -1,5 +1,6 @@
 #include "asset_manager.hpp"
 
+#include "asset_dependencies.hpp"
 #include "asset_loaders/fbx.hpp"
 #include "asset_loaders/jpg.hpp"
 #include "asset_loaders/mat.hpp"
@@ -8,14 +9,54 @@
 #include "file.hpp"
 #include "image.hpp"
 #include "logging.hpp"
+#include "material.hpp"
 #include "mesh.hpp"
 #include "shader.hpp"
+#include "texture.hpp"
+#include "texture_cache.hpp"
+#include "texture_uploader.hpp"
+#include "worker_pool.hpp"
 
 namespace
 {
 static logger log() { return get_logger("asset_manager"); }
+
+// editors write the files in several steps, the change is picked up once
+// the file is left alone for a while
+static constexpr auto reload_settle_time = std::chrono::milliseconds(100);
+
+image* decode_image(const std::string& path, std::string_view extension)
+{
+#ifdef GAMIFY_SUPPORTS_JPG
+    if (extension == ".jpg" || extension == ".jpeg")
+    {
+        asset_loader_JPG jpg_loader;
+        jpg_loader.load(path);
+        return jpg_loader.get_image();
+    }
+#endif
+#ifdef GAMIFY_SUPPORTS_PNG
+    if (extension == ".png")
+    {
+        asset_loader_PNG png_loader;
+        png_loader.load(path);
+        return png_loader.get_image();
+    }
+#endif
+    return nullptr;
+}
 } // namespace
 
+asset_manager::asset_manager()
+    : _dependencies(std::make_unique<asset_dependencies>())
+    , _loaders(std::make_unique<worker_pool>(
+          std::max(std::thread::hardware_concurrency(), 2u) - 1,
+          "asset_loader"))
+{
+}
+
+asset_manager::~asset_manager() = default;
+
 void asset_manager::load_asset(std::string_view path)
 {
     auto [ _, filename, extension ] = file::parse_path(path);
@@ -33,6 +74,9 @@ void asset_manager::load_asset(std::string_view path)
         asset_loader_SHADER shader_loader;
         shader_loader.load(path);
         shader_loader.get_shader_program()->set_name(filename);
+        _dependencies->set_dependencies(path,
+                                        shader_loader.get_dependencies());
+        std::unique_lock lock { _assets_mutex };
         auto [ it, success ] = _shader_programs.try_emplace(
             filename, shader_loader.get_shader_program());
         return;
@@ -43,6 +87,8 @@ void asset_manager::load_asset(std::string_view path)
     {
         asset_loader_MAT mat_loader;
         mat_loader.load(path);
+        _dependencies->set_dependencies(path, mat_loader.get_dependencies());
+        std::unique_lock lock { _assets_mutex };
         auto [ it, success ] =
             _materials.try_emplace(filename, mat_loader.get_material());
         return;
@@ -53,6 +99,9 @@ void asset_manager::load_asset(std::string_view path)
     {
         asset_loader_JPG jpg_loader;
         jpg_loader.load(path);
+        _dependencies->set_dependencies(path, {});
+        std::unique_lock lock { _assets_mutex };
+        _image_paths.try_emplace(filename, path);
         auto [ it, success ] =
             _images.try_emplace(filename, jpg_loader.get_image());
         return;
@@ -63,6 +112,9 @@ void asset_manager::load_asset(std::string_view path)
     {
         asset_loader_PNG png_loader;
         png_loader.load(path);
+        _dependencies->set_dependencies(path, {});
+        std::unique_lock lock { _assets_mutex };
+        _image_paths.try_emplace(filename, path);
         auto [ it, success ] =
             _images.try_emplace(filename, png_loader.get_image());
         return;
@@ -72,6 +124,439 @@ void asset_manager::load_asset(std::string_view path)
     log()->error("Asset manager doesn't support {} format", extension);
 }
 
+std::shared_future<void>
+asset_manager::load_asset_async(std::string_view path, load_callback on_loaded)
+{
+    auto promise = std::make_shared<std::promise<void>>();
+    std::shared_future<void> result = promise->get_future().share();
+    {
+        std::unique_lock lock { _loads_mutex };
+        ++_pending_loads;
+    }
+
+    _loaders->submit(
+        [ this,
+          path = std::string(path),
+          promise = std::move(promise),
+          on_loaded = std::move(on_loaded) ]() mutable
+    {
+        std::function<void()> finish = decode_asset(path);
+        std::unique_lock lock { _loads_mutex };
+        _decoded_loads.push(
+            [ path = std::move(path),
+              promise = std::move(promise),
+              on_loaded = std::move(on_loaded),
+              finish = std::move(finish) ]
+        {
+            if (finish)
+            {
+                finish();
+            }
+
+            if (on_loaded)
+            {
+                on_loaded(path);
+            }
+            promise->set_value();
+        });
+        _loads_condition.notify_all();
+    });
+    return result;
+}
+
+void asset_manager::process_loaded_assets()
+{
+    std::queue<std::function<void()>> decoded;
+    {
+        std::unique_lock lock { _loads_mutex };
+        std::swap(decoded, _decoded_loads);
+    }
+
+    while (!decoded.empty())
+    {
+        decoded.front()();
+        decoded.pop();
+
+        std::unique_lock lock { _loads_mutex };
+        --_pending_loads;
+        _loads_condition.notify_all();
+    }
+
+    process_uploads();
+    reload_changed_assets();
+    swap_reloaded_programs();
+}
+
+void asset_manager::process_uploads() { _uploader->process(); }
+
+bool asset_manager::has_loaded_assets() const
+{
+    {
+        std::unique_lock lock { _loads_mutex };
+        if (!_decoded_loads.empty())
+        {
+            return true;
+        }
+    }
+
+    if (!_reloading_programs.empty())
+    {
+        return true;
+    }
+
+    std::unique_lock lock { _changes_mutex };
+    auto now = std::chrono::steady_clock::now();
+    return std::any_of(_changed_files.begin(),
+                       _changed_files.end(),
+                       [ now ](const auto& change)
+    { return now - change.second >= reload_settle_time; });
+}
+
+void asset_manager::wait_for_loads()
+{
+    while (true)
+    {
+        process_loaded_assets();
+
+        std::unique_lock lock { _loads_mutex };
+        if (_pending_loads == 0)
+        {
+            lock.unlock();
+            // the textures become ready once their copies complete
+            _uploader->finish();
+            return;
+        }
+
+        _loads_condition.wait(lock,
+                              [ this ]
+        { return !_decoded_loads.empty() || _pending_loads == 0; });
+    }
+}
+
+void asset_manager::watch_assets(std::string_view root)
+{
+    // not every platform watches the subdirectories, so each directory gets
+    // a watch of its own, the doubled events are merged by the path
+    std::vector<std::filesystem::path> directories { root };
+    std::error_code error;
+    for (const auto& entry :
+         std::filesystem::recursive_directory_iterator(root, error))
+    {
+        if (entry.is_directory())
+        {
+            directories.push_back(entry.path());
+        }
+    }
+
+    for (const auto& directory : directories)
+    {
+        _watches.push_back(std::make_unique<file::file_watch_hook>(file::watch(
+            directory.string(),
+            [ this, directory ](std::string_view path, file::event_type change)
+        {
+            if (change == file::event_type::removed ||
+                change == file::event_type::unknown)
+            {
+                return;
+            }
+
+            // the paths are relative to the watched directory
+            std::unique_lock lock { _changes_mutex };
+            _changed_files[ asset_dependencies::normalize(
+                (directory / path).string()) ] =
+                std::chrono::steady_clock::now();
+        })));
+    }
+}
+
+std::function<void()> asset_manager::decode_asset(const std::string& path)
+{
+    auto [ _, filename, extension ] = file::parse_path(path);
+#ifdef GAMIFY_SUPPORTS_FBX
+    if (extension == ".fbx")
+    {
+        // assimp import is the expensive part, the meshes and the objects
+        // are created on the context thread and the cache entry is written
+        // back here
+        auto fbx_loader = std::make_shared<asset_loader_FBX>();
+        fbx_loader->read(path);
+        return [ this, fbx_loader ]
+        {
+            fbx_loader->build();
+            _loaders->submit([ fbx_loader ] { fbx_loader->store(); });
+        };
+    }
+#endif
+    if (extension == ".png" || extension == ".jpg" || extension == ".jpeg")
+    {
+        // the renderer needs the cooked form only, the image itself is
+        // decoded once it is requested
+        if (auto cooked = texture_cache::load(path))
+        {
+            _dependencies->set_dependencies(path, {});
+            {
+                std::unique_lock lock { _assets_mutex };
+                _image_paths.try_emplace(filename, path);
+            }
+
+            // the levels are staged here, only the copies into the texture
+            // are left for the context thread
+            auto staged = std::make_shared<texture_uploader::staging>(
+                texture_cache::stage(*cooked, *_uploader));
+            cooked->mapping.reset();
+            auto entry =
+                std::make_shared<texture_cache::entry>(std::move(*cooked));
+            return [ this, filename, entry, staged ]
+            {
+                auto txt = new texture;
+                texture_cache::submit(
+                    *entry, std::move(*staged), *txt, *_uploader);
+                std::unique_lock lock { _assets_mutex };
+                _textures.try_emplace(filename, txt);
+            };
+        }
+    }
+#ifdef GAMIFY_SUPPORTS_JPG
+    if (extension == ".jpg" || extension == ".jpeg")
+    {
+        asset_loader_JPG jpg_loader;
+        jpg_loader.load(path);
+        _dependencies->set_dependencies(path, {});
+        std::unique_lock lock { _assets_mutex };
+        _image_paths.try_emplace(filename, path);
+        _images.try_emplace(filename, jpg_loader.get_image());
+        return {};
+    }
+#endif
+#ifdef GAMIFY_SUPPORTS_PNG
+    if (extension == ".png")
+    {
+        asset_loader_PNG png_loader;
+        png_loader.load(path);
+        _dependencies->set_dependencies(path, {});
+        std::unique_lock lock { _assets_mutex };
+        _image_paths.try_emplace(filename, path);
+        _images.try_emplace(filename, png_loader.get_image());
+        return {};
+    }
+#endif
+
+    // the shaders and the materials need the context all the way, the
+    // shaders are compiled in the background by the driver anyway
+    return [ this, path ] { load_asset(path); };
+}
+
+void asset_manager::reload_changed_assets()
+{
+    std::vector<std::string> files;
+    {
+        std::unique_lock lock { _changes_mutex };
+        auto now = std::chrono::steady_clock::now();
+        std::erase_if(_changed_files,
+                      [ & ](const auto& change)
+        {
+            if (now - change.second < reload_settle_time)
+            {
+                return false;
+            }
+
+            files.push_back(change.first);
+            return true;
+        });
+    }
+
+    // the assets affected by several of the files are reloaded once
+    std::set<std::string> reloaded;
+    for (const auto& changed : files)
+    {
+        for (const auto& asset : _dependencies->get_affected(changed))
+        {
+            if (reloaded.insert(asset).second)
+            {
+                log()->info("Reloading {}", asset);
+                reload_asset(asset);
+            }
+        }
+    }
+}
+
+void asset_manager::reload_asset(const std::string& path)
+{
+    auto [ _, filename, extension ] = file::parse_path(path);
+#ifdef GAMIFY_SUPPORTS_SHADER
+    if (extension == ".shader")
+    {
+        shader_program* existing = get_shader(filename);
+        if (!existing)
+        {
+            return;
+        }
+
+        asset_loader_SHADER shader_loader;
+        shader_loader.load(path);
+        std::unique_ptr<shader_program> fresh {
+            shader_loader.get_shader_program()
+        };
+        fresh->set_name(filename);
+        _dependencies->set_dependencies(path,
+                                        shader_loader.get_dependencies());
+        // the previous program is used until the driver links the new one
+        _reloading_programs.emplace_back(existing, std::move(fresh));
+        return;
+    }
+#endif
+#ifdef GAMIFY_SUPPORTS_MAT
+    if (extension == ".mat")
+    {
+        material* existing = get_material(filename);
+        if (!existing)
+        {
+            return;
+        }
+
+        // a half edited material file is nothing to crash on
+        asset_loader_MAT mat_loader;
+        try
+        {
+            mat_loader.load(path);
+        }
+        catch (const std::exception& e)
+        {
+            log()->error(
+                "Failed to reload the material {}: {}", path, e.what());
+            return;
+        }
+
+        std::unique_ptr<material> fresh { mat_loader.get_material() };
+        if (!fresh)
+        {
+            log()->error("Failed to reload the material {}", path);
+            return;
+        }
+
+        _dependencies->set_dependencies(path, mat_loader.get_dependencies());
+        existing->reload(std::move(*fresh));
+        return;
+    }
+#endif
+    if (extension == ".png" || extension == ".jpg" || extension == ".jpeg")
+    {
+        reload_image(path);
+    }
+}
+
+void asset_manager::reload_image(const std::string& path)
+{
+    {
+        std::unique_lock lock { _loads_mutex };
+        ++_pending_loads;
+    }
+
+    // decoding and cooking are the expensive parts, only the swap and the
+    // upload are left for the context thread
+    _loaders->submit(
+        [ this, path ]
+    {
+        auto [ _, filename, extension ] = file::parse_path(path);
+        bool has_image = false;
+        bool has_texture = false;
+        {
+            std::shared_lock lock { _assets_mutex };
+            has_image = _images.contains(filename);
+            has_texture = _textures.contains(filename);
+        }
+
+        // neither is created yet, they will be made from the file as it is
+        std::shared_ptr<image> fresh;
+        if (has_image || has_texture)
+        {
+            fresh.reset(decode_image(path, extension));
+        }
+
+        std::shared_ptr<texture_cache::entry> cooked;
+        if (fresh && has_texture)
+        {
+            if (auto entry = texture_cache::cook(*fresh))
+            {
+                texture_cache::store(path, *entry);
+                cooked = std::make_shared<texture_cache::entry>(
+                    std::move(*entry));
+            }
+        }
+
+        std::unique_lock lock { _loads_mutex };
+        _decoded_loads.push(
+            [ this, path, filename, fresh, cooked, has_image, has_texture ]
+        {
+            if (!fresh)
+            {
+                if (has_image || has_texture)
+                {
+                    log()->error("Failed to reload the image {}", path);
+                }
+                return;
+            }
+
+            image* existing_image = nullptr;
+            texture* existing_texture = nullptr;
+            {
+                std::shared_lock lock { _assets_mutex };
+                if (auto it = _images.find(filename); it != _images.end())
+                {
+                    existing_image = it->second;
+                }
+                if (auto it = _textures.find(filename); it != _textures.end())
+                {
+                    existing_texture = it->second;
+                }
+            }
+
+            if (existing_texture && cooked)
+            {
+                texture reloaded;
+                texture_cache::upload(*cooked, reloaded);
+                *existing_texture = std::move(reloaded);
+            }
+            else if (existing_texture)
+            {
+                *existing_texture = texture::from_image(fresh.get());
+            }
+
+            if (existing_image)
+            {
+                *existing_image = std::move(*fresh);
+            }
+        });
+        _loads_condition.notify_all();
+    });
+}
+
+void asset_manager::swap_reloaded_programs()
+{
+    std::erase_if(_reloading_programs,
+                  [](auto& reloading)
+    {
+        auto& [ existing, fresh ] = reloading;
+        if (!fresh->is_ready())
+        {
+            return false;
+        }
+
+        fresh->finish();
+        if (!fresh->linked())
+        {
+            log()->error("Failed to reload the shader {}, keeping the "
+                         "previous version",
+                         existing->get_name());
+            return true;
+        }
+
+        *existing = std::move(*fresh);
+        log()->info("Reloaded the shader {}", existing->get_name());
+        return true;
+    });
+}
+
 template <>
 void asset_manager::save_asset<image>(std::string_view path, const image* img)
 {
@@ -81,21 +566,44 @@ void asset_manager::save_asset<image>(std::string_view path, const image* img)
     {
         asset_loader_PNG png_loader;
         png_loader.set_image(const_cast<image*>(img));
+        // the saved images are mostly the frame captures, so the encoding
+        // speed is preferred over the file size
+        png_loader.set_compression_level(1);
         png_loader.save(path);
         return;
     }
 #endif
+#ifdef GAMIFY_SUPPORTS_JPG
+    if (extension == ".jpg" || extension == ".jpeg")
+    {
+        asset_loader_JPG jpg_loader;
+        jpg_loader.set_image(const_cast<image*>(img));
+        jpg_loader.save(path);
+        return;
+    }
+#endif
+    log()->warn("Saving images as {} is not supported", extension);
 }
 
 template <>
 void asset_manager::register_asset<mesh>(std::string_view name, mesh* asset)
 {
+    std::unique_lock lock { _assets_mutex };
     _meshs.emplace(std::string(name), asset);
 }
 
+template <>
+void asset_manager::register_asset<material>(std::string_view name,
+                                             material* asset)
+{
+    std::unique_lock lock { _assets_mutex };
+    _materials.emplace(std::string(name), asset);
+}
+
 const std::vector<mesh*> asset_manager::meshes() const
 {
     std::vector<mesh*> result;
+    std::shared_lock lock { _assets_mutex };
     for (auto& [ _, value ] : _meshs)
     {
         result.push_back(value);
@@ -106,6 +614,7 @@ const std::vector<mesh*> asset_manager::meshes() const
 const std::vector<material*> asset_manager::materials() const
 {
     std::vector<material*> result;
+    std::shared_lock lock { _assets_mutex };
     for (auto& [ _, value ] : _materials)
     {
         result.push_back(value);
@@ -116,6 +625,7 @@ const std::vector<material*> asset_manager::materials() const
 const std::vector<image*> asset_manager::textures() const
 {
     std::vector<image*> result;
+    std::shared_lock lock { _assets_mutex };
     for (auto& [ _, value ] : _images)
     {
         result.push_back(value);
@@ -126,6 +636,7 @@ const std::vector<image*> asset_manager::textures() const
 const std::vector<shader_program*> asset_manager::shaders() const
 {
     std::vector<shader_program*> result;
+    std::shared_lock lock { _assets_mutex };
     for (auto& [ _, value ] : _shader_programs)
     {
         result.push_back(value);
@@ -135,22 +646,99 @@ const std::vector<shader_program*> asset_manager::shaders() const
 
 shader_program* asset_manager::get_shader(std::string_view name) const
 {
+    std::shared_lock lock { _assets_mutex };
     return _shader_programs.contains(name) ? _shader_programs.find(name)->second
                                            : nullptr;
 }
 
 material* asset_manager::get_material(std::string_view name) const
 {
+    std::shared_lock lock { _assets_mutex };
     return _materials.contains(name) ? _materials.find(name)->second : nullptr;
 }
 
-image* asset_manager::get_image(std::string_view name) const
+image* asset_manager::get_image(std::string_view name)
 {
+    std::string path;
+    {
+        std::shared_lock lock { _assets_mutex };
+        if (auto it = _images.find(name); it != _images.end())
+        {
+            return it->second;
+        }
+
+        auto it = _image_paths.find(name);
+        if (it == _image_paths.end())
+        {
+            return nullptr;
+        }
+        path = it->second;
+    }
+
+    // the decoding was skipped in favor of the cooked texture
+    load_asset(path);
+    std::shared_lock lock { _assets_mutex };
     return _images.contains(name) ? _images.find(name)->second : nullptr;
 }
 
+texture* asset_manager::get_texture(std::string_view name)
+{
+    std::string path;
+    {
+        std::shared_lock lock { _assets_mutex };
+        if (auto it = _textures.find(name); it != _textures.end())
+        {
+            return it->second;
+        }
+
+        if (auto it = _image_paths.find(name); it != _image_paths.end())
+        {
+            path = it->second;
+        }
+    }
+
+    if (path.empty())
+    {
+        log()->error("Image {} is not loaded", name);
+        return nullptr;
+    }
+
+    auto txt = new texture;
+    if (auto cooked = texture_cache::load(path))
+    {
+        texture_cache::upload(*cooked, *txt);
+    }
+    else if (image* img = get_image(name))
+    {
+        if (auto cooked = texture_cache::cook(*img))
+        {
+            texture_cache::store(path, *cooked);
+            texture_cache::upload(*cooked, *txt);
+        }
+        else
+        {
+            log()->warn("Image {} can't be compressed, uploading as is", name);
+            *txt = texture::from_image(img);
+        }
+    }
+    else
+    {
+        delete txt;
+        return nullptr;
+    }
+
+    std::unique_lock lock { _assets_mutex };
+    auto [ it, success ] = _textures.try_emplace(std::string(name), txt);
+    if (!success)
+    {
+        delete txt;
+    }
+    return it->second;
+}
+
 mesh* asset_manager::get_mesh(std::string_view name) const
 {
+    std::shared_lock lock { _assets_mutex };
     return _meshs.contains(name) ? _meshs.find(name)->second : nullptr;
 }
 
@@ -159,7 +747,13 @@ mesh* asset_manager::get_mesh(std::string_view name) const
     bool asset_manager::for_each<type>(                                       \
         std::function<bool(std::string_view, const type* const&)> func) const \
     {                                                                         \
-        for (const auto& [ name, value ] : _##type##s)                        \
+        std::vector<std::pair<std::string, type*>> entries;                   \
+        {                                                                     \
+            /* copied, so the callback may look up the other assets */        \
+            std::shared_lock lock { _assets_mutex };                          \
+            entries.assign(_##type##s.begin(), _##type##s.end());             \
+        }                                                                     \
+        for (const auto& [ name, value ] : entries)                           \
         {                                                                     \
             if (func(name, value))                                            \
             {                                                                 \
@@ -187,8 +781,12 @@ asset_manager* asset_manager::default_asset_manager()
 void asset_manager::initialize()
 {
     _instance = new asset_manager;
+    _instance->_uploader = std::make_unique<texture_uploader>();
     initialize_quad_mesh();
+    initialize_placeholder_shader();
     initialize_surface_shader();
+    initialize_post_process_shaders();
+    initialize_picking_shader();
 }
 
 void asset_manager::initialize_quad_mesh()
@@ -217,6 +815,24 @@ void asset_manager::initialize_surface_shader()
     _instance->load_asset("resources/standard/surface.shader");
 }
 
+void asset_manager::initialize_post_process_shaders()
+{
+    _instance->load_asset("resources/standard/fxaa.shader");
+}
+
+void asset_manager::initialize_picking_shader()
+{
+    _instance->load_asset("resources/standard/object_indexing.shader");
+}
+
+void asset_manager::initialize_placeholder_shader()
+{
+    _instance->load_asset("resources/standard/placeholder.shader");
+    // the placeholder stands in for the programs still being compiled, so it
+    // must be usable right away
+    _instance->get_shader("placeholder")->finish();
+}
+
 std::string_view asset_manager::internal_resource_path() { return ""; }
 
 asset_manager* asset_manager::_instance = nullptr;
@@ -1,19 +1,100 @@
 #pragma once
 
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+
+#include "file.hpp"
 #include "utils.hpp"
 
+class asset_dependencies;
 class mesh;
 class material;
 class image;
 class shader_program;
+class texture;
+class texture_uploader;
+class worker_pool;
 
 class asset_manager
 {
+public:
+    using load_callback = std::function<void(std::string_view path)>;
+
 private:
-    asset_manager() = default;
+    asset_manager();
 
 public:
+    ~asset_manager();
+
     void load_asset(std::string_view path);
+
+    /**
+     * @brief Load the asset in the background
+     *
+     * Reading and decoding run on the loader threads. The parts requiring the
+     * GL context (uploads, shader compiling, creating the objects) are queued
+     * for @ref process_loaded_assets. The lookups may be used concurrently
+     * with the loading.
+     *
+     * @param path the path of the asset
+     * @param on_loaded called on the thread processing the loaded assets,
+     * once the asset is registered
+     * @return std::shared_future<void> ready once the asset is registered. It
+     * becomes ready only through @ref process_loaded_assets, so it must not
+     * be waited for on the thread calling it, use @ref wait_for_loads instead
+     */
+    std::shared_future<void> load_asset_async(std::string_view path,
+                                              load_callback on_loaded = {});
+
+    /**
+     * @brief Finish the background loads decoded so far
+     *
+     * Creates the objects of the loaded assets, calls the load callbacks,
+     * swaps in the reloaded assets and issues the streamed texture uploads.
+     * Must be called on the thread owning the GL context, while nothing
+     * updates or renders the scene, e.g. between the frames.
+     */
+    void process_loaded_assets();
+
+    /**
+     * @brief Issue the streamed texture uploads
+     *
+     * The only part of the processing that may run while the game updates
+     * the scene. Must be called on the thread owning the GL context.
+     */
+    void process_uploads();
+
+    /**
+     * @brief Check whether @ref process_loaded_assets has anything to do
+     */
+    bool has_loaded_assets() const;
+
+    /**
+     * @brief Finish all the pending background loads
+     *
+     * Returns once the texture uploads of the loads have completed too. Must
+     * be called on the thread owning the GL context.
+     */
+    void wait_for_loads();
+
+    /**
+     * @brief Reload the assets of the directory once their files change
+     *
+     * Only the shaders, the materials and the images built from the changed
+     * files are reloaded, in the order of their dependencies. The images are
+     * decoded and cooked on the loader threads, the shaders are swapped in
+     * once the driver has linked them. The reloaded assets are moved into the
+     * existing objects by @ref process_loaded_assets, between the frames, so
+     * the pointers handed out stay valid. A failed reload keeps the previous
+     * version. The subdirectories are watched too, those existing at the
+     * time of the call.
+     *
+     * @param root the directory to watch
+     */
+    void watch_assets(std::string_view root);
+
     template <typename T>
     void save_asset(std::string_view path, const T* asset);
 
@@ -28,7 +109,23 @@ public:
     mesh* get_mesh(std::string_view name) const;
     shader_program* get_shader(std::string_view name) const;
     material* get_material(std::string_view name) const;
-    image* get_image(std::string_view name) const;
+
+    /**
+     * @brief Get the loaded image
+     *
+     * The images having an up to date cooked texture are decoded on the
+     * first request only.
+     */
+    image* get_image(std::string_view name);
+
+    /**
+     * @brief Get the texture of the loaded image
+     *
+     * The cooked form of the image is preferred. If it is missing or out of
+     * date the image is cooked and the result is stored for the next runs.
+     * Must be called on the thread owning the GL context.
+     */
+    texture* get_texture(std::string_view name);
 
     template <typename T>
     bool for_each(std::function<bool(std::string_view, const T* const&)>) const;
@@ -39,8 +136,24 @@ public:
 private:
     static void initialize_quad_mesh();
     static void initialize_surface_shader();
+    static void initialize_post_process_shaders();
+    static void initialize_picking_shader();
+    static void initialize_placeholder_shader();
     static std::string_view internal_resource_path();
 
+    /**
+     * @brief Decode the asset on the calling loader thread
+     *
+     * @return std::function<void()> the part of the loading that must run on
+     * the thread owning the GL context, empty if nothing is left
+     */
+    std::function<void()> decode_asset(const std::string& path);
+
+    void reload_changed_assets();
+    void reload_asset(const std::string& path);
+    void reload_image(const std::string& path);
+    void swap_reloaded_programs();
+
 private:
     template <typename T>
     using asset_map =
@@ -50,5 +163,31 @@ private:
     asset_map<material*> _materials;
     asset_map<image*> _images;
     asset_map<shader_program*> _shader_programs;
+    asset_map<texture*> _textures;
+    // the source paths of the images, for the lazy decoding and the cooking
+    asset_map<std::string> _image_paths;
+    // guards the maps above against the loader threads
+    mutable std::shared_mutex _assets_mutex;
+
+    std::unique_ptr<texture_uploader> _uploader;
+    mutable std::mutex _loads_mutex;
+    std::condition_variable _loads_condition;
+    std::queue<std::function<void()>> _decoded_loads;
+    size_t _pending_loads { 0 };
+
+    std::unique_ptr<asset_dependencies> _dependencies;
+    mutable std::mutex _changes_mutex;
+    // the changed files with the time of their last change
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+        _changed_files;
+    // the reloaded programs waiting for the driver to link them
+    std::vector<std::pair<shader_program*, std::unique_ptr<shader_program>>>
+        _reloading_programs;
+    // destroyed before the members its queued jobs use, the pool finishes
+    // the jobs on the destruction
+    std::unique_ptr<worker_pool> _loaders;
+    // the last ones, so they're stopped before the rest is destroyed
+    std::vector<std::unique_ptr<file::file_watch_hook>> _watches;
+
     static asset_manager* _instance;
 };
@@ -6,9 +6,11 @@
 #include "game_object.hpp"
 #include "gizmo_drawer.hpp"
 #include "light.hpp"
+#include "light_clusters.hpp"
 #include "logging.hpp"
 #include "material.hpp"
 #include "mesh.hpp"
+#include "renderer/renderer_3d.hpp"
 #include "scene.hpp"
 #include "shader.hpp"
 #include "texture.hpp"
@@ -16,21 +18,24 @@
 namespace
 {
 static logger log() { return get_logger("camera"); }
+
+std::atomic_uint32_t next_camera_id { 1 };
 } // namespace
 
 camera::camera()
+    : _id(next_camera_id++)
 {
     _cameras.push_back(this);
 
-    _framebuffer = std::make_unique<framebuffer>();
-    _framebuffer->set_samples(32);
-    _framebuffer->resize(_render_size);
-    _framebuffer->initialize();
+    _light_clusters = std::make_unique<light_clusters>();
+    _picker = std::make_unique<object_picker>();
     set_background(glm::vec3 { 0.0f, 0.0f, 0.0f });
 }
 
 camera::~camera() { std::erase(_cameras, this); }
 
+uint32_t camera::get_id() const { return _id; }
+
 void camera::set_fov(float fov) { _fov = fov; }
 
 float camera::get_fov() const { return _fov; }
@@ -64,7 +69,30 @@ void camera::set_render_size(glm::uvec2 size)
     }
 
     _render_size = new_size;
-    _framebuffer->resize(_render_size);
+}
+
+glm::uvec2 camera::get_render_size() const { return _render_size; }
+
+glm::uvec2 camera::get_frame_render_size() const { return _frame_render_size; }
+
+glm::uvec2 camera::get_frame_size() const { return _frame_size; }
+
+void camera::set_dynamic_resolution(bool flag)
+{
+    if (_dynamic_resolution == flag)
+    {
+        return;
+    }
+
+    _dynamic_resolution = flag;
+    _resolution_scaler.reset();
+}
+
+bool camera::get_dynamic_resolution() const { return _dynamic_resolution; }
+
+resolution_scaler& camera::get_resolution_scaler()
+{
+    return _resolution_scaler;
 }
 
 void camera::set_render_texture(std::weak_ptr<texture> render_texture)
@@ -77,6 +105,15 @@ std::shared_ptr<texture> camera::get_render_texture() const
     return _user_render_texture.lock();
 }
 
+void camera::set_anti_aliasing(anti_aliasing mode) { _anti_aliasing = mode; }
+
+camera::anti_aliasing camera::get_anti_aliasing() const
+{
+    return _anti_aliasing;
+}
+
+object_picker& camera::get_picker() { return *_picker; }
+
 void camera::set_gizmos_enabled(bool flag) { _gizmos_enabled = flag; }
 
 bool camera::get_gizmos_enabled() const { return _gizmos_enabled; }
@@ -98,33 +135,175 @@ void camera::set_background(image* img)
 
 void camera::render()
 {
-    auto* old_active_camera = set_active();
+    frame_graph graph;
+    add_passes(graph);
+    graph.execute();
+}
+
+frame_graph::resource camera::add_passes(frame_graph& graph)
+{
+    // without a packet provided by the caller the state is captured right
+    // away, which is safe as long as the game runs on the same thread
+    std::shared_ptr<const frame_packet> packet = frame_packet::current();
+    if (!packet)
+    {
+        packet = frame_packet::extract(scene::get_active_scene());
+    }
 
-    setup_lights();
-    render_on_private_texture();
+    std::optional<size_t> view = packet->find_camera(this);
+    _frame_transform =
+        view ? packet->cameras[ *view ].camera_transform : _transformation;
+    _frame_render_size =
+        view ? packet->cameras[ *view ].render_size : _render_size;
+
+    _frame_size = _frame_render_size;
+    if (_dynamic_resolution)
+    {
+        _resolution_scaler.update();
+        _frame_size = glm::max(
+            glm::uvec2 { 1, 1 },
+            glm::uvec2 { glm::vec2 { _frame_render_size } *
+                         _resolution_scaler.get_scale() });
+    }
+
+    const unsigned samples = get_samples();
+    const bool fxaa = _anti_aliasing == anti_aliasing::fxaa;
+    // multisampled frames can't be stretched directly, so those are resolved
+    // before the presentation
+    const bool resolve = !fxaa && _dynamic_resolution && samples > 1;
+
+    // the frame gets the object id attachment only while picks are queued
+    const bool object_ids = _picker->has_requests();
+
+    frame_graph::resource frame;
+    graph.add_pass(
+        "scene",
+        [ & ](frame_graph::builder& builder)
+        {
+            frame = builder.write(builder.create(
+                "frame", { _frame_render_size, samples, object_ids }));
+            return [ this, frame, packet, view ](
+                       const frame_graph::context& ctx)
+            {
+                if (_dynamic_resolution)
+                {
+                    _resolution_scaler.begin_frame();
+                }
+
+                auto* old_active_camera = set_active();
+                glViewport(0, 0, _frame_size.x, _frame_size.y);
+                setup_lights(*packet);
+                render_scene(ctx.get(frame), *packet, view);
+                if (old_active_camera)
+                {
+                    old_active_camera->set_active();
+                }
+            };
+        });
+
+    if (_picker->has_work())
+    {
+        // the ids are read right after the scene pass wrote them
+        graph.add_pass("picking",
+                       [ & ](frame_graph::builder& builder)
+                       {
+                           builder.read(frame);
+                           frame = builder.write(frame);
+                           builder.set_side_effect();
+                           return [ this, frame ](const auto& ctx)
+                           {
+                               _picker->execute(ctx.get(frame),
+                                                _frame_render_size,
+                                                _frame_size);
+                           };
+                       });
+    }
 
-    _framebuffer->bind();
     if (_background_texture)
     {
-        render_texture_background();
+        graph.add_pass("background",
+                       [ & ](frame_graph::builder& builder)
+                       {
+                           builder.read(frame);
+                           frame = builder.write(frame);
+                           return [ this, frame ](const auto& ctx)
+                           { render_texture_background(ctx.get(frame)); };
+                       });
     }
 
     if (get_gizmos_enabled())
     {
-        render_gizmos();
+        graph.add_pass("gizmos",
+                       [ & ](frame_graph::builder& builder)
+                       {
+                           builder.read(frame);
+                           frame = builder.write(frame);
+                           return [ this, frame, packet ](const auto& ctx)
+                           {
+                               auto* old_active_camera = set_active();
+                               render_gizmos(ctx.get(frame), *packet);
+                               if (old_active_camera)
+                               {
+                                   old_active_camera->set_active();
+                               }
+                           };
+                       });
     }
 
-    _framebuffer->unbind();
+    if (fxaa || resolve)
+    {
+        graph.add_pass(
+            fxaa ? "fxaa" : "resolve",
+            [ & ](frame_graph::builder& builder)
+            {
+                frame_graph::resource source = frame;
+                builder.read(source);
+                frame = builder.write(
+                    builder.create("post_frame", { _frame_render_size, 1 }));
+                return [ this, source, target = frame, fxaa ](
+                           const frame_graph::context& ctx)
+                {
+                    if (fxaa)
+                    {
+                        apply_fxaa(ctx.get(source), ctx.get(target));
+                        return;
+                    }
+
+                    ctx.get(source)->blit(
+                        ctx.get(target), _frame_size, { 0, 0 }, _frame_size);
+                };
+            });
+    }
 
-    if (auto urt = _user_render_texture.lock())
+    if (_dynamic_resolution)
     {
-        _framebuffer->copy_texture(urt.get());
+        // closes the timing of the passes above
+        graph.add_pass("frame_timing",
+                       [ & ](frame_graph::builder& builder)
+                       {
+                           builder.read(frame);
+                           frame = builder.write(frame);
+                           return [ this ](const auto& ctx)
+                           { _resolution_scaler.end_frame(); };
+                       });
     }
 
-    if (old_active_camera)
+    if (auto urt = _user_render_texture.lock())
     {
-        old_active_camera->set_active();
+        graph.add_pass("render_texture",
+                       [ & ](frame_graph::builder& builder)
+                       {
+                           builder.read(frame);
+                           builder.set_side_effect();
+                           return [ this, frame, urt ](const auto& ctx)
+                           {
+                               ctx.get(frame)->copy_texture(urt.get(),
+                                                            _frame_size);
+                           };
+                       });
     }
+
+    return frame;
 }
 
 glm::mat4 camera::vp_matrix() const
@@ -133,45 +312,80 @@ glm::mat4 camera::vp_matrix() const
 }
 
 glm::mat4 camera::view_matrix() const
+{
+    return calculate_view_matrix(get_transform());
+}
+
+glm::mat4 camera::projection_matrix() const
+{
+    return calculate_projection_matrix(get_transform(), _render_size);
+}
+
+const transform& camera::get_frame_transform() const
+{
+    return _frame_transform;
+}
+
+glm::mat4 camera::frame_projection_matrix() const
+{
+    return calculate_projection_matrix(_frame_transform, _frame_render_size);
+}
+
+glm::mat4 camera::frame_view_matrix() const
+{
+    return calculate_view_matrix(_frame_transform);
+}
+
+glm::mat4 camera::frame_vp_matrix() const
+{
+    return frame_projection_matrix() * frame_view_matrix();
+}
+
+glm::mat4 camera::calculate_view_matrix(const transform& view) const
 {
     // TODO: optimize with caching
-    glm::quat rotation = get_transform().get_rotation();
+    glm::quat rotation = view.get_rotation();
     glm::vec3 cam_right = rotation * glm::vec3 { 1, 0, 0 };
     glm::vec3 cam_up = rotation * glm::vec3 { 0, 1, 0 };
     glm::vec3 cam_forward = rotation * glm::vec3 { 0, 0, 1 };
 
     glm::mat3 view3(cam_right, cam_up, cam_forward);
-    glm::mat4 view = view3;
-    view = glm::inverse(glm::translate(glm::identity<glm::mat4>(),
-                                       get_transform().get_position()) *
-                        view);
+    glm::mat4 result = view3;
+    result = glm::inverse(
+        glm::translate(glm::identity<glm::mat4>(), view.get_position()) *
+        result);
 
-    return view;
+    return result;
 }
 
-glm::mat4 camera::projection_matrix() const
+glm::mat4 camera::calculate_projection_matrix(const transform& view,
+                                              glm::uvec2 render_size) const
 {
     // TODO: optimize with caching
     // copy into floating point vec2
-    glm::vec2 size = _render_size;
+    glm::vec2 size = render_size;
     if (_ortho_flag)
     {
-        glm::quat rotation = get_transform().get_rotation();
+        glm::quat rotation = view.get_rotation();
         glm::vec3 direction = rotation * glm::vec3 { 0, 0, 1 };
-        float dist =
-            std::abs(glm::dot(direction, get_transform().get_position()));
+        float dist = std::abs(glm::dot(direction, view.get_position()));
 
         return glm::ortho(-size.x / dist,
                           size.x / dist,
                           -size.y / dist,
                           size.y / dist,
-                          0.01f,
-                          10000.0f);
+                          get_near_plane(),
+                          get_far_plane());
     }
 
-    return glm::perspective(_fov, size.x / size.y, 0.1f, 10000.0f);
+    return glm::perspective(
+        _fov, size.x / size.y, get_near_plane(), get_far_plane());
 }
 
+float camera::get_near_plane() const { return _ortho_flag ? 0.01f : 0.1f; }
+
+float camera::get_far_plane() const { return 10000.0f; }
+
 transform& camera::get_transform() { return _transformation; }
 
 const transform& camera::get_transform() const { return _transformation; }
@@ -180,9 +394,11 @@ camera* camera::active_camera() { return camera::_active_camera; }
 
 const std::vector<camera*>& camera::all_cameras() { return camera::_cameras; }
 
-void camera::render_on_private_texture() const
+void camera::render_scene(framebuffer* target,
+                          const frame_packet& packet,
+                          std::optional<size_t> view) const
 {
-    _framebuffer->bind();
+    target->bind();
     // TODO?: maybe better to clear with the specified background color instead
     // of drawing background quad with that color
     glClearColor(
@@ -190,58 +406,90 @@ void camera::render_on_private_texture() const
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glEnable(GL_DEPTH_TEST);
 
-    if (scene::get_active_scene())
+    // only the scene draws write the ids, so the background and the gizmos
+    // keep the cleared 0
+    target->clear_object_ids();
+    target->write_object_ids(true);
+
+    auto draw = [ &packet, view ](const frame_packet::renderable& renderable)
+    {
+        const auto& mat = packet.materials[ renderable.material_index ];
+        if (const auto* d =
+                std::get_if<frame_packet::mesh_draw>(&renderable.draw))
+        {
+            // the cameras missing from the packet draw the full detail
+            size_t lod = view ? packet.lod_levels[ d->first_lod + *view ] : 0;
+            renderer_3d().draw_mesh(d->geometry->get_lod(lod),
+                                    mat,
+                                    renderable.model_matrix,
+                                    renderable.object_id);
+        }
+        else if (const auto* d =
+                     std::get_if<frame_packet::text_draw>(&renderable.draw))
+        {
+            renderer_3d().draw_text(*d->text_font,
+                                    d->text,
+                                    mat,
+                                    renderable.model_matrix,
+                                    renderable.object_id);
+        }
+    };
+
+    if (view)
+    {
+        // culled and sorted together with the other cameras of the frame
+        const auto& lists = packet.get_visibility().get_draw_lists(*view);
+        for (uint32_t index : lists.opaque)
+        {
+            draw(packet.renderables[ index ]);
+        }
+        for (uint32_t index : lists.transparent)
+        {
+            draw(packet.renderables[ index ]);
+        }
+    }
+    else
     {
-        for (auto* obj : scene::get_active_scene()->objects())
+        for (const auto& renderable : packet.renderables)
         {
-            if (!obj->is_active())
+            if (!renderable.transparent)
             {
-                continue;
+                draw(renderable);
             }
-            if (auto* renderer = obj->get_component<renderer_component>();
-                renderer)
+        }
+        for (const auto& renderable : packet.renderables)
+        {
+            if (renderable.transparent)
             {
-                renderer->get_material()->set_property_value(
-                    "u_model_matrix", obj->get_transform().get_matrix());
-                renderer->render();
+                draw(renderable);
             }
         }
     }
-    _framebuffer->unbind();
+    target->write_object_ids(false);
+    target->unbind();
 }
 
-void camera::render_gizmos() const
+void camera::render_gizmos(framebuffer* target,
+                           const frame_packet& packet) const
 {
-    _framebuffer->bind();
+    target->bind();
     glEnable(GL_BLEND);
-    if (scene::get_active_scene())
-    {
-        for (auto* obj : scene::get_active_scene()->objects())
-        {
-            if (!obj->is_active())
-            {
-                continue;
-            }
-            gizmo_drawer::instance()->get_shader().set_uniform(
-                "u_model_matrix", obj->get_transform().get_matrix());
-            gizmo_drawer::instance()->get_shader().set_uniform("u_vp_matrix",
-                                                               vp_matrix());
-            obj->draw_gizmos();
-        }
-    }
+    gizmo_drawer::instance()->draw_recorded(packet.gizmos, frame_vp_matrix());
     glDisable(GL_BLEND);
-    _framebuffer->unbind();
+    target->unbind();
 }
 
-void camera::render_texture_background()
+void camera::render_texture_background(framebuffer* target)
 {
+    target->bind();
     auto background_shader =
         asset_manager::default_asset_manager()->get_shader("camera_background");
         _background_texture->set_active_texture(0);
     background_shader->set_uniform("u_environment_map", 0);
-    background_shader->set_uniform("u_camera_matrix",
-                                   glm::toMat4(get_transform().get_rotation()) *
-                                       glm::inverse(projection_matrix()));
+    background_shader->set_uniform(
+        "u_camera_matrix",
+        glm::toMat4(_frame_transform.get_rotation()) *
+            glm::inverse(frame_projection_matrix()));
     if (_background_texture)
     {
         _background_texture->set_active_texture(0);
@@ -251,46 +499,80 @@ void camera::render_texture_background()
     mesh* quad_mesh = asset_manager::default_asset_manager()->get_mesh("quad");
     quad_mesh->render();
     shader_program::unuse();
+    target->unbind();
 }
 
-void camera::setup_lights()
+void camera::setup_lights(const frame_packet& packet)
 {
-    const auto& lights = light::get_all_lights();
-    struct glsl_lights_t
+    auto* active_scene = scene::get_active_scene();
+    if (!active_scene)
     {
-        glm::vec3 position;
-        float intensity;
-        glm::vec3 direction;
-        float radius;
-        glm::vec3 color;
-        uint32_t type;
-    };
+        return;
+    }
+
+    // the lights are shared by all the cameras, only the changes since the
+    // last sync are uploaded
+    light_registry& registry = active_scene->get_light_registry();
+    registry.sync(packet.lights);
+    registry.bind();
 
-    std::vector<glsl_lights_t> glsl_lights;
-    glsl_lights.resize(lights.size());
-    size_t i = 0;
+    _light_clusters->build(*this, packet.lights);
+    _light_clusters->bind();
+}
 
-    auto size_calculated = sizeof(glsl_lights_t);
-    auto size_1 = (4 * 3 * sizeof(float)) * glsl_lights.size();
+void camera::apply_fxaa(framebuffer* source, framebuffer* target) const
+{
+    auto* fxaa_shader =
+        asset_manager::default_asset_manager()->get_shader("fxaa");
+    if (!fxaa_shader)
+    {
+        log()->warn("FXAA shader is not available");
+        return;
+    }
 
-    for (const auto& light : lights)
+    target->bind();
+    glDisable(GL_DEPTH_TEST);
+    fxaa_shader->set_uniform("u_image", 0);
+    fxaa_shader->set_uniform("u_texel_size",
+                             1.0f / glm::vec2 { _frame_render_size });
+    fxaa_shader->set_uniform("u_uv_scale",
+                             glm::vec2 { _frame_size } /
+                                 glm::vec2 { _frame_render_size });
+    source->color_texture()->set_active_texture(0);
+    fxaa_shader->use();
+    asset_manager::default_asset_manager()->get_mesh("quad")->render();
+    shader_program::unuse();
+    glEnable(GL_DEPTH_TEST);
+    target->unbind();
+}
+
+unsigned camera::get_samples() const
+{
+    unsigned samples = 1;
+    switch (_anti_aliasing)
     {
-        glsl_lights[ i ].position = light->get_transform().get_position();
-        glsl_lights[ i ].direction = glm::normalize(
-            light->get_transform().get_rotation() * glm::vec3 { 0, 0, 1 });
-        glsl_lights[ i ].color = light->get_color();
-        glsl_lights[ i ].intensity = light->get_intensity();
-        glsl_lights[ i ].radius = light->get_radius();
-        glsl_lights[ i ].type = static_cast<uint32_t>(light->get_type());
-        ++i;
+    case anti_aliasing::msaa_2x: samples = 2; break;
+    case anti_aliasing::msaa_4x: samples = 4; break;
+    case anti_aliasing::msaa_8x: samples = 8; break;
+    case anti_aliasing::none:
+    case anti_aliasing::fxaa: break;
     }
+    return std::min(samples, max_samples());
+}
 
-    _lights_buffer.set_element_stride(4 * 3 * sizeof(float));
-    _lights_buffer.set_element_count(glsl_lights.size());
-    _lights_buffer.set_usage_type(graphics_buffer::usage_type::dynamic_copy);
-    _lights_buffer.set_data(glsl_lights.data());
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _lights_buffer.get_handle());
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _lights_buffer.get_handle());
+unsigned camera::max_samples()
+{
+    static unsigned samples = []
+    {
+        // the targets are multisampled textures, not renderbuffers, so the
+        // texture limits of both of the attachments apply
+        int color = 1;
+        int depth = 1;
+        glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &color);
+        glGetIntegerv(GL_MAX_DEPTH_TEXTURE_SAMPLES, &depth);
+        return static_cast<unsigned>(std::max(std::min(color, depth), 1));
+    }();
+    return samples;
 }
 
 camera* camera::_active_camera = nullptr;
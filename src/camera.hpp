@@ -1,9 +1,14 @@
 #pragma once
 
+#include "frame_packet.hpp"
 #include "graphics_buffer.hpp"
+#include "object_picker.hpp"
+#include "renderer/frame_graph.hpp"
+#include "resolution_scaler.hpp"
 #include "transform.hpp"
 
 class framebuffer;
+class light_clusters;
 class image;
 class texture;
 class mesh;
@@ -11,10 +16,26 @@ class shader_program;
 
 class camera
 {
+public:
+    enum class anti_aliasing
+    {
+        none,
+        msaa_2x,
+        msaa_4x,
+        msaa_8x,
+        // post-process pass over the single sampled frame
+        fxaa,
+    };
+
 public:
     camera();
     ~camera();
 
+    /**
+     * @brief The unique id of the camera, never reused by another one
+     */
+    uint32_t get_id() const;
+
     /**
      * @brief Set the field of view (horizontal) of the camera in radians
      *
@@ -31,18 +52,92 @@ public:
     void set_ortho(bool ortho_flag = true);
     float get_aspect_ratio() const;
     camera* set_active();
+    /**
+     * @brief Set the size of the frames the camera renders
+     *
+     * Must be called on the game thread, the rendering uses the size
+     * captured into the frame packet.
+     */
     void set_render_size(size_t width, size_t height);
     void set_render_size(glm::uvec2 size);
+    glm::uvec2 get_render_size() const;
+
+    /**
+     * @brief Get the render size of the current frame
+     *
+     * Captured from the frame packet in @ref add_passes, like the frame
+     * transform.
+     */
+    glm::uvec2 get_frame_render_size() const;
+
+    /**
+     * @brief Get the size of the region the frame is actually rendered into
+     *
+     * Equals the render size unless the dynamic resolution is enabled, in
+     * which case the frame occupies the scaled bottom-left region of the
+     * render targets and is stretched over the whole size on presentation.
+     */
+    glm::uvec2 get_frame_size() const;
+
+    /**
+     * @brief Scale the rendered region to fit the GPU time budget
+     *
+     * The budget and the scale limits are configured through @ref
+     * get_resolution_scaler. The render targets keep their size, so the
+     * scale changes never reallocate them.
+     *
+     * @param flag whether the dynamic resolution is enabled
+     */
+    void set_dynamic_resolution(bool flag = true);
+    bool get_dynamic_resolution() const;
+    resolution_scaler& get_resolution_scaler();
     void set_render_texture(std::weak_ptr<texture> render_texture);
     std::shared_ptr<texture> get_render_texture() const;
+
+    /**
+     * @brief Set the anti-aliasing method of the camera
+     *
+     * The MSAA sample count is clamped to the maximum supported by the
+     * device.
+     *
+     * @param mode the anti-aliasing method
+     */
+    void set_anti_aliasing(anti_aliasing mode);
+    anti_aliasing get_anti_aliasing() const;
+
+    /**
+     * @brief Get the picker of the objects rendered by the camera
+     *
+     * The picking positions are in the pixels of the render size with the
+     * origin at the bottom-left corner.
+     */
+    object_picker& get_picker();
+
     void set_gizmos_enabled(bool flag = true);
     bool get_gizmos_enabled() const;
 
     void set_background(glm::vec3 color);
     void set_background(image* img);
 
+    /**
+     * @brief Render the camera into its render texture
+     *
+     * Nothing is rendered when no render texture is set.
+     */
     void render();
 
+    /**
+     * @brief Declare the passes rendering the camera view
+     *
+     * The frame occupies the bottom-left region of the returned target with
+     * the size of @ref get_frame_size. When nothing consumes the frame, the
+     * passes are culled.
+     *
+     * @param graph the graph to add the passes to
+     * @return frame_graph::resource the rendered frame
+     */
+    frame_graph::resource add_passes(frame_graph& graph);
+
     transform& get_transform();
     const transform& get_transform() const;
 
@@ -53,23 +148,54 @@ public:
     glm::mat4 view_matrix() const;
     glm::mat4 vp_matrix() const;
 
+    /**
+     * @brief Get the transform the current frame is rendered with
+     *
+     * Captured from the frame packet in @ref add_passes. The rendering uses
+     * it instead of the live transform, which may be already changed by the
+     * next update.
+     */
+    const transform& get_frame_transform() const;
+    glm::mat4 frame_projection_matrix() const;
+    glm::mat4 frame_view_matrix() const;
+    glm::mat4 frame_vp_matrix() const;
+    float get_near_plane() const;
+    float get_far_plane() const;
+
 private:
-    void render_texture_background();
-    void render_on_private_texture() const;
-    void render_gizmos() const;
-    void setup_lights();
+    glm::mat4 calculate_projection_matrix(const transform& view,
+                                          glm::uvec2 render_size) const;
+    glm::mat4 calculate_view_matrix(const transform& view) const;
+    void render_texture_background(framebuffer* target);
+    void render_scene(framebuffer* target,
+                      const frame_packet& packet,
+                      std::optional<size_t> view) const;
+    void render_gizmos(framebuffer* target, const frame_packet& packet) const;
+    void setup_lights(const frame_packet& packet);
+    void apply_fxaa(framebuffer* source, framebuffer* target) const;
+    unsigned get_samples() const;
+
+    static unsigned max_samples();
 
 private:
     transform _transformation;
+    transform _frame_transform;
     glm::uvec2 _render_size { 1, 1 };
+    glm::uvec2 _frame_render_size { 1, 1 };
+    glm::uvec2 _frame_size { 1, 1 };
+    bool _dynamic_resolution = false;
+    resolution_scaler _resolution_scaler;
     float _fov = .6f;
     bool _ortho_flag = false;
     std::weak_ptr<texture> _user_render_texture {};
     glm::vec3 _background_color { 0.0f, 0.0f, 0.0f };
     std::unique_ptr<texture> _background_texture = nullptr;
-    graphics_buffer _lights_buffer { graphics_buffer::type::shader_storage };
+    std::unique_ptr<light_clusters> _light_clusters { nullptr };
+    std::unique_ptr<object_picker> _picker { nullptr };
     bool _gizmos_enabled = false;
-    std::unique_ptr<framebuffer> _framebuffer { nullptr };
+    anti_aliasing _anti_aliasing { anti_aliasing::msaa_4x };
+
+    uint32_t _id;
 
     static camera* _active_camera;
     static std::vector<camera*> _cameras;
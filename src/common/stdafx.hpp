@@ -9,6 +9,7 @@
 #include <array>
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <cstring>
 #include <filesystem>
 #include <functional>
@@ -18,6 +19,7 @@
 #include <memory>
 #include <queue>
 #include <set>
+#include <span>
 #include <sstream>
 #include <string>
 #include <string_view>
@@ -1,11 +1,37 @@
 #include "components/mesh_renderer_component.hpp"
 
-#include "camera.hpp"
 #include "components/mesh_component.hpp"
 #include "logging.hpp"
-#include "material.hpp"
 #include "mesh.hpp"
-#include "renderer/renderer_3d.hpp"
+
+namespace
+{
+// fraction of the screen height covered by the bounding sphere of the mesh
+float projected_size(const mesh::bounding_sphere& bounds,
+                     const transform& model,
+                     const frame_packet::camera_state& cam)
+{
+    glm::vec3 scale = glm::abs(model.get_scale());
+    float radius = bounds.radius * std::max({ scale.x, scale.y, scale.z });
+    const glm::mat4& projection = cam.projection_matrix;
+
+    // orthographic projection doesn't depend on the distance
+    if (projection[ 3 ][ 3 ] == 1.0f)
+    {
+        return radius * projection[ 1 ][ 1 ];
+    }
+
+    glm::vec3 center = model.get_matrix() * glm::vec4(bounds.center, 1.0f);
+    float distance =
+        glm::distance(center, cam.camera_transform.get_position());
+    if (distance <= radius)
+    {
+        return std::numeric_limits<float>::max();
+    }
+
+    return radius * projection[ 1 ][ 1 ] / distance;
+}
+} // namespace
 
 mesh_renderer_component::mesh_renderer_component(game_object* parent)
     : renderer_component(parent, class_type_id)
@@ -16,16 +42,88 @@ mesh_renderer_component::mesh_renderer_component(game_object* parent)
     }
 }
 
-void mesh_renderer_component::render()
+std::optional<mesh::bounding_sphere> mesh_renderer_component::get_bounds()
+{
+    if (auto* mc = get_component<mesh_component>(); mc && mc->get_mesh())
+    {
+        return mc->get_mesh()->get_bounds();
+    }
+
+    return std::nullopt;
+}
+
+const mesh* mesh_renderer_component::get_occluder_mesh()
+{
+    // the simplified levels may cover more than the mesh itself, so those
+    // can't be used for occluding
+    auto* mc = get_component<mesh_component>();
+    return mc ? mc->get_mesh() : nullptr;
+}
+
+std::optional<frame_packet::draw_data>
+mesh_renderer_component::capture(frame_packet& packet)
+{
+    auto* mc = get_component<mesh_component>();
+    mesh* m = mc ? mc->get_mesh() : nullptr;
+    if (!m)
+    {
+        return std::nullopt;
+    }
+
+    frame_packet::mesh_draw draw { m, packet.lod_levels.size() };
+    const transform& model = get_game_object()->get_transform();
+    for (const auto& cam : packet.cameras)
+    {
+        packet.lod_levels.push_back(select_lod(m, model, cam));
+    }
+
+    std::erase_if(_camera_lods,
+                  [ &packet ](const auto& entry)
+    {
+        return std::none_of(packet.cameras.begin(),
+                            packet.cameras.end(),
+                            [ &entry ](const frame_packet::camera_state& cam)
+        { return cam.camera_id == entry.first; });
+    });
+    return draw;
+}
+
+void mesh_renderer_component::set_lod_hysteresis(float hysteresis)
+{
+    _lod_hysteresis = std::max(hysteresis, 0.0f);
+}
+
+float mesh_renderer_component::get_lod_hysteresis() const
 {
-    if (_material)
+    return _lod_hysteresis;
+}
+
+size_t
+mesh_renderer_component::select_lod(mesh* m,
+                                    const transform& model,
+                                    const frame_packet::camera_state& cam)
+{
+    if (m->get_lod_count() == 1)
     {
-        if (get_component<mesh_component>())
-        {
-            if (auto* mesh = get_component<mesh_component>()->get_mesh())
-            {
-                renderer_3d().draw_mesh(mesh, _material);
-            }
-        }
+        return 0;
     }
+
+    float size = projected_size(m->get_bounds(), model, cam);
+    size_t& lod = _camera_lods[ cam.camera_id ];
+    lod = std::min(lod, m->get_lod_count() - 1);
+
+    // thresholds decrease with the level, so walk in one direction only
+    while (lod + 1 < m->get_lod_count() &&
+           size < m->get_lod_screen_size(lod + 1) * (1.0f - _lod_hysteresis))
+    {
+        ++lod;
+    }
+
+    while (lod > 0 &&
+           size > m->get_lod_screen_size(lod) * (1.0f + _lod_hysteresis))
+    {
+        --lod;
+    }
+
+    return lod;
 }
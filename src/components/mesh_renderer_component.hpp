@@ -3,13 +3,42 @@
 #include "components/renderer_component.hpp"
 
 class material;
+class mesh;
 
 class mesh_renderer_component : public renderer_component
 {
 public:
     mesh_renderer_component(game_object* parent);
 
-    void render() override;
+    std::optional<mesh::bounding_sphere> get_bounds() override;
+    const mesh* get_occluder_mesh() override;
+    std::optional<frame_packet::draw_data>
+    capture(frame_packet& packet) override;
+
+    /**
+     * @brief Set the relative band around the LOD switch distances
+     *
+     * The mesh switches to a coarser level only when its projected size drops
+     * below the threshold by the given fraction and back when it exceeds it
+     * by the same fraction. This avoids popping when an object hovers around
+     * a threshold.
+     *
+     * @param hysteresis fraction of the threshold, 0 disables the band
+     */
+    void set_lod_hysteresis(float hysteresis);
+    float get_lod_hysteresis() const;
 
     static constexpr std::string_view class_type_id = "mesh_renderer_component";
+
+private:
+    size_t select_lod(mesh* m,
+                      const transform& model,
+                      const frame_packet::camera_state& cam);
+
+private:
+    float _lod_hysteresis = 0.1f;
+    // the level is tracked per camera id, as the same object is viewed from
+    // different distances. The cameras missing from the last packet are
+    // dropped
+    std::unordered_map<uint32_t, size_t> _camera_lods;
 };
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <optional>
+
 #include "component.hpp"
+#include "frame_packet.hpp"
+#include "mesh.hpp"
 
 class material;
 
@@ -17,10 +21,50 @@ public:
 
     inline void set_material(material* mat) { _material = mat; }
 
-    virtual void render() = 0;
+    /**
+     * @brief Get the local space bounds of the rendered geometry
+     *
+     * Used for culling, renderers without bounds are never culled.
+     */
+    virtual std::optional<mesh::bounding_sphere> get_bounds()
+    {
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Mark the rendered geometry as an occluder
+     *
+     * Occluders are rasterized into the CPU depth buffer the rest of the
+     * renderables are tested against. Large and simple geometry, like
+     * buildings or terrain, makes the best occluders.
+     */
+    inline void set_occluder(bool flag = true) { _occluder = flag; }
+
+    inline bool is_occluder() const { return _occluder; }
+
+    /**
+     * @brief Get the geometry rasterized for the occlusion culling
+     */
+    virtual const mesh* get_occluder_mesh() { return nullptr; }
+
+    /**
+     * @brief Capture what the renderer draws into the frame packet
+     *
+     * Called on the game thread during the extraction. The rendering draws
+     * the captured data only, so it never reads the renderer while the game
+     * changes it.
+     *
+     * @param packet the packet being extracted, the cameras are captured
+     * already
+     * @return std::optional<frame_packet::draw_data> the draw, nothing if
+     * there is nothing to draw
+     */
+    virtual std::optional<frame_packet::draw_data>
+    capture(frame_packet& packet) = 0;
 
     static constexpr std::string_view class_type_id = "renderer_component";
 
 protected:
     material* _material = nullptr;
+    bool _occluder = false;
 };
@@ -6,25 +6,13 @@
 #include "asset_manager.hpp"
 #include "camera.hpp"
 #include "experimental/window.hpp"
+#include "frame_readback.hpp"
+#include "framebuffer.hpp"
 #include "image.hpp"
-#include "mesh.hpp"
-#include "shader.hpp"
+#include "image_conversion.hpp"
+#include "renderer/frame_graph.hpp"
 #include "texture.hpp"
-
-namespace
-{
-void render_quad(texture* _p)
-{
-    shader_program* quad_shader =
-        asset_manager::default_asset_manager()->get_shader("surface");
-    mesh* quad_mesh = asset_manager::default_asset_manager()->get_mesh("quad");
-    quad_shader->set_uniform("u_image", 0);
-    _p->set_active_texture(0);
-    quad_shader->use();
-    quad_mesh->render();
-    shader_program::unuse();
-}
-} // namespace
+#include "worker_pool.hpp"
 
 namespace experimental
 {
@@ -33,8 +21,11 @@ struct viewport::viewport_private
 {
     glm::vec2 _position { 0, 0 };
     glm::vec2 _size { 0, 0 };
-    std::shared_ptr<texture> _surface_texture { std::make_shared<texture>() };
     std::weak_ptr<camera> _camera {};
+    std::string _screenshot_path;
+    // created with the first screenshot
+    std::unique_ptr<worker_pool> _screenshot_encoder;
+    std::unique_ptr<frame_readback> _readback;
 };
 
 viewport::viewport() { _p = std::make_unique<viewport_private>(); }
@@ -50,12 +41,25 @@ glm::vec2 viewport::get_position() const { return _p->_position; }
 void viewport::set_size(glm::vec2 size)
 {
     _p->_size = size;
-    glm::uvec2 usize = size;
+    // set here on the game thread, the rendering uses the size captured
+    // into the frame packet
+    if (auto cam = get_camera())
+    {
+        cam->set_render_size(size);
+    }
 }
 
 glm::vec2 viewport::get_size() const { return _p->_size; }
 
-void viewport::set_camera(std::weak_ptr<camera> cam) { _p->_camera = cam; }
+void viewport::set_camera(std::weak_ptr<camera> cam)
+{
+    _p->_camera = cam;
+    if (auto c = cam.lock())
+    {
+        c->set_render_size(get_size());
+        c->set_gizmos_enabled(true);
+    }
+}
 
 std::shared_ptr<camera> viewport::get_camera() const
 {
@@ -71,22 +75,82 @@ void viewport::render()
         return;
     }
 
-    glViewport(0, 0, get_size().x, get_size().y);
-    cam->set_render_size(get_size());
-    cam->set_gizmos_enabled(true);
-    cam->set_render_texture(_p->_surface_texture);
-    cam->render();
+    frame_graph graph;
+    frame_graph::resource frame = cam->add_passes(graph);
+
+    // resolve straight into the window, no intermediate texture is involved
+    graph.add_pass("present",
+                   [ & ](frame_graph::builder& builder)
+                   {
+                       builder.read(frame);
+                       builder.set_side_effect();
+                       return [ cam, frame, position = get_position() ](
+                                  const frame_graph::context& ctx)
+                       {
+                           ctx.get(frame)->blit(nullptr,
+                                                cam->get_frame_size(),
+                                                position,
+                                                cam->get_frame_render_size());
+                       };
+                   });
+
+    if (!_p->_screenshot_path.empty())
+    {
+        if (!_p->_readback)
+        {
+            _p->_readback = std::make_unique<frame_readback>();
+            _p->_screenshot_encoder =
+                std::make_unique<worker_pool>(1, "screenshot_encoder");
+        }
+
+        graph.add_pass(
+            "screenshot",
+            [ & ](frame_graph::builder& builder)
+            {
+                builder.read(frame);
+                builder.set_side_effect();
+                return [ cam,
+                         frame,
+                         readback = _p->_readback.get(),
+                         encoder = _p->_screenshot_encoder.get(),
+                         path = std::move(_p->_screenshot_path) ](
+                           const frame_graph::context& ctx)
+                {
+                    texture surface;
+                    ctx.get(frame)->copy_texture(&surface,
+                                                 cam->get_frame_size());
+                    // the pixels arrive a few frames later, the encoding
+                    // doesn't hold the render thread either
+                    readback->read(
+                        surface,
+                        [ encoder, path ](std::unique_ptr<image> pixels)
+                    {
+                        std::shared_ptr<image> screenshot = std::move(pixels);
+                        encoder->submit(
+                            [ screenshot, path ]
+                        {
+                            flip_vertically(*screenshot);
+                            asset_manager::default_asset_manager()->save_asset(
+                                path, screenshot.get());
+                        });
+                    });
+                };
+            });
+        _p->_screenshot_path.clear();
+    }
 
+    graph.execute();
+    if (_p->_readback)
+    {
+        _p->_readback->process();
+    }
     glViewport(get_position().x, get_position().y, get_size().x, get_size().y);
-    // TODO: move to renderer
-    render_quad(_p->_surface_texture.get());
 }
 
 void viewport::take_screenshot(std::string_view path)
 {
-    auto screenshot = image::from_texture(_p->_surface_texture.get());
-    asset_manager::default_asset_manager()->save_asset(path, screenshot);
-    delete screenshot;
+    // taken from the next rendered frame
+    _p->_screenshot_path = path;
 }
 
 viewport* viewport::current_viewport() { return _current_viewport; }
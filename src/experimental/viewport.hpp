@@ -39,6 +39,12 @@ public:
     std::shared_ptr<camera> get_camera() const;
 
     void render();
+
+    /**
+     * @brief Save the next rendered frame of the viewport into the file
+     *
+     * @param path the path of the image file
+     */
     void take_screenshot(std::string_view path);
 
     static viewport* current_viewport();
@@ -82,7 +82,10 @@ void window::init()
     }
 
     glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
-    glfwWindowHint(GLFW_SAMPLES, 8);
+    // the viewports blit the camera targets into the window, a blit between
+    // multisampled framebuffers of different sample counts is invalid, so
+    // the window framebuffer stays single sampled
+    glfwWindowHint(GLFW_SAMPLES, 0);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -192,7 +195,24 @@ void window::update()
         return;
     }
 
-    if (glfwWindowShouldClose(_p->_glfw_window_handle))
+    if (should_close())
+    {
+        process_events();
+        return;
+    }
+
+    render();
+    process_events();
+}
+
+void window::process_events()
+{
+    if (_p->_glfw_window_handle == nullptr)
+    {
+        return;
+    }
+
+    if (should_close())
     {
         glfwDestroyWindow(_p->_glfw_window_handle);
         _p->_glfw_window_handle = nullptr;
@@ -207,12 +227,27 @@ void window::update()
         _p->_has_grab = false;
     }
 
+    glfwPollEvents();
+}
+
+bool window::should_close() const
+{
+    return _p->_glfw_window_handle &&
+           glfwWindowShouldClose(_p->_glfw_window_handle);
+}
+
+void window::render()
+{
+    if (_p->_glfw_window_handle == nullptr)
+    {
+        return;
+    }
+
     activate();
 
     get_events()->render(render_event(window_event::type::Render, this));
 
     glfwSwapBuffers(_p->_glfw_window_handle);
-    glfwPollEvents();
 }
 
 void window::set_as_input_source(bool flag) { _p->_is_input_source = flag; }
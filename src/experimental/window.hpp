@@ -40,8 +40,34 @@ public:
     void set_position(size_t x, size_t y);
     void move(size_t dx, size_t dy);
 
+    /**
+     * @brief Process the events and render the window
+     *
+     * Equivalent to @ref process_events followed by @ref render.
+     */
     void update();
 
+    /**
+     * @brief Handle the close request and poll the pending events
+     *
+     * Must be called on the main thread. Closing destroys the window, so no
+     * other thread may be rendering it at that moment.
+     */
+    void process_events();
+
+    /**
+     * @brief Check whether the user requested to close the window
+     */
+    bool should_close() const;
+
+    /**
+     * @brief Render the window contents and present them
+     *
+     * Makes the window context current on the calling thread, so it may be
+     * called from the render thread.
+     */
+    void render();
+
     void set_as_input_source(bool flag = true);
     bool get_is_input_source() const;
 
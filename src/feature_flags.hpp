@@ -7,7 +7,10 @@ class feature_flags
 public:
     enum class flag_name
     {
-        load_fbx_as_scene
+        load_fbx_as_scene,
+        // render the frames on a dedicated thread, overlapped with the update
+        // of the next frame
+        threaded_rendering
     };
 
 public:
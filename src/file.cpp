@@ -2,6 +2,7 @@
 #include "file.hpp"
 
 #include "FileWatch.hpp"
+#include "file_view.hpp"
 #include "logging.hpp"
 
 namespace
@@ -74,12 +75,9 @@ void file::open(std::string_view mode) const
     auto error =
         fopen_s(&_pdata->_descriptor, _pdata->_path.data(), mode.data());
 #else
-    auto _file_descriptor = fopen(path.data(), privileges.data());
-    int error;
-    if (_file_descriptor)
-    {
-        error = errno;
-    }
+    _pdata->_descriptor =
+        std::fopen(_pdata->_path.c_str(), std::string(mode).c_str());
+    int error = _pdata->_descriptor ? 0 : errno;
 #endif
 
     if (error != 0)
@@ -145,11 +143,7 @@ std::string file::read_all() const
         return read_all_open();
     }
 
-    open("r");
-    auto result = read_all_open();
-    close();
-
-    return result;
+    return read_all(_pdata->_path);
 }
 
 bool file::exists() const
@@ -173,9 +167,9 @@ void file::watch()
 
 std::string file::read_all(std::string_view path)
 {
-    file f { std::string(path) };
-    f.open("r");
-    return f.read_all();
+    // a single copy straight out of the mapped pages
+    file_view view { path };
+    return std::string(view.text());
 }
 
 bool file::exists(std::string_view path)
@@ -197,7 +191,9 @@ std::string file::read_all_open() const
     size_t length = size();
     std::string result(length, '\0');
     std::fseek(_pdata->_descriptor, 0, SEEK_SET);
-    std::fread(result.data(), 1, length, _pdata->_descriptor);
+    // the text mode reads less than the size when converting the newlines
+    result.resize(
+        std::fread(result.data(), 1, length, _pdata->_descriptor));
     return result;
 }
 
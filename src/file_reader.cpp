@@ -0,0 +1,83 @@
+#include "file_reader.hpp"
+
+#include "logging.hpp"
+
+#ifndef WIN32
+#include <fcntl.h>
+#endif
+
+namespace
+{
+static inline logger log() { return get_logger("fs"); }
+} // namespace
+
+file_reader::file_reader(std::string_view path, size_t chunk_size)
+    : _buffer(std::max<size_t>(chunk_size, 1))
+{
+    std::string path_string { path };
+    std::error_code error;
+    _size = std::filesystem::file_size(path_string, error);
+    if (error)
+    {
+        log()->error(
+            "Failed to open the file at {}: {}", path_string, error.message());
+        _size = 0;
+        return;
+    }
+
+    _file = std::fopen(path_string.c_str(), "rb");
+    if (!_file)
+    {
+        log()->error("Failed to open the file at {}", path_string);
+        return;
+    }
+
+    // the chunks are handed out directly, the stdio buffer would only add a
+    // copy
+    std::setvbuf(_file, nullptr, _IONBF, 0);
+#ifndef WIN32
+    ::posix_fadvise(::fileno(_file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    read_ahead();
+}
+
+file_reader::~file_reader()
+{
+    if (_file)
+    {
+        std::fclose(_file);
+    }
+}
+
+bool file_reader::is_open() const { return _file != nullptr; }
+
+size_t file_reader::size() const { return _size; }
+
+std::span<const std::byte> file_reader::next()
+{
+    if (!_file)
+    {
+        return {};
+    }
+
+    size_t read = std::fread(_buffer.data(), 1, _buffer.size(), _file);
+    _offset += read;
+    if (read < _buffer.size() && std::ferror(_file))
+    {
+        log()->error("Failed to read the file at offset {}", _offset);
+    }
+
+    read_ahead();
+    return { _buffer.data(), read };
+}
+
+void file_reader::read_ahead()
+{
+#ifndef WIN32
+    // the kernel starts reading the next chunk in the background
+    ::posix_fadvise(::fileno(_file),
+                    static_cast<off_t>(_offset),
+                    static_cast<off_t>(_buffer.size()),
+                    POSIX_FADV_WILLNEED);
+#endif
+}
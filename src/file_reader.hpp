@@ -0,0 +1,41 @@
+#pragma once
+
+/**
+ * @brief Reads a file front to back in fixed size chunks
+ *
+ * Meant for the files too large to be held at once, e.g. for hashing the
+ * source assets. While a chunk is processed the kernel is already asked to
+ * read the next one, so the consumer rarely waits for the disk.
+ */
+class file_reader
+{
+public:
+    static constexpr size_t default_chunk_size = 1 << 20;
+
+public:
+    explicit file_reader(std::string_view path,
+                         size_t chunk_size = default_chunk_size);
+    file_reader(const file_reader&) = delete;
+    file_reader& operator=(const file_reader&) = delete;
+    ~file_reader();
+
+    bool is_open() const;
+    size_t size() const;
+
+    /**
+     * @brief Read the next chunk of the file
+     *
+     * @return std::span<const std::byte> the chunk, valid until the next
+     * call. Empty at the end of the file or after a failure
+     */
+    std::span<const std::byte> next();
+
+private:
+    void read_ahead();
+
+private:
+    std::FILE* _file = nullptr;
+    std::vector<std::byte> _buffer;
+    size_t _offset = 0;
+    size_t _size = 0;
+};
@@ -0,0 +1,181 @@
+#include "file_view.hpp"
+
+#include "logging.hpp"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+static inline logger log() { return get_logger("fs"); }
+
+#ifndef WIN32
+int to_advice(file_view::access_pattern pattern)
+{
+    switch (pattern)
+    {
+    case file_view::access_pattern::sequential: return MADV_SEQUENTIAL;
+    case file_view::access_pattern::random: return MADV_RANDOM;
+    default: return MADV_NORMAL;
+    }
+}
+#endif
+} // namespace
+
+file_view::file_view(std::string_view path, access_pattern pattern)
+{
+    std::string path_string { path };
+#ifdef WIN32
+    DWORD flags = pattern == access_pattern::random
+                      ? FILE_FLAG_RANDOM_ACCESS
+                      : FILE_FLAG_SEQUENTIAL_SCAN;
+    HANDLE file = CreateFileA(path_string.c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | flags,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        log()->error("Failed to open the file at {}: {}",
+                     path_string,
+                     GetLastError());
+        return;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        CloseHandle(file);
+        return;
+    }
+
+    _size = static_cast<size_t>(file_size.QuadPart);
+    _open = true;
+    if (_size == 0)
+    {
+        CloseHandle(file);
+        return;
+    }
+
+    // the mapping keeps the file open by itself
+    _mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (_mapping)
+    {
+        _data = static_cast<const std::byte*>(
+            MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    int fd = ::open(path_string.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        int error = errno;
+        log()->error("Failed to open the file at {}: {}",
+                     path_string,
+                     std::strerror(error));
+        return;
+    }
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0)
+    {
+        ::close(fd);
+        return;
+    }
+
+    _size = static_cast<size_t>(status.st_size);
+    _open = true;
+    if (_size == 0)
+    {
+        // zero length mappings aren't allowed
+        ::close(fd);
+        return;
+    }
+
+    // the mapping keeps the file open by itself
+    void* mapped = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped != MAP_FAILED)
+    {
+        _data = static_cast<const std::byte*>(mapped);
+        ::madvise(mapped, _size, to_advice(pattern));
+    }
+#endif
+
+    if (!_data)
+    {
+        log()->error("Failed to map the file at {}", path_string);
+        unmap();
+    }
+}
+
+file_view::file_view(file_view&& other)
+    : _data(std::exchange(other._data, nullptr))
+    , _size(std::exchange(other._size, 0))
+    , _open(std::exchange(other._open, false))
+#ifdef WIN32
+    , _mapping(std::exchange(other._mapping, nullptr))
+#endif
+{
+}
+
+file_view& file_view::operator=(file_view&& other)
+{
+    if (this != &other)
+    {
+        unmap();
+        _data = std::exchange(other._data, nullptr);
+        _size = std::exchange(other._size, 0);
+        _open = std::exchange(other._open, false);
+#ifdef WIN32
+        _mapping = std::exchange(other._mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+file_view::~file_view() { unmap(); }
+
+bool file_view::is_open() const { return _open; }
+
+file_view::operator bool() const { return _open; }
+
+std::span<const std::byte> file_view::data() const { return { _data, _size }; }
+
+std::string_view file_view::text() const
+{
+    return { reinterpret_cast<const char*>(_data), _size };
+}
+
+size_t file_view::size() const { return _size; }
+
+void file_view::unmap()
+{
+#ifdef WIN32
+    if (_data)
+    {
+        UnmapViewOfFile(_data);
+    }
+    if (_mapping)
+    {
+        CloseHandle(_mapping);
+    }
+    _mapping = nullptr;
+#else
+    if (_data)
+    {
+        ::munmap(const_cast<std::byte*>(_data), _size);
+    }
+#endif
+    _data = nullptr;
+    _size = 0;
+    _open = false;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+/**
+ * @brief Read-only view of the whole file mapped into the memory
+ *
+ * The pages are read in on access, so the loaders work on the contents
+ * without copying them into a buffer first. The view stays valid until it's
+ * destroyed, the file itself may be closed by then.
+ */
+class file_view
+{
+public:
+    /**
+     * @brief The expected order of the accesses, passed to the kernel to
+     * tune the read-ahead
+     */
+    enum class access_pattern
+    {
+        normal,
+        sequential,
+        random,
+    };
+
+public:
+    file_view() = default;
+    explicit file_view(std::string_view path,
+                       access_pattern pattern = access_pattern::sequential);
+    file_view(const file_view&) = delete;
+    file_view& operator=(const file_view&) = delete;
+    file_view(file_view&& other);
+    file_view& operator=(file_view&& other);
+    ~file_view();
+
+    /**
+     * @brief Check whether the file was mapped, the empty files are mapped
+     * with an empty view
+     */
+    bool is_open() const;
+    explicit operator bool() const;
+
+    std::span<const std::byte> data() const;
+    std::string_view text() const;
+    size_t size() const;
+
+private:
+    void unmap();
+
+private:
+    const std::byte* _data = nullptr;
+    size_t _size = 0;
+    bool _open = false;
+#ifdef WIN32
+    void* _mapping = nullptr;
+#endif
+};
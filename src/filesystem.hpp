@@ -7,4 +7,19 @@ public:
     {
         return "./resources";
     }
+
+    static constexpr std::string shader_cache_path()
+    {
+        return "./cache/shaders";
+    }
+
+    static constexpr std::string mesh_cache_path()
+    {
+        return "./cache/meshes";
+    }
+
+    static constexpr std::string texture_cache_path()
+    {
+        return "./cache/textures";
+    }
 };
@@ -0,0 +1,140 @@
+#include <prof/profiler.hpp>
+
+#include "frame_packet.hpp"
+
+#include "camera.hpp"
+#include "components/renderer_component.hpp"
+#include "game_object.hpp"
+#include "light.hpp"
+#include "scene.hpp"
+
+std::optional<size_t> frame_packet::find_camera(const camera* cam) const
+{
+    for (size_t i = 0; i < cameras.size(); ++i)
+    {
+        if (cameras[ i ].owner == cam)
+        {
+            return i;
+        }
+    }
+
+    return std::nullopt;
+}
+
+const view_visibility& frame_packet::get_visibility() const
+{
+    std::call_once(_visibility_flag,
+                   [ this ]
+    { _visibility = std::make_unique<view_visibility>(*this); });
+    return *_visibility;
+}
+
+std::shared_ptr<const frame_packet> frame_packet::extract(const scene* s)
+{
+    auto sp = prof::profile(__FUNCTION__);
+    auto packet = std::make_shared<frame_packet>();
+    packet->frame_index = ++_frame_counter;
+
+    // the renderers select the levels of detail for the cameras
+    packet->cameras.reserve(camera::all_cameras().size());
+    for (const auto* cam : camera::all_cameras())
+    {
+        packet->cameras.push_back({ cam,
+                                    cam->get_id(),
+                                    cam->get_transform(),
+                                    cam->get_render_size(),
+                                    cam->projection_matrix(),
+                                    cam->vp_matrix() });
+    }
+
+    if (s)
+    {
+        std::unordered_map<const material*, uint32_t> material_indices;
+        packet->renderables.reserve(s->objects().size());
+        for (auto* obj : s->objects())
+        {
+            if (!obj->is_active())
+            {
+                continue;
+            }
+
+            auto* renderer = obj->get_component<renderer_component>();
+            if (!renderer || !renderer->get_material())
+            {
+                continue;
+            }
+
+            auto draw = renderer->capture(*packet);
+            if (!draw)
+            {
+                continue;
+            }
+
+            auto [ it, inserted ] = material_indices.try_emplace(
+                renderer->get_material(), packet->materials.size());
+            if (inserted)
+            {
+                packet->materials.push_back(
+                    renderer->get_material()->capture());
+            }
+
+            const transform& model = obj->get_transform();
+            renderable& r = packet->renderables.emplace_back();
+            r.object_id = obj->get_id();
+            r.draw = std::move(*draw);
+            r.material_index = it->second;
+            r.model_matrix = model.get_matrix();
+            r.world_bounds = { 0.0f, 0.0f, 0.0f, -1.0f };
+            r.occluder = renderer->is_occluder()
+                             ? renderer->get_occluder_mesh()
+                             : nullptr;
+            // the glyphs are blended into the target
+            r.transparent = std::holds_alternative<text_draw>(r.draw);
+            if (auto bounds = renderer->get_bounds(); bounds)
+            {
+                glm::vec3 scale = glm::abs(model.get_scale());
+                r.world_bounds = {
+                    glm::vec3(r.model_matrix * glm::vec4(bounds->center, 1.0f)),
+                    bounds->radius * std::max({ scale.x, scale.y, scale.z })
+                };
+            }
+        }
+    }
+
+    const auto& cameras = camera::all_cameras();
+    const bool gizmos_enabled =
+        std::any_of(cameras.begin(),
+                    cameras.end(),
+                    [](const camera* cam)
+    { return cam->get_gizmos_enabled(); });
+    if (s && gizmos_enabled)
+    {
+        // the components draw their gizmos from their own state, recording
+        // those keeps the render thread away from the objects
+        auto* drawer = gizmo_drawer::instance();
+        for (auto* obj : s->objects())
+        {
+            drawer->set_recording(&packet->gizmos,
+                                  obj->get_transform().get_matrix());
+            obj->draw_gizmos();
+        }
+        drawer->set_recording(nullptr);
+    }
+
+    packet->lights = light_registry::capture(light::get_all_lights());
+
+    return packet;
+}
+
+std::shared_ptr<const frame_packet> frame_packet::current() { return _current; }
+
+void frame_packet::set_current(std::shared_ptr<const frame_packet> packet)
+{
+    _current = std::move(packet);
+}
+
+thread_local std::shared_ptr<const frame_packet> frame_packet::_current {
+    nullptr
+};
+
+std::atomic_uint64_t frame_packet::_frame_counter { 0 };
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <mutex>
+#include <optional>
+#include <variant>
+
+#include "gizmo_drawer.hpp"
+#include "light_registry.hpp"
+#include "material.hpp"
+#include "transform.hpp"
+#include "view_visibility.hpp"
+
+class camera;
+class font;
+class mesh;
+class scene;
+
+/**
+ * @brief Immutable snapshot of the scene state needed to render a frame
+ *
+ * The packet is extracted on the game thread at the end of the update and
+ * consumed by the rendering, possibly on the render thread while the game
+ * thread already simulates the next frame. So the rendering reads the scene
+ * through the packet only: the geometry with the transforms, the values of
+ * the materials and the lights are all copied into it.
+ *
+ * The world matrices and bounds are computed once during the extraction and
+ * shared by all the cameras rendering the frame.
+ */
+struct frame_packet
+{
+    struct mesh_draw
+    {
+        mesh* geometry;
+        // the levels of detail selected for the cameras start at this index
+        // of lod_levels, in the order of the cameras
+        size_t first_lod;
+    };
+
+    struct text_draw
+    {
+        const font* text_font;
+        std::string text;
+    };
+
+    using draw_data = std::variant<mesh_draw, text_draw>;
+
+    struct renderable
+    {
+        // the id of the object, resolved through the scene when needed
+        uint32_t object_id;
+        draw_data draw;
+        // the index of the material values in materials
+        uint32_t material_index;
+        glm::mat4 model_matrix;
+        // world space bounding sphere, negative radius if unbounded
+        glm::vec4 world_bounds;
+        // the geometry to rasterize if the renderable is an occluder
+        const mesh* occluder;
+        // drawn blended, so after the opaque renderables and far to near
+        bool transparent;
+    };
+
+    struct camera_state
+    {
+        const camera* owner;
+        // identifies the camera across the frames, unlike its address
+        uint32_t camera_id;
+        transform camera_transform;
+        // the rendering uses this size, the culling matrices are built for it
+        glm::uvec2 render_size;
+        glm::mat4 projection_matrix;
+        glm::mat4 vp_matrix;
+    };
+
+    uint64_t frame_index { 0 };
+    std::vector<renderable> renderables;
+    // captured once per material, shared by its renderables
+    std::vector<material::snapshot> materials;
+    std::vector<size_t> lod_levels;
+    std::vector<light_registry::light_state> lights;
+    std::vector<camera_state> cameras;
+    // the gizmos of the objects, recorded only while a camera shows them
+    std::vector<gizmo_drawer::line_list> gizmos;
+
+    /**
+     * @brief Find the captured state of the camera
+     *
+     * @param cam the camera
+     * @return std::optional<size_t> the index of the camera state or nothing
+     * if the camera was created after the extraction
+     */
+    std::optional<size_t> find_camera(const camera* cam) const;
+
+    /**
+     * @brief Get the visibility of the renderables from all the cameras
+     *
+     * Computed by the first camera asking for it, the rest of the cameras
+     * reuse the result. The draw lists are built only for the cameras
+     * asking for those.
+     */
+    const view_visibility& get_visibility() const;
+
+    /**
+     * @brief Capture the current state of the scene
+     *
+     * @param s the scene, may be null in which case only the lights and the
+     * cameras are captured
+     * @return std::shared_ptr<const frame_packet> the packet
+     */
+    static std::shared_ptr<const frame_packet> extract(const scene* s);
+
+    /**
+     * @brief Get the packet being rendered by the calling thread
+     */
+    static std::shared_ptr<const frame_packet> current();
+    static void set_current(std::shared_ptr<const frame_packet> packet);
+
+private:
+    mutable std::once_flag _visibility_flag;
+    mutable std::unique_ptr<view_visibility> _visibility { nullptr };
+
+    static thread_local std::shared_ptr<const frame_packet> _current;
+    static std::atomic_uint64_t _frame_counter;
+};
@@ -0,0 +1,124 @@
+#include "frame_readback.hpp"
+
+#include "image.hpp"
+#include "logging.hpp"
+#include "texture.hpp"
+
+namespace
+{
+static logger log() { return get_logger("frame_readback"); }
+} // namespace
+
+frame_readback::frame_readback(size_t frame_latency)
+    : _frame_latency(frame_latency)
+{
+}
+
+frame_readback::~frame_readback()
+{
+    for (auto& rb : _readbacks)
+    {
+        glDeleteSync(rb.fence);
+        glDeleteBuffers(1, &rb.buffer);
+    }
+
+    for (auto& [ buffer, size ] : _free_buffers)
+    {
+        glDeleteBuffers(1, &buffer);
+    }
+}
+
+void frame_readback::read(const texture& source, callback on_ready)
+{
+    readback rb;
+    rb.size = source.get_size();
+    const size_t size = static_cast<size_t>(rb.size.x) * rb.size.y * 4;
+    std::tie(rb.buffer, rb.buffer_size) = acquire_buffer(size);
+    rb.on_ready = std::move(on_ready);
+
+    // the copy goes into the pixel buffer, so the call returns right away
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glGetTextureImage(
+        source.native_id(), 0, GL_RGBA, GL_UNSIGNED_BYTE, size, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    rb.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _readbacks.push_back(std::move(rb));
+}
+
+void frame_readback::process()
+{
+    std::vector<readback> finished;
+    for (auto it = _readbacks.begin(); it != _readbacks.end();)
+    {
+        if (++it->frames < _frame_latency)
+        {
+            ++it;
+            continue;
+        }
+
+        GLenum status = glClientWaitSync(it->fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        {
+            ++it;
+            continue;
+        }
+
+        finished.push_back(std::move(*it));
+        it = _readbacks.erase(it);
+    }
+
+    for (auto& rb : finished)
+    {
+        glDeleteSync(rb.fence);
+
+        image::metadata md;
+        md._width = rb.size.x;
+        md._height = rb.size.y;
+        md._bits_per_pixel = 32;
+        md._channel_count = 4;
+        md._color_type = image::color_type::RGBA;
+        md._file_format = image::file_format::PNG;
+        auto result = std::make_unique<image>();
+        result->init(md);
+
+        const size_t size = static_cast<size_t>(rb.size.x) * rb.size.y * 4;
+        const auto* pixels = static_cast<const char*>(
+            glMapNamedBufferRange(rb.buffer, 0, size, GL_MAP_READ_BIT));
+        if (pixels)
+        {
+            std::memcpy(result->allocate(md._width * 4), pixels, size);
+            glUnmapNamedBuffer(rb.buffer);
+        }
+        else
+        {
+            log()->error("Failed to map the readback buffer {}", rb.buffer);
+            result.reset();
+        }
+
+        _free_buffers.push_back({ rb.buffer, rb.buffer_size });
+        if (result && rb.on_ready)
+        {
+            rb.on_ready(std::move(result));
+        }
+    }
+}
+
+std::pair<unsigned, size_t> frame_readback::acquire_buffer(size_t size)
+{
+    auto it = std::find_if(_free_buffers.begin(),
+                           _free_buffers.end(),
+                           [ size ](const auto& buffer)
+    { return buffer.second >= size; });
+    if (it != _free_buffers.end())
+    {
+        auto buffer = *it;
+        _free_buffers.erase(it);
+        return buffer;
+    }
+
+    unsigned buffer = 0;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferData(buffer, size, nullptr, GL_STREAM_READ);
+    return { buffer, size };
+}
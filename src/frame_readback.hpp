@@ -0,0 +1,61 @@
+#pragma once
+
+class image;
+class texture;
+
+/**
+ * @brief Reads the textures back without stalling the pipeline
+ *
+ * The texture is copied into a pixel buffer and a fence is placed after the
+ * copy. The buffer is mapped once the fence signals, which is checked only
+ * after the given number of frames, when the copy is most likely done. The
+ * buffers are reused by the following readbacks.
+ *
+ * All the calls must be made on the thread owning the GL context.
+ */
+class frame_readback
+{
+public:
+    using callback = std::function<void(std::unique_ptr<image>)>;
+
+public:
+    /**
+     * @param frame_latency the number of the @ref process calls before the
+     * readback is checked for completion
+     */
+    explicit frame_readback(size_t frame_latency = 2);
+    ~frame_readback();
+
+    /**
+     * @brief Queue the readback of the texture
+     *
+     * @param source the texture to read, may be deleted right after
+     * @param on_ready called from @ref process with the 8-bit RGBA image.
+     * The rows are bottom up, as stored in the texture
+     */
+    void read(const texture& source, callback on_ready);
+
+    /**
+     * @brief Resolve the finished readbacks, once per frame
+     */
+    void process();
+
+private:
+    struct readback
+    {
+        unsigned buffer;
+        size_t buffer_size;
+        GLsync fence;
+        size_t frames { 0 };
+        glm::uvec2 size;
+        callback on_ready;
+    };
+
+    std::pair<unsigned, size_t> acquire_buffer(size_t size);
+
+private:
+    size_t _frame_latency;
+    std::vector<readback> _readbacks;
+    // pixel buffers with their sizes, reused by the next readbacks
+    std::vector<std::pair<unsigned, size_t>> _free_buffers;
+};
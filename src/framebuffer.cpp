@@ -6,6 +6,38 @@
 namespace
 {
 logger log() { return get_logger("framebuffer"); }
+
+void allocate_id_texture(unsigned& id, glm::uvec2 size, unsigned samples)
+{
+    if (id != 0)
+    {
+        glDeleteTextures(1, &id);
+    }
+
+    glGenTextures(1, &id);
+    if (samples > 1)
+    {
+        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, id);
+        glTexImage2DMultisample(
+            GL_TEXTURE_2D_MULTISAMPLE, samples, GL_R32UI, size.x, size.y, true);
+        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+        return;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 GL_R32UI,
+                 size.x,
+                 size.y,
+                 0,
+                 GL_RED_INTEGER,
+                 GL_UNSIGNED_INT,
+                 nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
 } // namespace
 
 struct framebuffer::private_data
@@ -14,6 +46,8 @@ struct framebuffer::private_data
     unsigned _fbo { 0 };
     unsigned _copy_fbo { 0 };
     unsigned _sample_count { 1 };
+    bool _object_ids { false };
+    unsigned _id_texture { 0 };
     std::shared_ptr<texture> _color_texture { std::make_shared<texture>() };
     std::shared_ptr<texture> _depth_texture { std::make_shared<texture>() };
 };
@@ -50,6 +84,18 @@ void framebuffer::initialize()
                                                  : GL_TEXTURE_2D,
                            _p->_depth_texture->native_id(),
                            0);
+    if (_p->_object_ids)
+    {
+        allocate_id_texture(_p->_id_texture, _p->_size, _p->_sample_count);
+        glFramebufferTexture2D(GL_FRAMEBUFFER,
+                               GL_COLOR_ATTACHMENT1,
+                               _p->_sample_count > 1
+                                   ? GL_TEXTURE_2D_MULTISAMPLE
+                                   : GL_TEXTURE_2D,
+                               _p->_id_texture,
+                               0);
+    }
+
     auto fbo_status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
     if (fbo_status != GL_FRAMEBUFFER_COMPLETE)
     {
@@ -63,7 +109,12 @@ void framebuffer::initialize()
     glDrawBuffers(buffers.size(), buffers.data());
 }
 
-void framebuffer::destroy() { glDeleteFramebuffers(1, &_p->_fbo); }
+void framebuffer::destroy()
+{
+    glDeleteFramebuffers(1, &_p->_fbo);
+    glDeleteTextures(1, &_p->_id_texture);
+    _p->_id_texture = 0;
+}
 
 void framebuffer::set_samples(unsigned sample_count)
 {
@@ -72,6 +123,96 @@ void framebuffer::set_samples(unsigned sample_count)
     _p->_depth_texture->set_samples(sample_count);
 }
 
+void framebuffer::set_object_ids(bool enabled) { _p->_object_ids = enabled; }
+
+bool framebuffer::has_object_ids() const { return _p->_object_ids; }
+
+void framebuffer::write_object_ids(bool enabled)
+{
+    if (!_p->_object_ids)
+    {
+        return;
+    }
+
+    std::array<unsigned, 2> buffers { GL_COLOR_ATTACHMENT0,
+                                      GL_COLOR_ATTACHMENT1 };
+    glNamedFramebufferDrawBuffers(
+        _p->_fbo, enabled ? buffers.size() : 1, buffers.data());
+}
+
+void framebuffer::clear_object_ids()
+{
+    if (!_p->_object_ids)
+    {
+        return;
+    }
+
+    // the draw buffer index of the attachment, enabled for the clear only
+    write_object_ids(true);
+    std::array<unsigned, 4> background { 0, 0, 0, 0 };
+    glClearNamedFramebufferuiv(_p->_fbo, GL_COLOR, 1, background.data());
+    write_object_ids(false);
+}
+
+void framebuffer::read_object_ids(glm::uvec2 position, glm::uvec2 size) const
+{
+    if (!_p->_object_ids)
+    {
+        return;
+    }
+
+    unsigned source = _p->_fbo;
+    glm::uvec2 origin = position;
+    unsigned resolved = 0;
+    if (_p->_sample_count > 1)
+    {
+        // the blit of an integer attachment selects one of the samples
+        allocate_id_texture(resolved, size, 1);
+        if (_p->_copy_fbo == 0)
+        {
+            glGenFramebuffers(1, &_p->_copy_fbo);
+        }
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _p->_copy_fbo);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER,
+                               GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D,
+                               resolved,
+                               0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, _p->_fbo);
+        glReadBuffer(GL_COLOR_ATTACHMENT1);
+        glBlitFramebuffer(position.x,
+                          position.y,
+                          position.x + size.x,
+                          position.y + size.y,
+                          0,
+                          0,
+                          size.x,
+                          size.y,
+                          GL_COLOR_BUFFER_BIT,
+                          GL_NEAREST);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        source = _p->_copy_fbo;
+        origin = { 0, 0 };
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+    glReadBuffer(source == _p->_fbo ? GL_COLOR_ATTACHMENT1
+                                    : GL_COLOR_ATTACHMENT0);
+    glReadPixels(origin.x,
+                 origin.y,
+                 size.x,
+                 size.y,
+                 GL_RED_INTEGER,
+                 GL_UNSIGNED_INT,
+                 nullptr);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // the pending read keeps the storage alive until it completes
+    glDeleteTextures(1, &resolved);
+}
+
 std::shared_ptr<const texture> framebuffer::color_texture() const
 {
     return _p->_color_texture;
@@ -82,15 +223,23 @@ std::shared_ptr<const texture> framebuffer::depth_texture() const
     return _p->_depth_texture;
 }
 
-void framebuffer::copy_texture(texture* txt) const
+void framebuffer::copy_texture(texture* txt, glm::uvec2 region) const
 {
-    if (_p->_sample_count == 1)
+    if (region == glm::uvec2 { 0, 0 })
+    {
+        region = _p->_size;
+    }
+
+    if (_p->_sample_count == 1 && region == _p->_size)
     {
         txt->clone(color_texture().get());
         return;
     }
 
-    txt->init(_p->_size.x, _p->_size.y);
+    if (txt->get_size() != _p->_size)
+    {
+        txt->init(_p->_size.x, _p->_size.y);
+    }
 
     if (_p->_copy_fbo == 0)
     {
@@ -106,17 +255,41 @@ void framebuffer::copy_texture(texture* txt) const
     glBindFramebuffer(GL_READ_FRAMEBUFFER, _p->_fbo);
     glBlitFramebuffer(0,
                       0,
-                      _p->_size.x,
-                      _p->_size.y,
+                      region.x,
+                      region.y,
                       0,
                       0,
                       _p->_size.x,
                       _p->_size.y,
                       GL_COLOR_BUFFER_BIT,
-                      GL_NEAREST);
+                      region == _p->_size ? GL_NEAREST : GL_LINEAR);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+void framebuffer::blit(const framebuffer* target,
+                       glm::uvec2 region,
+                       glm::ivec2 position,
+                       glm::uvec2 size) const
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _p->_fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target ? target->_p->_fbo : 0);
+    glBlitFramebuffer(0,
+                      0,
+                      region.x,
+                      region.y,
+                      position.x,
+                      position.y,
+                      position.x + size.x,
+                      position.y + size.y,
+                      GL_COLOR_BUFFER_BIT,
+                      region == size ? GL_NEAREST : GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+glm::uvec2 framebuffer::get_size() const { return _p->_size; }
+
+unsigned framebuffer::get_samples() const { return _p->_sample_count; }
+
 void framebuffer::resize(glm::uvec2 size)
 {
     if (_p->_size != size)
@@ -124,6 +297,12 @@ void framebuffer::resize(glm::uvec2 size)
         _p->_size = size;
         _p->_color_texture->init(size.x, size.y, texture::format::RGBA);
         _p->_depth_texture->init(size.x, size.y, texture::format::DEPTH);
+        if (_p->_object_ids && _p->_fbo != 0)
+        {
+            allocate_id_texture(_p->_id_texture, size, _p->_sample_count);
+            glNamedFramebufferTexture(
+                _p->_fbo, GL_COLOR_ATTACHMENT1, _p->_id_texture, 0);
+        }
     }
 }
 
@@ -16,10 +16,73 @@ public:
 
     void set_samples(unsigned sample_count);
 
+    /**
+     * @brief Add an object id attachment to the framebuffer
+     *
+     * The unsigned integer attachment is bound to the fragment output 1. It
+     * must be set before the initialization.
+     */
+    void set_object_ids(bool enabled);
+    bool has_object_ids() const;
+
+    /**
+     * @brief Enable the writing of the object id attachment
+     *
+     * Only the color attachment is written while disabled, so the draws
+     * not writing ids leave the attachment untouched.
+     */
+    void write_object_ids(bool enabled);
+
+    /**
+     * @brief Clear the object id attachment to 0
+     */
+    void clear_object_ids();
+
+    /**
+     * @brief Read the object ids of a region
+     *
+     * The ids are read into the bound pixel pack buffer, as unsigned
+     * integers. Multisampled ids are resolved by taking one of the samples of
+     * each pixel.
+     *
+     * @param position the bottom-left corner of the region
+     * @param size the size of the region
+     */
+    void read_object_ids(glm::uvec2 position, glm::uvec2 size) const;
+
     std::shared_ptr<const texture> color_texture() const;
     std::shared_ptr<const texture> depth_texture() const;
 
-    void copy_texture(texture* txt) const;
+    /**
+     * @brief Copy the color attachment into the texture
+     *
+     * @param txt the texture to copy into
+     * @param region the size of the bottom-left region to copy, the whole
+     * attachment if empty. A partial region is stretched over the texture,
+     * which must have the size of the framebuffer
+     */
+    void copy_texture(texture* txt, glm::uvec2 region = { 0, 0 }) const;
+
+    /**
+     * @brief Blit the color attachment into another framebuffer
+     *
+     * Multisampled attachments are resolved on the way, in which case the
+     * source and the target rectangles must have the same size. Otherwise
+     * the region is stretched over the target rectangle.
+     *
+     * @param target the framebuffer to blit into, the window framebuffer if
+     * null
+     * @param region the size of the bottom-left region to blit
+     * @param position the bottom-left corner of the target rectangle
+     * @param size the size of the target rectangle
+     */
+    void blit(const framebuffer* target,
+              glm::uvec2 region,
+              glm::ivec2 position,
+              glm::uvec2 size) const;
+
+    glm::uvec2 get_size() const;
+    unsigned get_samples() const;
 
     void resize(glm::uvec2 size);
 
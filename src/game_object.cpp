@@ -3,7 +3,18 @@
 #include "component.hpp"
 #include "components/transform_component.hpp"
 
-game_object::game_object() { create_component<transform_component>(); }
+namespace
+{
+std::atomic_uint32_t next_object_id { 1 };
+} // namespace
+
+game_object::game_object()
+    : _id(next_object_id++)
+{
+    create_component<transform_component>();
+}
+
+uint32_t game_object::get_id() const { return _id; }
 
 void game_object::set_selected(bool selected) { _selected = selected; }
 
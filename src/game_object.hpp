@@ -9,6 +9,11 @@ class game_object
 public:
     game_object();
 
+    /**
+     * @brief The unique id of the object, never 0
+     */
+    uint32_t get_id() const;
+
     void set_selected(bool selected = true);
     bool is_selected() const;
 
@@ -54,6 +59,7 @@ public:
     game_object* get_parent();
 
 private:
+    uint32_t _id;
     transform _transformation;
     bool _selected = false;
     bool _is_active = true;
@@ -68,11 +68,11 @@ void gizmo_drawer::draw_grid(glm::vec3 position,
         _grid_indices_cache = std::move(indices);
     }
 
-    _gizmo_shader.set_uniform("u_color", color);
-    _gizmo_shader.use();
-    draw_vertices(
-        _grid_vertices_cache, _grid_indices_cache, _grid_vbo, _grid_ebo);
-    shader_program::unuse();
+    draw_lines(_grid_vertices_cache,
+               _grid_indices_cache,
+               color,
+               _grid_vbo,
+               _grid_ebo);
 }
 
 void gizmo_drawer::draw_plane(glm::vec3 position,
@@ -98,10 +98,7 @@ void gizmo_drawer::draw_plane(glm::vec3 position,
         v = transform * glm::vec4 { v, 1 };
     }
 
-    _gizmo_shader.set_uniform("u_color", color);
-    _gizmo_shader.use();
-    draw_vertices(std::move(vertices), std::move(indices), _vbo, _ebo);
-    shader_program::unuse();
+    draw_lines(vertices, indices, color, _vbo, _ebo);
 }
 
 void gizmo_drawer::draw_box(glm::vec3 position,
@@ -126,10 +123,7 @@ void gizmo_drawer::draw_box(glm::vec3 position,
         v = transform * glm::vec4 { v, 1 };
     }
 
-    _gizmo_shader.set_uniform("u_color", color);
-    _gizmo_shader.use();
-    draw_vertices(std::move(vertices), std::move(indices), _vbo, _ebo);
-    shader_program::unuse();
+    draw_lines(vertices, indices, color, _vbo, _ebo);
 }
 
 void gizmo_drawer::draw_sphere(glm::vec3 center, float radius, glm::vec4 color)
@@ -156,10 +150,7 @@ void gizmo_drawer::draw_sphere(glm::vec3 center, float radius, glm::vec4 color)
         }
     }
 
-    _gizmo_shader.set_uniform("u_color", color);
-    _gizmo_shader.use();
-    draw_vertices(std::move(vertices), std::move(indices), _vbo, _ebo);
-    shader_program::unuse();
+    draw_lines(vertices, indices, color, _vbo, _ebo);
 }
 
 void gizmo_drawer::draw_ray(glm::vec3 pos,
@@ -190,28 +181,90 @@ void gizmo_drawer::draw_ray(glm::vec3 pos,
 }
 void gizmo_drawer::draw_line(glm::vec3 p1, glm::vec3 p2, glm::vec4 color)
 {
-    _gizmo_shader.set_uniform("u_color", color);
-    _gizmo_shader.use();
-    draw_vertices({ { p1 }, { p2 } });
-    shader_program::unuse();
+    draw_lines({ p1, p2 }, color);
 }
 
 void gizmo_drawer::draw_line_2d(glm::vec2 p1, glm::vec2 p2, glm::vec4 color)
 {
-    _gizmo_shader.set_uniform("u_color", color);
-    _gizmo_shader.use();
-    draw_vertices({ { p1, 0 }, { p2, 0 } });
+    draw_lines({ { p1, 0 }, { p2, 0 } }, color);
+}
+
+void gizmo_drawer::set_recording(std::vector<line_list>* target,
+                                 const glm::mat4& model_matrix)
+{
+    _recording = target;
+    _recording_model_matrix = model_matrix;
+}
+
+void gizmo_drawer::draw_recorded(const std::vector<line_list>& lists,
+                                 const glm::mat4& vp_matrix)
+{
+    if (lists.empty())
+    {
+        return;
+    }
+
+    activate();
+    for (const auto& list : lists)
+    {
+        _gizmo_shader.set_uniform("u_model_matrix", list.model_matrix);
+        _gizmo_shader.set_uniform("u_vp_matrix", vp_matrix);
+        _gizmo_shader.set_uniform("u_color", list.color);
+        _gizmo_shader.use();
+        draw_vertices(list.vertices, list.indices, _vbo, _ebo);
+    }
     shader_program::unuse();
 }
 
-void gizmo_drawer::draw_vertices(const std::vector<glm::vec3>& vertices)
+void gizmo_drawer::activate()
+{
+    // created on the first draw, so the gizmos can be recorded on the
+    // threads without a GL context
+    if (!_initialized)
+    {
+        init();
+        glGenBuffers(1, &_vbo);
+        glGenBuffers(1, &_ebo);
+        _initialized = true;
+    }
+
+    if (!_vao.activate())
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
+        simple_vertex3d::initialize_attributes();
+    }
+}
+
+void gizmo_drawer::draw_lines(const std::vector<glm::vec3>& vertices,
+                              glm::vec4 color)
 {
     std::vector<int> indices(vertices.size(), 0);
     for (int i = 0; i < vertices.size(); ++i)
     {
         indices[ i ] = i;
     }
-    draw_vertices(vertices, indices, _vbo, _ebo);
+    draw_lines(vertices, indices, color, _vbo, _ebo);
+}
+
+void gizmo_drawer::draw_lines(const std::vector<glm::vec3>& vertices,
+                              const std::vector<int>& indices,
+                              glm::vec4 color,
+                              unsigned& vbo,
+                              unsigned& ebo)
+{
+    if (_recording)
+    {
+        _recording->push_back(
+            { _recording_model_matrix, color, vertices, indices });
+        return;
+    }
+
+    activate();
+    _gizmo_shader.set_uniform("u_color", color);
+    _gizmo_shader.use();
+    draw_vertices(vertices, indices, vbo, ebo);
+    shader_program::unuse();
 }
 
 void gizmo_drawer::draw_vertices(const std::vector<glm::vec3>& vertices,
@@ -250,19 +303,12 @@ gizmo_drawer* gizmo_drawer::instance()
     if (!_instance)
     {
         _instance = new gizmo_drawer;
-        _instance->init();
-        glGenBuffers(1, &_instance->_vbo);
-        glGenBuffers(1, &_instance->_ebo);
-    }
-
-    if (!_instance->_vao.activate())
-    {
-        glBindBuffer(GL_ARRAY_BUFFER, _instance->_vbo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _instance->_ebo);
-        simple_vertex3d::initialize_attributes();
     }
 
     return _instance;
 }
 
 gizmo_drawer* gizmo_drawer::_instance = nullptr;
+thread_local std::vector<gizmo_drawer::line_list>* gizmo_drawer::_recording =
+    nullptr;
+thread_local glm::mat4 gizmo_drawer::_recording_model_matrix { 1.0f };
@@ -7,9 +7,46 @@ struct GLFWwindow;
 
 class gizmo_drawer
 {
+public:
+    /**
+     * @brief The lines of a gizmo recorded to be drawn later
+     */
+    struct line_list
+    {
+        glm::mat4 model_matrix;
+        glm::vec4 color;
+        std::vector<glm::vec3> vertices;
+        std::vector<int> indices;
+    };
+
 public:
     void init();
 
+    /**
+     * @brief Record the gizmos drawn by the calling thread instead of drawing
+     *
+     * The game thread records the gizmos of the objects into the frame
+     * packet this way, the render thread then draws them with @ref
+     * draw_recorded without touching the objects. The recording makes no GL
+     * calls.
+     *
+     * @param target the lists to append to, null to draw right away again
+     * @param model_matrix the model matrix of the recorded gizmos
+     */
+    void set_recording(std::vector<line_list>* target,
+                       const glm::mat4& model_matrix = glm::mat4(1.0f));
+
+    /**
+     * @brief Draw the recorded gizmos
+     *
+     * Must be called on the thread owning the GL context.
+     *
+     * @param lists the recorded lines
+     * @param vp_matrix the view projection matrix of the camera
+     */
+    void draw_recorded(const std::vector<line_list>& lists,
+                       const glm::mat4& vp_matrix);
+
     void draw_grid(glm::vec3 position,
                    glm::quat rotation,
                    glm::vec2 scale,
@@ -35,7 +72,13 @@ public:
     static gizmo_drawer* instance();
 
 private:
-    void draw_vertices(const std::vector<glm::vec3>& vertices);
+    void activate();
+    void draw_lines(const std::vector<glm::vec3>& vertices, glm::vec4 color);
+    void draw_lines(const std::vector<glm::vec3>& vertices,
+                    const std::vector<int>& indices,
+                    glm::vec4 color,
+                    unsigned& vbo,
+                    unsigned& ebo);
     void draw_vertices(const std::vector<glm::vec3>& vertices,
                        const std::vector<int>& indices,
                        unsigned& vbo,
@@ -43,7 +86,10 @@ private:
 
 private:
     shader_program _gizmo_shader;
+    bool _initialized { false };
     static gizmo_drawer* _instance;
+    static thread_local std::vector<line_list>* _recording;
+    static thread_local glm::mat4 _recording_model_matrix;
     std::vector<glm::vec3> _grid_vertices_cache;
     std::vector<int> _grid_indices_cache;
     size_t _grid_cache_checksum = 0;
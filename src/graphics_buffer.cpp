@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <stdexcept>
 
 #include "graphics_buffer.hpp"
@@ -29,6 +30,8 @@ graphics_buffer::graphics_buffer(graphics_buffer&& o)
     , _handle(o._handle)
     , _element_count(o._element_count)
     , _element_stride(o._element_stride)
+    , _capacity(o._capacity)
+    , _immutable(o._immutable)
 {
     o._handle = 0;
 }
@@ -39,13 +42,15 @@ graphics_buffer& graphics_buffer::operator=(graphics_buffer&& o)
     _handle = o._handle;
     _element_count = o._element_count;
     _element_stride = o._element_stride;
+    _capacity = o._capacity;
+    _immutable = o._immutable;
     o._handle = 0;
     return *this;
 }
 
 graphics_buffer::~graphics_buffer() { release(); }
 
-void graphics_buffer::set_data(void* data_buffer)
+void graphics_buffer::set_data(const void* data_buffer)
 {
     int usage = GL_STATIC_DRAW;
     switch (_usage_type)
@@ -96,10 +101,52 @@ void graphics_buffer::set_data(void* data_buffer)
         break;
     }
     }
+    if (_immutable)
+    {
+        // the storage of the reserved buffers can not be respecified
+        glDeleteBuffers(1, &_handle);
+        glCreateBuffers(1, &_handle);
+        _immutable = false;
+    }
+    _capacity = _element_count;
     glNamedBufferData(
         _handle, _element_count * _element_stride, data_buffer, usage);
 }
 
+void graphics_buffer::reserve(int element_count)
+{
+    if (element_count <= _capacity)
+    {
+        return;
+    }
+
+    // immutable storage can not be resized, so grow geometrically to keep
+    // the reallocations rare
+    _capacity = std::max(element_count, _capacity * 2);
+    _immutable = true;
+    glDeleteBuffers(1, &_handle);
+    glCreateBuffers(1, &_handle);
+    glNamedBufferStorage(_handle,
+                         static_cast<GLsizeiptr>(_capacity) * _element_stride,
+                         nullptr,
+                         GL_DYNAMIC_STORAGE_BIT);
+}
+
+void graphics_buffer::set_sub_data(const void* data_buffer,
+                                   int element_offset,
+                                   int element_count)
+{
+    if (element_count <= 0)
+    {
+        return;
+    }
+
+    glNamedBufferSubData(_handle,
+                         element_offset * _element_stride,
+                         element_count * _element_stride,
+                         data_buffer);
+}
+
 void graphics_buffer::get_data(void* data_buffer) const
 {
     throw std::runtime_error("Not implemented");
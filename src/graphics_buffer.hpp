@@ -30,7 +30,32 @@ public:
     graphics_buffer& operator=(const graphics_buffer& o) = delete;
     ~graphics_buffer();
 
-    void set_data(void* data_buffer);
+    void set_data(const void* data_buffer);
+
+    /**
+     * @brief Make sure the storage fits at least the given elements
+     *
+     * The storage is immutable and is only reallocated, with a new handle,
+     * when it is too small. The contents are lost on reallocation, so the
+     * elements must be written again with @ref set_sub_data.
+     *
+     * @param element_count the number of the elements to fit
+     */
+    void reserve(int element_count);
+
+    /**
+     * @brief Overwrite a range of the elements keeping the storage
+     *
+     * The range must be within the storage allocated by the last
+     * @ref set_data or @ref reserve call.
+     *
+     * @param data_buffer the new values of the elements
+     * @param element_offset the index of the first element to overwrite
+     * @param element_count the number of the elements to overwrite
+     */
+    void set_sub_data(const void* data_buffer,
+                      int element_offset,
+                      int element_count);
     void get_data(void* data_buffer) const;
 
     void set_element_count(int element_count);
@@ -51,4 +76,6 @@ private:
     unsigned _handle { 0 };
     int _element_count { 0 };
     int _element_stride { 0 };
+    int _capacity { 0 };
+    bool _immutable { false };
 };
@@ -1,5 +1,6 @@
 #include "image.hpp"
 
+#include "image_conversion.hpp"
 #include "texture.hpp"
 
 image::image() = default;
@@ -8,7 +9,10 @@ void image::init(metadata md) { _metadata = md; }
 
 void image::init(size_t width, size_t height) { }
 
-void image::set_data(std::vector<char> data) { _data_buffer = std::move(data); }
+void image::set_data(std::vector<char> data)
+{
+    set_data(data.data(), data.size());
+}
 
 void image::set_data(const char* data)
 {
@@ -18,31 +22,48 @@ void image::set_data(const char* data)
 
 void image::set_data(const char* data, size_t size)
 {
-    _data_buffer = std::vector<char>(data, data + size);
+    std::memcpy(allocate_bytes(size, default_alignment), data, size);
+}
+
+char* image::allocate(size_t bytes_per_row, size_t alignment)
+{
+    _metadata._bytes_per_row = bytes_per_row;
+    return allocate_bytes(bytes_per_row * _metadata._height, alignment);
+}
+
+char* image::allocate_bytes(size_t size, size_t alignment)
+{
+    // left uninitialized, the decoders write every byte anyway
+    void* storage = ::operator new[](std::max<size_t>(size, 1),
+                                     std::align_val_t { alignment });
+    // the previous storage is released with its own alignment
+    _data_buffer.reset(static_cast<char*>(storage));
+    _data_buffer.get_deleter().alignment = alignment;
+    return _data_buffer.get();
 }
 
 template <>
 const char* image::get_data<char>() const
 {
-    return _data_buffer.data();
+    return _data_buffer.get();
 }
 
 template <>
 const unsigned char* image::get_data<unsigned char>() const
 {
-    return reinterpret_cast<const unsigned char*>(_data_buffer.data());
+    return reinterpret_cast<const unsigned char*>(_data_buffer.get());
 }
 
 template <>
 char* image::raw_data<char>()
 {
-    return _data_buffer.data();
+    return _data_buffer.get();
 }
 
 template <>
 unsigned char* image::raw_data<unsigned char>()
 {
-    return reinterpret_cast<unsigned char*>(_data_buffer.data());
+    return reinterpret_cast<unsigned char*>(_data_buffer.get());
 }
 
 const image::metadata& image::get_metadata() const { return _metadata; }
@@ -63,7 +84,8 @@ image* image::from_texture(texture* txt)
     md._color_type = image::color_type::RGBA;
     md._file_format = image::file_format::PNG;
     result->init(md);
-    result->_data_buffer.resize(md._height * md._bytes_per_row);
-    txt->get_data(result->raw_data());
+    txt->get_data(result->allocate(md._bytes_per_row));
+    // the textures are stored bottom up
+    flip_vertically(*result);
     return result;
 }
@@ -36,6 +36,9 @@ public:
         file_format _file_format;
     };
 
+    // enough for the aligned SIMD loads of the pixel conversions
+    static constexpr size_t default_alignment = 16;
+
 public:
     image();
 
@@ -44,6 +47,21 @@ public:
     void set_data(std::vector<char> data);
     void set_data(const char* data);
     void set_data(const char* data, size_t size);
+
+    /**
+     * @brief Allocate the pixel storage for a decoder to write into
+     *
+     * The previous data is discarded. The storage holds the rows of the
+     * height of the metadata, each one starting at a multiple of
+     * bytes_per_row, which is recorded in the metadata.
+     *
+     * @param bytes_per_row the stride of the rows, at least the size of the
+     * pixels of a row
+     * @param alignment the alignment of the storage, a power of two
+     * @return char* the beginning of the storage
+     */
+    char* allocate(size_t bytes_per_row,
+                   size_t alignment = default_alignment);
     template <typename T = char>
     const T* get_data() const;
     template <typename T = char>
@@ -56,6 +74,23 @@ public:
     static image* from_texture(texture*);
 
 private:
+    char* allocate_bytes(size_t size, size_t alignment);
+
+private:
+    struct aligned_delete
+    {
+        aligned_delete()
+            : alignment(default_alignment)
+        {
+        }
+
+        size_t alignment;
+        void operator()(char* data) const
+        {
+            ::operator delete[](data, std::align_val_t { alignment });
+        }
+    };
+
     metadata _metadata;
-    std::vector<char> _data_buffer;
+    std::unique_ptr<char[], aligned_delete> _data_buffer;
 };
@@ -0,0 +1,552 @@
+#include "image_conversion.hpp"
+
+#include "image.hpp"
+#include "logging.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define IMAGE_CONVERSION_USE_SSE
+#    include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#    define IMAGE_CONVERSION_USE_SSSE3
+#    include <tmmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#    define IMAGE_CONVERSION_USE_AVX2
+#    include <immintrin.h>
+#endif
+
+namespace
+{
+static logger log() { return get_logger("image_conversion"); }
+
+// below this amount of pixel data per thread starting the threads costs more
+// than they save
+constexpr size_t MIN_BYTES_PER_THREAD = 1 << 20;
+
+// the alpha byte of a little endian 32-bit RGBA pixel set to 255
+constexpr int OPAQUE_ALPHA = static_cast<int>(0xFF000000u);
+
+// rounded x / 255 for x up to 255 * 255
+inline uint8_t div_255(unsigned x)
+{
+    x += 128;
+    return static_cast<uint8_t>((x + (x >> 8)) >> 8);
+}
+
+#ifdef IMAGE_CONVERSION_USE_SSE
+inline __m128i div_255(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// multiplies the first three channels of the two 16-bit pixels by the fourth
+inline __m128i multiply_by_fourth(__m128i pixels)
+{
+    const __m128i color_mask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+    const __m128i fourth_one = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+    __m128i factor = _mm_shufflehi_epi16(
+        _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)),
+        _MM_SHUFFLE(3, 3, 3, 3));
+    factor = _mm_or_si128(_mm_and_si128(factor, color_mask), fourth_one);
+    return div_255(_mm_mullo_epi16(pixels, factor));
+}
+#endif
+
+#ifdef IMAGE_CONVERSION_USE_AVX2
+inline __m256i div_255(__m256i x)
+{
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+inline __m256i multiply_by_fourth(__m256i pixels)
+{
+    const __m256i color_mask = _mm256_setr_epi16(
+        -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0);
+    const __m256i fourth_one = _mm256_setr_epi16(
+        0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+    __m256i factor = _mm256_shufflehi_epi16(
+        _mm256_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)),
+        _MM_SHUFFLE(3, 3, 3, 3));
+    factor = _mm256_or_si256(_mm256_and_si256(factor, color_mask), fourth_one);
+    return div_255(_mm256_mullo_epi16(pixels, factor));
+}
+#endif
+
+// the color channels are multiplied by the fourth one, which is either kept
+// or replaced by the opaque alpha
+void multiply_by_fourth(const uint8_t* source,
+                        uint8_t* target,
+                        size_t pixel_count,
+                        bool opaque)
+{
+    size_t i = 0;
+#if defined(IMAGE_CONVERSION_USE_AVX2)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alpha = _mm256_set1_epi32(opaque ? OPAQUE_ALPHA : 0);
+    for (; i + 8 <= pixel_count; i += 8)
+    {
+        __m256i pixels = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(source + i * 4));
+        __m256i lo = multiply_by_fourth(_mm256_unpacklo_epi8(pixels, zero));
+        __m256i hi = multiply_by_fourth(_mm256_unpackhi_epi8(pixels, zero));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(target + i * 4),
+            _mm256_or_si256(_mm256_packus_epi16(lo, hi), alpha));
+    }
+#elif defined(IMAGE_CONVERSION_USE_SSE)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi32(opaque ? OPAQUE_ALPHA : 0);
+    for (; i + 4 <= pixel_count; i += 4)
+    {
+        __m128i pixels =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        __m128i lo = multiply_by_fourth(_mm_unpacklo_epi8(pixels, zero));
+        __m128i hi = multiply_by_fourth(_mm_unpackhi_epi8(pixels, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + i * 4),
+                         _mm_or_si128(_mm_packus_epi16(lo, hi), alpha));
+    }
+#endif
+    for (; i < pixel_count; ++i)
+    {
+        const uint8_t* pixel = source + i * 4;
+        uint8_t* result = target + i * 4;
+        const uint8_t factor = pixel[ 3 ];
+        result[ 0 ] = div_255(pixel[ 0 ] * factor);
+        result[ 1 ] = div_255(pixel[ 1 ] * factor);
+        result[ 2 ] = div_255(pixel[ 2 ] * factor);
+        result[ 3 ] = opaque ? 255 : factor;
+    }
+}
+
+bool is_rgba8(const image::metadata& md)
+{
+    return md._channel_count == 4 && md._bits_per_pixel == 32 &&
+           md._color_type == image::color_type::RGBA;
+}
+} // namespace
+
+void expand_rgb_to_rgba(const uint8_t* source,
+                        uint8_t* target,
+                        size_t pixel_count)
+{
+    size_t i = 0;
+#ifdef IMAGE_CONVERSION_USE_SSSE3
+    const __m128i shuffle =
+        _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32(OPAQUE_ALPHA);
+    // 16 bytes are loaded for the 12 used ones, so stay away from the end
+    for (; i + 6 <= pixel_count; i += 4)
+    {
+        __m128i pixels =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(target + i * 4),
+            _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+    }
+#endif
+    for (; i < pixel_count; ++i)
+    {
+        target[ i * 4 ] = source[ i * 3 ];
+        target[ i * 4 + 1 ] = source[ i * 3 + 1 ];
+        target[ i * 4 + 2 ] = source[ i * 3 + 2 ];
+        target[ i * 4 + 3 ] = 255;
+    }
+}
+
+void pack_rgba_to_rgb(const uint8_t* source,
+                      uint8_t* target,
+                      size_t pixel_count)
+{
+    size_t i = 0;
+#ifdef IMAGE_CONVERSION_USE_SSSE3
+    const __m128i shuffle = _mm_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    // 16 bytes are stored for the 12 produced ones, the next iteration
+    // overwrites the rest
+    for (; i + 6 <= pixel_count; i += 4)
+    {
+        __m128i pixels =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + i * 3),
+                         _mm_shuffle_epi8(pixels, shuffle));
+    }
+#endif
+    for (; i < pixel_count; ++i)
+    {
+        target[ i * 3 ] = source[ i * 4 ];
+        target[ i * 3 + 1 ] = source[ i * 4 + 1 ];
+        target[ i * 3 + 2 ] = source[ i * 4 + 2 ];
+    }
+}
+
+void expand_gray_to_rgb(const uint8_t* source,
+                        uint8_t* target,
+                        size_t pixel_count)
+{
+    size_t i = 0;
+#ifdef IMAGE_CONVERSION_USE_SSSE3
+    const __m128i shuffle0 =
+        _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+    const __m128i shuffle1 =
+        _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+    const __m128i shuffle2 = _mm_setr_epi8(
+        10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+    for (; i + 16 <= pixel_count; i += 16)
+    {
+        __m128i gray =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        auto* out = reinterpret_cast<__m128i*>(target + i * 3);
+        _mm_storeu_si128(out, _mm_shuffle_epi8(gray, shuffle0));
+        _mm_storeu_si128(out + 1, _mm_shuffle_epi8(gray, shuffle1));
+        _mm_storeu_si128(out + 2, _mm_shuffle_epi8(gray, shuffle2));
+    }
+#endif
+    for (; i < pixel_count; ++i)
+    {
+        std::fill_n(target + i * 3, 3, source[ i ]);
+    }
+}
+
+void expand_gray_to_rgba(const uint8_t* source,
+                         uint8_t* target,
+                         size_t pixel_count)
+{
+    size_t i = 0;
+#ifdef IMAGE_CONVERSION_USE_SSE
+    const __m128i opaque = _mm_set1_epi8(-1);
+    for (; i + 16 <= pixel_count; i += 16)
+    {
+        __m128i gray =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        // (g, g) and (g, a) pairs interleaved give (g, g, g, a)
+        __m128i gg_lo = _mm_unpacklo_epi8(gray, gray);
+        __m128i gg_hi = _mm_unpackhi_epi8(gray, gray);
+        __m128i ga_lo = _mm_unpacklo_epi8(gray, opaque);
+        __m128i ga_hi = _mm_unpackhi_epi8(gray, opaque);
+        auto* out = reinterpret_cast<__m128i*>(target + i * 4);
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(gg_lo, ga_lo));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(gg_lo, ga_lo));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(gg_hi, ga_hi));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(gg_hi, ga_hi));
+    }
+#endif
+    for (; i < pixel_count; ++i)
+    {
+        std::fill_n(target + i * 4, 3, source[ i ]);
+        target[ i * 4 + 3 ] = 255;
+    }
+}
+
+void expand_gray_alpha_to_rgba(const uint8_t* source,
+                               uint8_t* target,
+                               size_t pixel_count)
+{
+    size_t i = 0;
+#ifdef IMAGE_CONVERSION_USE_SSE
+    const __m128i low_bytes = _mm_set1_epi16(0x00FF);
+    for (; i + 8 <= pixel_count; i += 8)
+    {
+        __m128i ga =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+        __m128i gray = _mm_and_si128(ga, low_bytes);
+        __m128i gg = _mm_or_si128(gray, _mm_slli_epi16(gray, 8));
+        auto* out = reinterpret_cast<__m128i*>(target + i * 4);
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(gg, ga));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(gg, ga));
+    }
+#endif
+    for (; i < pixel_count; ++i)
+    {
+        std::fill_n(target + i * 4, 3, source[ i * 2 ]);
+        target[ i * 4 + 3 ] = source[ i * 2 + 1 ];
+    }
+}
+
+void cmyk_to_rgba(const uint8_t* source, uint8_t* target, size_t pixel_count)
+{
+    // the inverted channels multiplied by the inverted key are the colors
+    multiply_by_fourth(source, target, pixel_count, true);
+}
+
+void narrow_16_to_8(const uint8_t* source,
+                    uint8_t* target,
+                    size_t sample_count)
+{
+    size_t i = 0;
+#if defined(IMAGE_CONVERSION_USE_AVX2)
+    // the most significant byte comes first, it's the lower one of the lanes
+    const __m256i low_bytes = _mm256_set1_epi16(0x00FF);
+    for (; i + 32 <= sample_count; i += 32)
+    {
+        const auto* in = reinterpret_cast<const __m256i*>(source + i * 2);
+        __m256i a = _mm256_and_si256(_mm256_loadu_si256(in), low_bytes);
+        __m256i b = _mm256_and_si256(_mm256_loadu_si256(in + 1), low_bytes);
+        // the packing interleaves the 128-bit halves of the inputs
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(target + i),
+            _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b),
+                                     _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+#elif defined(IMAGE_CONVERSION_USE_SSE)
+    const __m128i low_bytes = _mm_set1_epi16(0x00FF);
+    for (; i + 16 <= sample_count; i += 16)
+    {
+        const auto* in = reinterpret_cast<const __m128i*>(source + i * 2);
+        __m128i a = _mm_and_si128(_mm_loadu_si128(in), low_bytes);
+        __m128i b = _mm_and_si128(_mm_loadu_si128(in + 1), low_bytes);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + i),
+                         _mm_packus_epi16(a, b));
+    }
+#endif
+    for (; i < sample_count; ++i)
+    {
+        target[ i ] = source[ i * 2 ];
+    }
+}
+
+void srgb_to_linear(const uint8_t* source, float* target, size_t sample_count)
+{
+    static const std::array<float, 256> table = []
+    {
+        std::array<float, 256> result;
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            float value = i / 255.0f;
+            result[ i ] = value <= 0.04045f
+                              ? value / 12.92f
+                              : std::pow((value + 0.055f) / 1.055f, 2.4f);
+        }
+        return result;
+    }();
+
+    for (size_t i = 0; i < sample_count; ++i)
+    {
+        target[ i ] = table[ source[ i ] ];
+    }
+}
+
+void linear_to_srgb(const float* source, uint8_t* target, size_t sample_count)
+{
+    // fine enough for the 8-bit results in the dark range as well
+    constexpr size_t TABLE_SIZE = 4096;
+    static const std::array<uint8_t, TABLE_SIZE> table = []
+    {
+        std::array<uint8_t, TABLE_SIZE> result;
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            float value = i / static_cast<float>(TABLE_SIZE - 1);
+            float encoded =
+                value <= 0.0031308f
+                    ? value * 12.92f
+                    : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+            result[ i ] = static_cast<uint8_t>(encoded * 255.0f + 0.5f);
+        }
+        return result;
+    }();
+
+    size_t i = 0;
+#ifdef IMAGE_CONVERSION_USE_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(TABLE_SIZE - 1);
+    alignas(16) std::array<int32_t, 4> indices;
+    for (; i + 4 <= sample_count; i += 4)
+    {
+        // the maximum maps NaN to 0 as well
+        __m128 values = _mm_min_ps(
+            _mm_max_ps(_mm_loadu_ps(source + i), _mm_setzero_ps()), one);
+        _mm_store_si128(reinterpret_cast<__m128i*>(indices.data()),
+                        _mm_cvtps_epi32(_mm_mul_ps(values, scale)));
+        target[ i ] = table[ indices[ 0 ] ];
+        target[ i + 1 ] = table[ indices[ 1 ] ];
+        target[ i + 2 ] = table[ indices[ 2 ] ];
+        target[ i + 3 ] = table[ indices[ 3 ] ];
+    }
+#endif
+    for (; i < sample_count; ++i)
+    {
+        float value = source[ i ] > 0.0f ? std::min(source[ i ], 1.0f) : 0.0f;
+        target[ i ] = table[ static_cast<size_t>(value * (TABLE_SIZE - 1) +
+                                                 0.5f) ];
+    }
+}
+
+void premultiply_alpha(uint8_t* rgba, size_t pixel_count)
+{
+    multiply_by_fourth(rgba, rgba, pixel_count, false);
+}
+
+void swizzle_rgba(uint8_t* rgba,
+                  size_t pixel_count,
+                  std::array<uint8_t, 4> order)
+{
+    size_t i = 0;
+#ifdef IMAGE_CONVERSION_USE_SSSE3
+    alignas(16) std::array<int8_t, 16> mask;
+    for (size_t b = 0; b < mask.size(); ++b)
+    {
+        mask[ b ] = static_cast<int8_t>(b / 4 * 4 + (order[ b % 4 ] & 3));
+    }
+    const __m128i shuffle =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(mask.data()));
+    for (; i + 4 <= pixel_count; i += 4)
+    {
+        auto* pixels = reinterpret_cast<__m128i*>(rgba + i * 4);
+        _mm_storeu_si128(pixels,
+                         _mm_shuffle_epi8(_mm_loadu_si128(pixels), shuffle));
+    }
+#endif
+    for (; i < pixel_count; ++i)
+    {
+        uint8_t* pixel = rgba + i * 4;
+        std::array<uint8_t, 4> original;
+        std::memcpy(original.data(), pixel, 4);
+        for (size_t c = 0; c < 4; ++c)
+        {
+            pixel[ c ] = original[ order[ c ] & 3 ];
+        }
+    }
+}
+
+void for_row_ranges(size_t row_count,
+                    size_t bytes_per_row,
+                    const std::function<void(size_t, size_t)>& convert)
+{
+    const size_t thread_count = std::min<size_t>(
+        { std::max(std::thread::hardware_concurrency(), 1u),
+          row_count * bytes_per_row / MIN_BYTES_PER_THREAD + 1,
+          std::max<size_t>(row_count, 1) });
+    if (thread_count <= 1)
+    {
+        convert(0, row_count);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    const size_t rows_per_thread =
+        (row_count + thread_count - 1) / thread_count;
+    for (size_t begin = 0; begin < row_count; begin += rows_per_thread)
+    {
+        threads.emplace_back(
+            convert, begin, std::min(begin + rows_per_thread, row_count));
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+std::unique_ptr<image> convert_to_rgba8(const image& img)
+{
+    const auto& md = img.get_metadata();
+    const size_t channels = md._channel_count;
+    if (channels == 0 || channels > 4 || md._bits_per_pixel % channels != 0)
+    {
+        return nullptr;
+    }
+
+    const size_t bits = md._bits_per_pixel / channels;
+    const bool cmyk = md._color_type == image::color_type::CMYK;
+    if ((bits != 8 && bits != 16) || (cmyk && channels != 4) ||
+        md._color_type == image::color_type::YCbCr ||
+        md._color_type == image::color_type::YCCK)
+    {
+        log()->warn("Unsupported pixel format: {} channels of {} bits",
+                    channels,
+                    bits);
+        return nullptr;
+    }
+
+    image::metadata result_md = md;
+    result_md._channel_count = 4;
+    result_md._bits_per_pixel = 32;
+    result_md._color_type = image::color_type::RGBA;
+    auto result = std::make_unique<image>();
+    result->init(result_md);
+
+    const size_t width = md._width;
+    auto* target = reinterpret_cast<uint8_t*>(result->allocate(width * 4));
+    const auto* source = img.get_data<unsigned char>();
+    for_row_ranges(md._height,
+                   width * 4,
+                   [ & ](size_t begin, size_t end)
+    {
+        std::vector<uint8_t> narrowed(bits == 16 ? width * channels : 0);
+        for (size_t y = begin; y < end; ++y)
+        {
+            const uint8_t* row = source + y * md._bytes_per_row;
+            if (bits == 16)
+            {
+                narrow_16_to_8(row, narrowed.data(), narrowed.size());
+                row = narrowed.data();
+            }
+
+            uint8_t* out = target + y * width * 4;
+            switch (channels)
+            {
+            case 1: expand_gray_to_rgba(row, out, width); break;
+            case 2: expand_gray_alpha_to_rgba(row, out, width); break;
+            case 3: expand_rgb_to_rgba(row, out, width); break;
+            case 4:
+                if (cmyk)
+                {
+                    cmyk_to_rgba(row, out, width);
+                }
+                else
+                {
+                    std::memcpy(out, row, width * 4);
+                }
+                break;
+            }
+        }
+    });
+    return result;
+}
+
+void premultiply_alpha(image& img)
+{
+    const auto& md = img.get_metadata();
+    if (!is_rgba8(md))
+    {
+        log()->warn("Only 8-bit RGBA images can be premultiplied");
+        return;
+    }
+
+    auto* data = img.raw_data<unsigned char>();
+    for_row_ranges(md._height,
+                   md._width * 4,
+                   [ & ](size_t begin, size_t end)
+    {
+        for (size_t y = begin; y < end; ++y)
+        {
+            premultiply_alpha(data + y * md._bytes_per_row, md._width);
+        }
+    });
+}
+
+void flip_vertically(image& img)
+{
+    const auto& md = img.get_metadata();
+    const size_t stride = md._bytes_per_row;
+    char* data = img.raw_data();
+    // the threads take the row pairs from the upper half
+    for_row_ranges(md._height / 2,
+                   stride * 2,
+                   [ & ](size_t begin, size_t end)
+    {
+        std::vector<char> row(stride);
+        for (size_t y = begin; y < end; ++y)
+        {
+            char* upper = data + y * stride;
+            char* lower = data + (md._height - 1 - y) * stride;
+            std::memcpy(row.data(), upper, stride);
+            std::memcpy(upper, lower, stride);
+            std::memcpy(lower, row.data(), stride);
+        }
+    });
+}
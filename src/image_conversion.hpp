@@ -0,0 +1,101 @@
+#pragma once
+
+class image;
+
+/**
+ * @brief Pixel format conversions of the decoded images
+ *
+ * The row kernels work on tightly packed 8-bit samples unless stated
+ * otherwise, the source and the target must not overlap. They use the
+ * widest vector instructions the build targets (SSE2, SSSE3 or AVX2).
+ */
+
+void expand_rgb_to_rgba(const uint8_t* source,
+                        uint8_t* target,
+                        size_t pixel_count);
+void pack_rgba_to_rgb(const uint8_t* source,
+                      uint8_t* target,
+                      size_t pixel_count);
+void expand_gray_to_rgb(const uint8_t* source,
+                        uint8_t* target,
+                        size_t pixel_count);
+void expand_gray_to_rgba(const uint8_t* source,
+                         uint8_t* target,
+                         size_t pixel_count);
+void expand_gray_alpha_to_rgba(const uint8_t* source,
+                               uint8_t* target,
+                               size_t pixel_count);
+
+/**
+ * @brief Convert the inverted (Adobe) CMYK, as decoded by libjpeg, to RGBA
+ */
+void cmyk_to_rgba(const uint8_t* source, uint8_t* target, size_t pixel_count);
+
+/**
+ * @brief Keep the most significant bytes of the 16-bit samples
+ *
+ * @param source the big endian samples, as decoded by libpng
+ * @param target the 8-bit samples
+ * @param sample_count the number of the samples
+ */
+void narrow_16_to_8(const uint8_t* source,
+                    uint8_t* target,
+                    size_t sample_count);
+
+void srgb_to_linear(const uint8_t* source, float* target, size_t sample_count);
+
+/**
+ * @brief Encode the linear samples, the values are clamped to [0, 1]
+ */
+void linear_to_srgb(const float* source, uint8_t* target, size_t sample_count);
+
+/**
+ * @brief Multiply the color channels of the RGBA pixels by their alpha
+ */
+void premultiply_alpha(uint8_t* rgba, size_t pixel_count);
+
+/**
+ * @brief Reorder the channels of the RGBA pixels in place
+ *
+ * @param order the source channel of each of the resulting channels, e.g.
+ * { 2, 1, 0, 3 } swaps the red and the blue channels
+ */
+void swizzle_rgba(uint8_t* rgba,
+                  size_t pixel_count,
+                  std::array<uint8_t, 4> order);
+
+/**
+ * @brief Run the row conversion over ranges of the rows in parallel
+ *
+ * The rows are split across the hardware threads once the amount of the
+ * data makes starting the threads worth it.
+ *
+ * @param row_count the number of the rows
+ * @param bytes_per_row the amount of data processed per row
+ * @param convert called with the [begin, end) ranges of the rows
+ */
+void for_row_ranges(size_t row_count,
+                    size_t bytes_per_row,
+                    const std::function<void(size_t, size_t)>& convert);
+
+/**
+ * @brief Convert the image to 8-bit RGBA
+ *
+ * Grayscale (with or without alpha), RGB, RGBA and CMYK images of 8 or 16
+ * bits per channel are supported. Large images are converted by multiple
+ * threads.
+ *
+ * @return std::unique_ptr<image> the converted image, empty if the format
+ * of the image isn't supported
+ */
+std::unique_ptr<image> convert_to_rgba8(const image& img);
+
+/**
+ * @brief Multiply the color channels of the 8-bit RGBA image by the alpha
+ */
+void premultiply_alpha(image& img);
+
+/**
+ * @brief Mirror the rows of the image, e.g. after reading the texture back
+ */
+void flip_vertically(image& img);
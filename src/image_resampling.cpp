@@ -0,0 +1,344 @@
+#include "image_resampling.hpp"
+
+#include "image.hpp"
+#include "image_conversion.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define IMAGE_RESAMPLING_USE_SSE
+#    include <emmintrin.h>
+#endif
+
+namespace
+{
+constexpr double PI = 3.14159265358979323846;
+constexpr double KAISER_ALPHA = 4.0;
+
+// the linear RGBA pixels, 4 floats each
+struct float_image
+{
+    size_t width { 0 };
+    size_t height { 0 };
+    std::vector<float> pixels;
+};
+
+// the taps of the filter for each pixel of the resampled axis
+struct filter_taps
+{
+    size_t tap_count { 0 };
+    std::vector<uint32_t> indices;
+    std::vector<float> weights;
+};
+
+double sinc(double x)
+{
+    if (std::abs(x) < 1e-6)
+    {
+        return 1.0;
+    }
+    x *= PI;
+    return std::sin(x) / x;
+}
+
+// the zeroth order modified Bessel function of the first kind
+double bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12)
+        {
+            break;
+        }
+    }
+    return sum;
+}
+
+double filter_radius(resampling_filter filter)
+{
+    switch (filter)
+    {
+    case resampling_filter::box: return 0.5;
+    case resampling_filter::kaiser: return 2.0;
+    case resampling_filter::lanczos: return 3.0;
+    }
+    return 0.5;
+}
+
+double filter_weight(resampling_filter filter, double x)
+{
+    const double radius = filter_radius(filter);
+    if (std::abs(x) > radius)
+    {
+        return 0.0;
+    }
+
+    switch (filter)
+    {
+    case resampling_filter::box: return 1.0;
+    case resampling_filter::kaiser:
+    {
+        double t = x / radius;
+        return sinc(x) * bessel_i0(KAISER_ALPHA * std::sqrt(1.0 - t * t)) /
+               bessel_i0(KAISER_ALPHA);
+    }
+    case resampling_filter::lanczos: return sinc(x) * sinc(x / radius);
+    }
+    return 0.0;
+}
+
+filter_taps
+compute_taps(size_t source_size, size_t target_size, resampling_filter filter)
+{
+    // the filter is stretched over the source pixels when minifying
+    const double scale = static_cast<double>(source_size) / target_size;
+    const double stretch = std::max(scale, 1.0);
+    const double support = filter_radius(filter) * stretch;
+
+    filter_taps result;
+    result.tap_count = static_cast<size_t>(std::ceil(support * 2.0)) + 1;
+    result.indices.resize(target_size * result.tap_count);
+    result.weights.resize(target_size * result.tap_count);
+    for (size_t i = 0; i < target_size; ++i)
+    {
+        const double center = (i + 0.5) * scale;
+        const auto first =
+            static_cast<int64_t>(std::floor(center - support + 0.5));
+        double total = 0.0;
+        for (size_t t = 0; t < result.tap_count; ++t)
+        {
+            const int64_t source = first + static_cast<int64_t>(t);
+            const double weight =
+                filter_weight(filter, (source + 0.5 - center) / stretch);
+            // the pixels over the edges repeat the edge ones
+            result.indices[ i * result.tap_count + t ] =
+                static_cast<uint32_t>(std::clamp<int64_t>(
+                    source, 0, static_cast<int64_t>(source_size) - 1));
+            result.weights[ i * result.tap_count + t ] =
+                static_cast<float>(weight);
+            total += weight;
+        }
+
+        // normalized, so the flat areas stay flat
+        for (size_t t = 0; t < result.tap_count; ++t)
+        {
+            result.weights[ i * result.tap_count + t ] /=
+                static_cast<float>(total);
+        }
+    }
+    return result;
+}
+
+float_image decode(const image& rgba, bool srgb)
+{
+    float_image result { rgba.get_width(), rgba.get_height() };
+    result.pixels.resize(result.width * result.height * 4);
+    const size_t stride = rgba.get_metadata()._bytes_per_row;
+    const auto* source = rgba.get_data<unsigned char>();
+    for_row_ranges(result.height,
+                   result.width * 4,
+                   [ & ](size_t begin, size_t end)
+    {
+        for (size_t y = begin; y < end; ++y)
+        {
+            const uint8_t* row = source + y * stride;
+            float* out = result.pixels.data() + y * result.width * 4;
+            if (srgb)
+            {
+                srgb_to_linear(row, out, result.width * 4);
+            }
+            for (size_t x = 0; x < result.width * 4; ++x)
+            {
+                if (!srgb || x % 4 == 3)
+                {
+                    out[ x ] = row[ x ] / 255.0f;
+                }
+            }
+        }
+    });
+    return result;
+}
+
+std::unique_ptr<image> encode(const float_image& source,
+                              const image::metadata& base,
+                              bool srgb)
+{
+    image::metadata md = base;
+    md._width = source.width;
+    md._height = source.height;
+    auto result = std::make_unique<image>();
+    result->init(md);
+    auto* target =
+        reinterpret_cast<uint8_t*>(result->allocate(source.width * 4));
+    for_row_ranges(source.height,
+                   source.width * 4,
+                   [ & ](size_t begin, size_t end)
+    {
+        for (size_t y = begin; y < end; ++y)
+        {
+            const float* row = source.pixels.data() + y * source.width * 4;
+            uint8_t* out = target + y * source.width * 4;
+            if (srgb)
+            {
+                linear_to_srgb(row, out, source.width * 4);
+            }
+            for (size_t x = 0; x < source.width * 4; ++x)
+            {
+                if (!srgb || x % 4 == 3)
+                {
+                    float value = std::clamp(row[ x ], 0.0f, 1.0f);
+                    out[ x ] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+                }
+            }
+        }
+    });
+    return result;
+}
+
+// one row of the horizontal pass, a whole RGBA pixel per vector
+void resample_row(const float* source,
+                  float* target,
+                  size_t target_width,
+                  const filter_taps& taps)
+{
+    for (size_t x = 0; x < target_width; ++x)
+    {
+        const uint32_t* indices = taps.indices.data() + x * taps.tap_count;
+        const float* weights = taps.weights.data() + x * taps.tap_count;
+#ifdef IMAGE_RESAMPLING_USE_SSE
+        __m128 sum = _mm_setzero_ps();
+        for (size_t t = 0; t < taps.tap_count; ++t)
+        {
+            sum = _mm_add_ps(sum,
+                             _mm_mul_ps(_mm_loadu_ps(source + indices[ t ] * 4),
+                                        _mm_set1_ps(weights[ t ])));
+        }
+        _mm_storeu_ps(target + x * 4, sum);
+#else
+        std::array<float, 4> sum {};
+        for (size_t t = 0; t < taps.tap_count; ++t)
+        {
+            for (size_t c = 0; c < 4; ++c)
+            {
+                sum[ c ] += source[ indices[ t ] * 4 + c ] * weights[ t ];
+            }
+        }
+        std::memcpy(target + x * 4, sum.data(), sizeof(sum));
+#endif
+    }
+}
+
+// accumulates the weighted source row into the target row
+void accumulate_row(const float* source,
+                    float* target,
+                    size_t count,
+                    float weight)
+{
+    size_t i = 0;
+#ifdef IMAGE_RESAMPLING_USE_SSE
+    const __m128 w = _mm_set1_ps(weight);
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(target + i,
+                      _mm_add_ps(_mm_loadu_ps(target + i),
+                                 _mm_mul_ps(_mm_loadu_ps(source + i), w)));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        target[ i ] += source[ i ] * weight;
+    }
+}
+
+float_image resample(const float_image& source,
+                     size_t width,
+                     size_t height,
+                     resampling_filter filter)
+{
+    const filter_taps horizontal = compute_taps(source.width, width, filter);
+    const filter_taps vertical = compute_taps(source.height, height, filter);
+
+    // horizontal pass over all the source rows, then the vertical one over
+    // the whole rows, both split into bands of rows across the threads
+    std::vector<float> intermediate(width * source.height * 4);
+    for_row_ranges(source.height,
+                   width * 4 * sizeof(float),
+                   [ & ](size_t begin, size_t end)
+    {
+        for (size_t y = begin; y < end; ++y)
+        {
+            resample_row(source.pixels.data() + y * source.width * 4,
+                         intermediate.data() + y * width * 4,
+                         width,
+                         horizontal);
+        }
+    });
+
+    float_image result { width, height };
+    result.pixels.resize(width * height * 4);
+    for_row_ranges(height,
+                   width * 4 * sizeof(float),
+                   [ & ](size_t begin, size_t end)
+    {
+        for (size_t y = begin; y < end; ++y)
+        {
+            float* row = result.pixels.data() + y * width * 4;
+            for (size_t t = 0; t < vertical.tap_count; ++t)
+            {
+                const size_t tap = y * vertical.tap_count + t;
+                accumulate_row(intermediate.data() +
+                                   vertical.indices[ tap ] * width * 4,
+                               row,
+                               width * 4,
+                               vertical.weights[ tap ]);
+            }
+        }
+    });
+    return result;
+}
+} // namespace
+
+std::unique_ptr<image> resize_image(const image& img,
+                                    size_t width,
+                                    size_t height,
+                                    resampling_filter filter,
+                                    bool srgb)
+{
+    auto rgba = convert_to_rgba8(img);
+    if (!rgba || width == 0 || height == 0 || rgba->get_width() == 0 ||
+        rgba->get_height() == 0)
+    {
+        return nullptr;
+    }
+
+    float_image linear = decode(*rgba, srgb);
+    return encode(
+        resample(linear, width, height, filter), rgba->get_metadata(), srgb);
+}
+
+std::vector<std::unique_ptr<image>>
+generate_mip_chain(const image& img, resampling_filter filter, bool srgb)
+{
+    std::vector<std::unique_ptr<image>> result;
+    auto rgba = convert_to_rgba8(img);
+    if (!rgba || rgba->get_width() == 0 || rgba->get_height() == 0)
+    {
+        return result;
+    }
+
+    const image::metadata md = rgba->get_metadata();
+    float_image level = decode(*rgba, srgb);
+    result.push_back(std::move(rgba));
+    while (level.width > 1 || level.height > 1)
+    {
+        level = resample(level,
+                         std::max<size_t>(level.width / 2, 1),
+                         std::max<size_t>(level.height / 2, 1),
+                         filter);
+        result.push_back(encode(level, md, srgb));
+    }
+    return result;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+class image;
+
+enum class resampling_filter
+{
+    // the average of the covered pixels, the cheapest one
+    box,
+    // windowed sinc, soft and almost free of ringing, fits the mip chains
+    kaiser,
+    // the sharpest one, fits the magnification and the arbitrary resizing
+    lanczos,
+};
+
+/**
+ * @brief Resize the image with a separable filter
+ *
+ * The filtering is done on the linear values. The color channels of the
+ * sRGB images are decoded before and encoded after, the alpha is always
+ * linear.
+ *
+ * @param img the image of any format supported by @ref convert_to_rgba8
+ * @param width the width of the result
+ * @param height the height of the result
+ * @param filter the filter of the resampling
+ * @param srgb whether the color channels are sRGB encoded
+ * @return std::unique_ptr<image> the 8-bit RGBA result, empty if the format
+ * of the image isn't supported
+ */
+std::unique_ptr<image> resize_image(const image& img,
+                                    size_t width,
+                                    size_t height,
+                                    resampling_filter filter =
+                                        resampling_filter::lanczos,
+                                    bool srgb = true);
+
+/**
+ * @brief Generate the mip chain of the image
+ *
+ * Each level halves the previous one, rounding down, until 1x1 is reached.
+ * The levels are filtered from the linear values of the previous level, so
+ * the quantization doesn't accumulate along the chain.
+ *
+ * @return std::vector<std::unique_ptr<image>> the 8-bit RGBA levels
+ * starting from the base one, the converted image itself. Empty if the
+ * format of the image isn't supported
+ */
+std::vector<std::unique_ptr<image>>
+generate_mip_chain(const image& img,
+                   resampling_filter filter = resampling_filter::kaiser,
+                   bool srgb = true);
@@ -7,30 +7,61 @@ namespace
 static logger log() { return get_logger("light"); }
 } // namespace
 
-light::light() { _lights.push_back(this); }
+light::light()
+{
+    _lights.push_back(this);
+    touch();
+}
 
 light::~light() { std::erase(_lights, this); }
 
 glm::vec3 light::get_color() const { return _color; }
 
-void light::set_color(glm::vec3 color) { _color = color; }
+void light::set_color(glm::vec3 color)
+{
+    _color = color;
+    touch();
+}
 
 float light::get_intensity() const { return _intensity; }
 
-void light::set_intensity(float intensity) { _intensity = intensity; }
+void light::set_intensity(float intensity)
+{
+    _intensity = intensity;
+    touch();
+}
 
 float light::get_radius() const { return _radius; }
 
-void light::set_radius(float radius) { _radius = radius; }
+void light::set_radius(float radius)
+{
+    _radius = radius;
+    touch();
+}
+
+float light::get_range() const
+{
+    return std::max(_radius, std::sqrt(_intensity / attenuation_cutoff));
+}
 
 light::type light::get_type() const { return _light_type; }
 
-void light::set_type(type light_type) { _light_type = light_type; }
+void light::set_type(type light_type)
+{
+    _light_type = light_type;
+    touch();
+}
 
 transform& light::get_transform() { return _transformation; }
 
 const transform& light::get_transform() const { return _transformation; }
 
+uint64_t light::get_version() const { return _version; }
+
 const std::vector<light*>& light::get_all_lights() { return light::_lights; }
 
+void light::touch() { _version = ++_version_counter; }
+
 std::vector<light*> light::_lights;
+
+std::atomic_uint64_t light::_version_counter { 0 };
@@ -31,19 +31,43 @@ public:
     float get_radius() const;
     void set_radius(float radius);
 
+    /**
+     * @brief Get the distance where the contribution of the light fades out
+     *
+     * The range is the distance where the attenuated intensity drops below
+     * @ref attenuation_cutoff, but never less than the light radius.
+     *
+     * @return float the range of the light
+     */
+    float get_range() const;
+
     type get_type() const;
     void set_type(type light_type);
 
     transform& get_transform();
     const transform& get_transform() const;
 
+    /**
+     * @brief Get the stamp of the last modification of the light properties
+     *
+     * The transform is tracked separately by its own version.
+     */
+    uint64_t get_version() const;
+
     static const std::vector<light*>& get_all_lights();
 
+    static constexpr float attenuation_cutoff = 0.01f;
+
+private:
+    void touch();
+
 private:
     transform _transformation;
     glm::vec3 _color { 1.0f, 1.0f, 1.0f };
     float _intensity { 1.0f };
     type _light_type { type::OMNI };
     float _radius = 1.0f;
+    uint64_t _version { 0 };
     static std::vector<light*> _lights;
+    static std::atomic_uint64_t _version_counter;
 };
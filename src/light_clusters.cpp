@@ -0,0 +1,350 @@
+#include "light_clusters.hpp"
+
+#include "camera.hpp"
+#include "light.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define LIGHT_CLUSTERS_USE_SSE
+#    include <emmintrin.h>
+#endif
+
+namespace
+{
+static_assert(light_clusters::grid_width % 4 == 0,
+              "The cluster rows are tested in groups of four");
+
+uint32_t cluster_index(uint32_t x, uint32_t y, uint32_t z)
+{
+    return x + light_clusters::grid_width *
+                   (y + light_clusters::grid_height * z);
+}
+
+#ifdef LIGHT_CLUSTERS_USE_SSE
+// distance from the point to four consequent boxes along a single axis
+inline __m128 axis_distance(const float* min, const float* max, __m128 point)
+{
+    __m128 distance = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(min), point),
+                                 _mm_sub_ps(point, _mm_loadu_ps(max)));
+    return _mm_max_ps(distance, _mm_setzero_ps());
+}
+#endif
+} // namespace
+
+light_clusters::light_clusters()
+{
+    _clusters_buffer.set_element_stride(1);
+    _indices_buffer.set_element_stride(sizeof(uint32_t));
+}
+
+light_clusters::~light_clusters() = default;
+
+void light_clusters::build(
+    const camera& cam, const std::vector<light_registry::light_state>& lights)
+{
+    _view_matrix = cam.frame_view_matrix();
+    _near_plane = cam.get_near_plane();
+    _far_plane = cam.get_far_plane();
+    _screen_size = cam.get_frame_size();
+    update_cluster_bounds(cam);
+
+    _assignments.clear();
+    for (uint32_t i = 0; i < lights.size(); ++i)
+    {
+        const auto& l = lights[ i ].data;
+        if (l.type == static_cast<uint32_t>(light::type::DIRECTIONAL))
+        {
+            assign_global_light(i);
+            continue;
+        }
+
+        glm::vec3 center = _view_matrix * glm::vec4(l.position, 1.0f);
+        assign_light(i, center, l.range);
+    }
+
+    // counting sort of the assignments into the compact per-cluster lists
+    _clusters.assign(cluster_count, { 0, 0 });
+    for (const auto& [ cluster, _ ] : _assignments)
+    {
+        ++_clusters[ cluster ].y;
+    }
+
+    uint32_t offset = 0;
+    for (auto& cluster : _clusters)
+    {
+        cluster.x = offset;
+        offset += cluster.y;
+        cluster.y = 0;
+    }
+
+    _light_indices.resize(_assignments.size());
+    for (const auto& [ cluster, light_index ] : _assignments)
+    {
+        auto& c = _clusters[ cluster ];
+        _light_indices[ c.x + c.y++ ] = light_index;
+    }
+
+    upload();
+}
+
+void light_clusters::bind() const
+{
+    glBindBufferBase(
+        GL_SHADER_STORAGE_BUFFER, 1, _clusters_buffer.get_handle());
+    glBindBufferBase(
+        GL_SHADER_STORAGE_BUFFER, 2, _indices_buffer.get_handle());
+}
+
+std::span<const uint32_t>
+light_clusters::get_cluster_lights(glm::uvec3 cluster) const
+{
+    if (_clusters.empty())
+    {
+        return {};
+    }
+
+    const auto& c = _clusters[ cluster_index(cluster.x, cluster.y, cluster.z) ];
+    return { _light_indices.data() + c.x, c.y };
+}
+
+void light_clusters::update_cluster_bounds(const camera& cam)
+{
+    _projection_matrix = cam.frame_projection_matrix();
+    if (_projection_matrix == _bounds_projection)
+    {
+        return;
+    }
+
+    _bounds_projection = _projection_matrix;
+    for (auto* v : { &_bounds.min_x,
+                     &_bounds.min_y,
+                     &_bounds.min_z,
+                     &_bounds.max_x,
+                     &_bounds.max_y,
+                     &_bounds.max_z })
+    {
+        v->resize(cluster_count);
+    }
+
+    glm::mat4 inverse_projection = glm::inverse(_projection_matrix);
+    auto unproject = [ &inverse_projection ](glm::vec2 ndc, float ndc_depth)
+    {
+        glm::vec4 p = inverse_projection * glm::vec4(ndc, ndc_depth, 1.0f);
+        return glm::vec3(p) / p.w;
+    };
+
+    const glm::vec2 grid { grid_width, grid_height };
+    float depth_ratio = _far_plane / _near_plane;
+    for (uint32_t z = 0; z < grid_depth; ++z)
+    {
+        std::array<float, 2> depths {
+            _near_plane * std::pow(depth_ratio, float(z) / grid_depth),
+            _near_plane * std::pow(depth_ratio, float(z + 1) / grid_depth)
+        };
+
+        for (uint32_t y = 0; y < grid_height; ++y)
+        {
+            for (uint32_t x = 0; x < grid_width; ++x)
+            {
+                glm::vec2 tile_min = glm::vec2 { x, y } / grid * 2.0f - 1.0f;
+                glm::vec2 tile_max =
+                    glm::vec2 { x + 1, y + 1 } / grid * 2.0f - 1.0f;
+                std::array<glm::vec2, 4> corners {
+                    tile_min,
+                    glm::vec2 { tile_max.x, tile_min.y },
+                    tile_max,
+                    glm::vec2 { tile_min.x, tile_max.y },
+                };
+
+                glm::vec3 min { std::numeric_limits<float>::max() };
+                glm::vec3 max { std::numeric_limits<float>::lowest() };
+                for (const auto& corner : corners)
+                {
+                    // intersect the ray through the tile corner with the
+                    // slice planes
+                    glm::vec3 ray_near = unproject(corner, -1.0f);
+                    glm::vec3 ray_far = unproject(corner, 1.0f);
+                    for (float depth : depths)
+                    {
+                        float t = (-depth - ray_near.z) /
+                                  (ray_far.z - ray_near.z);
+                        glm::vec3 p = glm::mix(ray_near, ray_far, t);
+                        min = glm::min(min, p);
+                        max = glm::max(max, p);
+                    }
+                }
+
+                uint32_t i = cluster_index(x, y, z);
+                _bounds.min_x[ i ] = min.x;
+                _bounds.min_y[ i ] = min.y;
+                _bounds.min_z[ i ] = min.z;
+                _bounds.max_x[ i ] = max.x;
+                _bounds.max_y[ i ] = max.y;
+                _bounds.max_z[ i ] = max.z;
+            }
+        }
+    }
+}
+
+void light_clusters::assign_light(uint32_t light_index,
+                                  glm::vec3 center,
+                                  float radius)
+{
+    float depth_min = -center.z - radius;
+    float depth_max = -center.z + radius;
+    if (depth_max < _near_plane || depth_min > _far_plane)
+    {
+        return;
+    }
+
+    float slice_scale = grid_depth / std::log(_far_plane / _near_plane);
+    auto slice_of = [ & ](float depth)
+    {
+        float slice = std::log(std::clamp(depth, _near_plane, _far_plane) /
+                               _near_plane) *
+                      slice_scale;
+        return std::min(static_cast<uint32_t>(std::max(slice, 0.0f)),
+                        grid_depth - 1);
+    };
+
+    uint32_t z0 = slice_of(depth_min);
+    uint32_t z1 = slice_of(depth_max);
+
+    // narrow down the tiles by the screen space bounds of the light sphere.
+    // when the sphere crosses the near plane the projection is unreliable,
+    // so all the tiles are tested
+    glm::uvec2 tile_min { 0, 0 };
+    glm::uvec2 tile_max { grid_width - 1, grid_height - 1 };
+    if (depth_min > _near_plane)
+    {
+        glm::vec2 ndc_min { std::numeric_limits<float>::max() };
+        glm::vec2 ndc_max { std::numeric_limits<float>::lowest() };
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            glm::vec3 offset { corner & 1 ? radius : -radius,
+                               corner & 2 ? radius : -radius,
+                               corner & 4 ? radius : -radius };
+            glm::vec4 clip =
+                _projection_matrix * glm::vec4(center + offset, 1.0f);
+            glm::vec2 ndc = glm::vec2(clip) / clip.w;
+            ndc_min = glm::min(ndc_min, ndc);
+            ndc_max = glm::max(ndc_max, ndc);
+        }
+
+        if (ndc_max.x < -1.0f || ndc_max.y < -1.0f || ndc_min.x > 1.0f ||
+            ndc_min.y > 1.0f)
+        {
+            return;
+        }
+
+        glm::vec2 grid = glm::vec2 { grid_width, grid_height };
+        tile_min = glm::clamp((ndc_min * 0.5f + 0.5f) * grid,
+                              glm::vec2 { 0.0f },
+                              grid - 1.0f);
+        tile_max = glm::clamp((ndc_max * 0.5f + 0.5f) * grid,
+                              glm::vec2 { 0.0f },
+                              grid - 1.0f);
+    }
+
+    float radius_square = radius * radius;
+    for (uint32_t z = z0; z <= z1; ++z)
+    {
+        for (uint32_t y = tile_min.y; y <= tile_max.y; ++y)
+        {
+            uint32_t row = cluster_index(0, y, z);
+#ifdef LIGHT_CLUSTERS_USE_SSE
+            __m128 cx = _mm_set1_ps(center.x);
+            __m128 cy = _mm_set1_ps(center.y);
+            __m128 cz = _mm_set1_ps(center.z);
+            __m128 r2 = _mm_set1_ps(radius_square);
+            for (uint32_t x = tile_min.x & ~3u; x <= tile_max.x; x += 4)
+            {
+                uint32_t i = row + x;
+                __m128 dx = axis_distance(
+                    &_bounds.min_x[ i ], &_bounds.max_x[ i ], cx);
+                __m128 dy = axis_distance(
+                    &_bounds.min_y[ i ], &_bounds.max_y[ i ], cy);
+                __m128 dz = axis_distance(
+                    &_bounds.min_z[ i ], &_bounds.max_z[ i ], cz);
+                __m128 distance_square = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                    _mm_mul_ps(dz, dz));
+                int mask = _mm_movemask_ps(_mm_cmple_ps(distance_square, r2));
+                for (uint32_t lane = 0; lane < 4; ++lane)
+                {
+                    uint32_t tile = x + lane;
+                    if ((mask & (1 << lane)) && tile >= tile_min.x &&
+                        tile <= tile_max.x)
+                    {
+                        _assignments.emplace_back(row + tile, light_index);
+                    }
+                }
+            }
+#else
+            for (uint32_t x = tile_min.x; x <= tile_max.x; ++x)
+            {
+                uint32_t i = row + x;
+                glm::vec3 closest =
+                    glm::clamp(center,
+                               glm::vec3 { _bounds.min_x[ i ],
+                                           _bounds.min_y[ i ],
+                                           _bounds.min_z[ i ] },
+                               glm::vec3 { _bounds.max_x[ i ],
+                                           _bounds.max_y[ i ],
+                                           _bounds.max_z[ i ] });
+                glm::vec3 d = closest - center;
+                if (glm::dot(d, d) <= radius_square)
+                {
+                    _assignments.emplace_back(i, light_index);
+                }
+            }
+#endif
+        }
+    }
+}
+
+void light_clusters::assign_global_light(uint32_t light_index)
+{
+    for (uint32_t i = 0; i < cluster_count; ++i)
+    {
+        _assignments.emplace_back(i, light_index);
+    }
+}
+
+void light_clusters::upload()
+{
+    float depth_ratio = std::log(_far_plane / _near_plane);
+    cluster_header header {
+        _view_matrix,
+        glm::uvec4 { grid_width, grid_height, grid_depth, 0 },
+        glm::vec4 { _near_plane,
+                    _far_plane,
+                    grid_depth / depth_ratio,
+                    -(grid_depth * std::log(_near_plane)) / depth_ratio },
+        glm::vec4 { _screen_size, 0.0f, 0.0f },
+    };
+
+    size_t clusters_size = _clusters.size() * sizeof(glm::uvec2);
+    _upload_buffer.resize(sizeof(cluster_header) + clusters_size);
+    std::memcpy(_upload_buffer.data(), &header, sizeof(cluster_header));
+    std::memcpy(_upload_buffer.data() + sizeof(cluster_header),
+                _clusters.data(),
+                clusters_size);
+
+    // the storage is only reallocated when it grows, the shaders read the
+    // ranges through the header and the cluster offsets
+    _clusters_buffer.set_element_count(_upload_buffer.size());
+    _clusters_buffer.reserve(_upload_buffer.size());
+    _clusters_buffer.set_sub_data(
+        _upload_buffer.data(), 0, _upload_buffer.size());
+
+    // keep the buffer non-empty, so it can always be bound
+    if (_light_indices.empty())
+    {
+        _light_indices.push_back(0);
+    }
+    _indices_buffer.set_element_count(_light_indices.size());
+    _indices_buffer.reserve(_light_indices.size());
+    _indices_buffer.set_sub_data(
+        _light_indices.data(), 0, _light_indices.size());
+}
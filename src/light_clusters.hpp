@@ -0,0 +1,94 @@
+#pragma once
+
+#include "graphics_buffer.hpp"
+#include "light_registry.hpp"
+
+class camera;
+
+/**
+ * @brief Assigns the lights to the clusters of the camera frustum
+ *
+ * The view frustum is split into a grid of tiles on the screen and
+ * exponential slices along the depth. Every light is tested against the
+ * clusters its sphere of influence can reach and the resulting per-cluster
+ * light index lists are uploaded for the fragment shaders. This way a
+ * fragment only iterates over the lights that may affect it.
+ *
+ * Shader side layout:
+ * - binding 1: cluster header (view matrix, grid size, depth slicing
+ *   parameters, screen size) followed by (offset, count) pairs per cluster
+ * - binding 2: light indices referenced by the clusters
+ */
+class light_clusters
+{
+public:
+    static constexpr uint32_t grid_width = 16;
+    static constexpr uint32_t grid_height = 9;
+    static constexpr uint32_t grid_depth = 24;
+    static constexpr uint32_t cluster_count =
+        grid_width * grid_height * grid_depth;
+
+public:
+    light_clusters();
+    ~light_clusters();
+
+    /**
+     * @brief Distribute the lights into the clusters of the camera
+     *
+     * The index of the light in the given vector is the one referenced by the
+     * clusters, so it must match the order of the lights buffer.
+     *
+     * @param cam the camera which frustum is clustered
+     * @param lights the captured states of the lights to distribute
+     */
+    void build(const camera& cam,
+               const std::vector<light_registry::light_state>& lights);
+
+    void bind() const;
+
+    std::span<const uint32_t> get_cluster_lights(glm::uvec3 cluster) const;
+
+private:
+    void update_cluster_bounds(const camera& cam);
+    void assign_light(uint32_t light_index, glm::vec3 center, float radius);
+    void assign_global_light(uint32_t light_index);
+    void upload();
+
+private:
+    struct cluster_header
+    {
+        glm::mat4 view_matrix;
+        glm::uvec4 grid_size;
+        glm::vec4 depth_params;
+        glm::vec4 screen_size;
+    };
+
+    // bounds are kept as structure of arrays, so the consequent clusters of a
+    // row can be tested against a light at once
+    struct cluster_bounds
+    {
+        std::vector<float> min_x;
+        std::vector<float> min_y;
+        std::vector<float> min_z;
+        std::vector<float> max_x;
+        std::vector<float> max_y;
+        std::vector<float> max_z;
+    };
+
+    cluster_bounds _bounds;
+    glm::mat4 _bounds_projection { 0.0f };
+    glm::mat4 _view_matrix { 1.0f };
+    glm::mat4 _projection_matrix { 1.0f };
+    float _near_plane { 0.1f };
+    float _far_plane { 1.0f };
+    glm::uvec2 _screen_size { 1, 1 };
+
+    // (cluster, light) pairs collected during the assignment
+    std::vector<std::pair<uint32_t, uint32_t>> _assignments;
+    std::vector<glm::uvec2> _clusters;
+    std::vector<uint32_t> _light_indices;
+    std::vector<std::byte> _upload_buffer;
+
+    graphics_buffer _clusters_buffer { graphics_buffer::type::shader_storage };
+    graphics_buffer _indices_buffer { graphics_buffer::type::shader_storage };
+};
@@ -0,0 +1,116 @@
+#include "light_registry.hpp"
+
+#include "light.hpp"
+#include "logging.hpp"
+
+namespace
+{
+static logger log() { return get_logger("light_registry"); }
+} // namespace
+
+light_registry::light_registry() = default;
+
+light_registry::~light_registry() = default;
+
+std::vector<light_registry::light_state>
+light_registry::capture(const std::vector<light*>& lights)
+{
+    std::vector<light_state> result;
+    result.reserve(lights.size());
+    for (const light* l : lights)
+    {
+        light_state& state = result.emplace_back();
+        state.owner = l;
+        state.light_version = l->get_version();
+        state.transform_version = l->get_transform().get_version();
+        state.data.position = l->get_transform().get_position();
+        state.data.direction = glm::normalize(
+            l->get_transform().get_rotation() * glm::vec3 { 0, 0, 1 });
+        state.data.color = l->get_color();
+        state.data.intensity = l->get_intensity();
+        state.data.range = l->get_range();
+        state.data.type = static_cast<uint32_t>(l->get_type());
+    }
+    return result;
+}
+
+void light_registry::sync(const std::vector<light_state>& lights)
+{
+    reserve(lights.size());
+    _slots.resize(lights.size());
+    _staging.resize(lights.size());
+
+    // collect the changed lights into contiguous ranges, so each range is
+    // written with a single call
+    size_t range_begin = 0;
+    bool in_range = false;
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        const light_state& l = lights[ i ];
+        light_state& s = _slots[ i ];
+        bool changed = s.owner != l.owner ||
+                       s.light_version != l.light_version ||
+                       s.transform_version != l.transform_version;
+        if (changed)
+        {
+            s = l;
+            _staging[ i ] = l.data;
+            if (!in_range)
+            {
+                range_begin = i;
+                in_range = true;
+            }
+        }
+        else if (in_range)
+        {
+            flush_range(range_begin, i);
+            in_range = false;
+        }
+    }
+
+    if (in_range)
+    {
+        flush_range(range_begin, lights.size());
+    }
+}
+
+void light_registry::bind() const
+{
+    if (!_buffer)
+    {
+        return;
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _buffer->get_handle());
+}
+
+void light_registry::reserve(size_t count)
+{
+    // keep at least one element, so the buffer can always be bound
+    count = std::max<size_t>(count, 1);
+    if (_buffer && count <= _capacity)
+    {
+        return;
+    }
+
+    if (!_buffer)
+    {
+        _buffer = std::make_unique<graphics_buffer>(
+            graphics_buffer::type::shader_storage);
+        _buffer->set_element_stride(sizeof(glsl_light_t));
+        _buffer->set_usage_type(graphics_buffer::usage_type::dynamic_draw);
+    }
+
+    _capacity = std::max(count, _capacity * 2);
+    log()->debug("Growing the lights buffer to {} lights", _capacity);
+    _buffer->set_element_count(_capacity);
+    _buffer->set_data(nullptr);
+
+    // the storage is reallocated, so everything must be uploaded again
+    _slots.clear();
+}
+
+void light_registry::flush_range(size_t begin, size_t end)
+{
+    _buffer->set_sub_data(_staging.data() + begin, begin, end - begin);
+}
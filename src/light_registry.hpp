@@ -0,0 +1,78 @@
+#pragma once
+
+#include "graphics_buffer.hpp"
+
+class light;
+
+/**
+ * @brief Keeps the GPU copy of the lights shared by all the cameras
+ *
+ * The registry remembers which state of every light was uploaded, using the
+ * version stamps of the light and its transform. On @ref sync only the slots
+ * of the lights that changed since the last upload are rewritten, so
+ * rendering the scene from several cameras in the same frame uploads the
+ * lights at most once.
+ *
+ * The lights are synced from their captured states, so the capture can
+ * happen on the game thread while the upload runs on the render thread. The
+ * slot index of a light matches its position in the captured list.
+ */
+class light_registry
+{
+public:
+    struct glsl_light_t
+    {
+        glm::vec3 position;
+        float intensity;
+        glm::vec3 direction;
+        float range;
+        glm::vec3 color;
+        uint32_t type;
+    };
+    static_assert(sizeof(glsl_light_t) == 48,
+                  "The light must match the std430 layout of light_t");
+
+    struct light_state
+    {
+        const light* owner { nullptr };
+        uint64_t light_version { 0 };
+        uint64_t transform_version { 0 };
+        glsl_light_t data {};
+    };
+
+public:
+    light_registry();
+    ~light_registry();
+
+    /**
+     * @brief Capture the current state of the lights
+     *
+     * @param lights the lights to capture
+     * @return std::vector<light_state> the states in the order of the lights
+     */
+    static std::vector<light_state>
+    capture(const std::vector<light*>& lights);
+
+    /**
+     * @brief Upload the changed lights into the lights buffer
+     *
+     * @param lights the captured states of the lights
+     */
+    void sync(const std::vector<light_state>& lights);
+
+    /**
+     * @brief Bind the lights buffer to the shader storage binding 0
+     */
+    void bind() const;
+
+private:
+    void reserve(size_t count);
+    void flush_range(size_t begin, size_t end);
+
+private:
+    std::vector<light_state> _slots;
+    std::vector<glsl_light_t> _staging;
+    // created lazily, as the scene may outlive or precede the GL context
+    std::unique_ptr<graphics_buffer> _buffer { nullptr };
+    size_t _capacity { 0 };
+};
@@ -18,7 +18,6 @@
 #include "experimental/window.hpp"
 #include "experimental/window_events.hpp"
 #include "feature_flags.hpp"
-#include "file.hpp"
 #include "font.hpp"
 #include "game_clock.hpp"
 #include "game_object.hpp"
@@ -28,6 +27,7 @@
 #include "logging.hpp"
 #include "material.hpp"
 #include "physics_engine.hpp"
+#include "render_thread.hpp"
 #include "scene.hpp"
 #include "shader.hpp"
 #include "texture.hpp"
@@ -97,10 +97,8 @@ int main(int argc, char** argv)
         }
     }
 
-    file mat_file("resources/standard/basic.mat");
-    mat_file.changed_externally +=
-        [](file::event_type et) { log()->info("material file changed"); };
-    mat_file.watch();
+    // the edited shaders, materials and images are reloaded while running
+    asset_manager::default_asset_manager()->watch_assets("resources");
 
     // start a physics thread
     // TODO: these should move into physics engine class
@@ -131,10 +129,6 @@ int main(int argc, char** argv)
 
     int trigger_show = -1;
 
-    auto wh = file::watch("./",
-                          [](auto path, auto change)
-    { log()->info("Path {} changed: {}", path, static_cast<int>(change)); });
-
     experimental::input_system::on_keypress += [ &trigger_show ](int keycode)
     {
         if (keycode == GLFW_KEY_ENTER)
@@ -186,18 +180,88 @@ int main(int argc, char** argv)
         }
     };
 
+    // the texture viewer and the texture cloning still issue GL calls from
+    // this thread, so those are not available with the threaded rendering
+    std::unique_ptr<render_thread> renderer { nullptr };
+    if (feature_flags::get_flag(feature_flags::flag_name::threaded_rendering))
+    {
+        glfwMakeContextCurrent(nullptr);
+        renderer = std::make_unique<render_thread>();
+    }
+
     while (!windows.empty())
     {
+        // the loads create the objects and swap the reloaded assets, so with
+        // the threaded rendering they are finished between the frames, while
+        // the rendering is idle
+        auto* am = asset_manager::default_asset_manager();
+        if (renderer && am->has_loaded_assets())
+        {
+            renderer->wait_idle();
+            windows.front()->activate();
+            am->process_loaded_assets();
+            // the commands must reach the rendering context
+            glFlush();
+            glfwMakeContextCurrent(nullptr);
+        }
+
         for (auto obj : scene::get_active_scene()->objects())
         {
             obj->update();
         }
 
-        for (int i = 0; i < windows.size(); ++i)
+        // the picks resolved by the rendering of the previous frames
+        for (auto* cam : camera::all_cameras())
+        {
+            cam->get_picker().dispatch();
+        }
+
+        auto packet = frame_packet::extract(scene::get_active_scene());
+        if (renderer)
+        {
+            renderer->submit(packet,
+                             [ frame_windows = windows ]
+            {
+                // the contexts of the windows share the uploaded textures
+                frame_windows.front()->activate();
+                asset_manager::default_asset_manager()->process_uploads();
+                for (const auto& window : frame_windows)
+                {
+                    window->render();
+                }
+                // the windows are destroyed on the main thread, which is
+                // not allowed while their context is current here
+                glfwMakeContextCurrent(nullptr);
+            });
+
+            for (const auto& window : windows)
+            {
+                if (window->should_close())
+                {
+                    // the closed window must not be rendered anymore
+                    renderer->wait_idle();
+                    break;
+                }
+            }
+
+            for (int i = 0; i < windows.size(); ++i)
+            {
+                windows[ i ]->process_events();
+            }
+        }
+        else
         {
-            auto p = prof::profile_frame(__FUNCTION__);
-            auto window = windows[ i ];
-            window->update();
+            // the assets loaded in the background are finished with the
+            // context of the main thread
+            am->process_loaded_assets();
+            frame_packet::set_current(packet);
+            for (int i = 0; i < windows.size(); ++i)
+            {
+                auto p = prof::profile_frame(__FUNCTION__);
+                auto window = windows[ i ];
+                window->update();
+            }
+            frame_packet::set_current(nullptr);
         }
         clock->frame();
 
@@ -227,6 +291,7 @@ int main(int argc, char** argv)
         return true;
     });
     std::cout << std::flush;
+    renderer = nullptr;
     program_exits = true;
     glfwTerminate();
     thd.join();
@@ -285,6 +350,8 @@ void initViewports()
         vp->initialize();
         vp->set_camera(cam);
         cam->set_ortho(true);
+        // the debug views are small, the post-process pass is enough
+        cam->set_anti_aliasing(camera::anti_aliasing::fxaa);
         wnd->add_viewport(vp);
         wnd->get_events()->mouse_scroll += [ cam, vp ](auto we)
         {
@@ -379,14 +446,31 @@ void setupMouseEvents()
                                            me.get_sender()->get_width(),
                                            me.get_sender()->get_height() });
             cast_ray->set_ray(pos, glm::normalize(point - pos));
+        }
+    };
 
-            auto hit = p.raycast(pos, glm::normalize(point - pos));
+    experimental::window::get_main_window()->get_events()->mouse_press +=
+        [](auto me)
+    {
+        if (me.get_sender()->get_has_grab())
+        {
+            return;
+        }
 
-            if (hit.has_value())
+        // picked against the rendered geometry, the result arrives with one
+        // of the next frames
+        glm::uvec2 position { me.get_local_position().x,
+                              me.get_sender()->get_height() - 1 -
+                                  me.get_local_position().y };
+        me.get_sender()->get_viewports()[ 0 ]->get_camera()->get_picker().pick(
+            position,
+            [](std::vector<game_object*> objects)
+        {
+            for (auto* obj : objects)
             {
-                // log()->info("hit collider");
+                log()->info("Picked object {}", obj->get_name());
             }
-        }
+        });
     };
 }
 
@@ -395,18 +479,10 @@ void initScene()
     feature_flags::set_flag(feature_flags::flag_name::load_fbx_as_scene, false);
     auto* am = asset_manager::default_asset_manager();
     material* basic_mat = am->get_material("basic");
-    txt = new texture();
-    image* img = am->get_image("albedo");
-    *txt = std::move(texture::from_image(img));
-    norm_txt = new texture();
-    img = am->get_image("brick");
-    *norm_txt = std::move(texture::from_image(img));
-    auto roughness_txt = new texture;
-    img = am->get_image("roughness");
-    *roughness_txt = std::move(texture::from_image(img));
-    auto metallic_txt = new texture;
-    img = am->get_image("metallic");
-    *metallic_txt = std::move(texture::from_image(img));
+    txt = am->get_texture("albedo");
+    norm_txt = am->get_texture("brick");
+    auto roughness_txt = am->get_texture("roughness");
+    auto metallic_txt = am->get_texture("metallic");
     basic_mat->set_property_value("u_albedo_texture", txt);
     basic_mat->set_property_value("u_albedo_texture_strength", 1.0f);
     basic_mat->set_property_value("u_normal_texture", norm_txt);
@@ -507,22 +583,27 @@ void initScene()
 void load_internal_resources()
 {
     auto* am = asset_manager::default_asset_manager();
-    am->load_asset("resources/internal/camera_background.shader");
+    // decoded in parallel while the shaders and the materials are loaded here
+    for (std::string_view path : { "resources/meshes/cube.fbx",
+                                   "resources/meshes/sphere.fbx",
+                                   "resources/meshes/susane_head.fbx",
+                                   "resources/meshes/shader_ball.fbx",
+                                   "resources/meshes/camera.fbx",
+                                   "resources/images/sample.png",
+                                   "resources/images/brick.png",
+                                   "resources/images/diffuse.png",
+                                   "resources/images/albedo.jpg",
+                                   "resources/images/metallic.jpg",
+                                   "resources/images/roughness.jpg",
+                                   "resources/images/env.jpg" })
+    {
+        am->load_asset_async(path);
+    }
 
-    am->load_asset("resources/meshes/cube.fbx");
-    am->load_asset("resources/meshes/sphere.fbx");
-    am->load_asset("resources/meshes/susane_head.fbx");
-    am->load_asset("resources/meshes/shader_ball.fbx");
-    am->load_asset("resources/meshes/camera.fbx");
+    am->load_asset("resources/internal/camera_background.shader");
     am->load_asset("resources/standard/text.mat");
     am->load_asset("resources/standard/basic.mat");
-    am->load_asset("resources/images/sample.png");
-    am->load_asset("resources/images/brick.png");
-    am->load_asset("resources/images/diffuse.png");
-    am->load_asset("resources/images/albedo.jpg");
-    am->load_asset("resources/images/metallic.jpg");
-    am->load_asset("resources/images/roughness.jpg");
-    am->load_asset("resources/images/env.jpg");
+    am->wait_for_loads();
 }
 
 void initProfilerView()
@@ -1,5 +1,8 @@
+#include <shared_mutex>
+
 #include "material.hpp"
 
+#include "asset_manager.hpp"
 #include "logging.hpp"
 #include "shader.hpp"
 #include "texture.hpp"
@@ -7,37 +10,237 @@
 namespace
 {
 static inline logger log() { return get_logger("material"); }
+
+// guards the values of all the materials, the game thread changes those
+// while the frame packets copy them and the reloads replace them
+std::shared_mutex& values_mutex()
+{
+    static std::shared_mutex mutex;
+    return mutex;
+}
+
+// the mask of the features enabled by the values of the properties
+uint32_t enabled_features(
+    shader_program* prog,
+    const std::function<const material_property*(std::string_view)>& find)
+{
+    uint32_t features = 0;
+    const auto& declared = prog->get_features();
+    for (size_t i = 0; i < declared.size(); ++i)
+    {
+        const material_property* property = find(declared[ i ].property);
+        if (!property || !property->_value.has_value())
+        {
+            continue;
+        }
+
+        const std::any& value = property->_value;
+        bool enabled = true;
+        if (value.type() == typeid(float))
+        {
+            enabled = std::any_cast<float>(value) != 0.0f;
+        }
+        else if (value.type() == typeid(std::tuple<float>))
+        {
+            enabled = std::get<0>(std::any_cast<std::tuple<float>>(value)) !=
+                      0.0f;
+        }
+
+        if (enabled)
+        {
+            features |= uint32_t { 1 } << i;
+        }
+    }
+    return features;
+}
+
+shader_program* select_program(shader_program* variant, shader_program* base)
+{
+    if (!variant->is_ready())
+    {
+        // draw with the placeholder instead of stalling on the compiler
+        if (auto* placeholder =
+                asset_manager::default_asset_manager()->get_shader(
+                    "placeholder"))
+        {
+            return placeholder;
+        }
+
+        return variant;
+    }
+
+    // the failed variant stays cached, so the fallback to the program with
+    // all the features lasts until the shader is reloaded
+    return variant->failed() ? base : variant;
+}
+
+void set_property_uniform(shader_program* program,
+                          const material_property& property)
+{
+    if (!property._value.has_value())
+    {
+        return;
+    }
+
+    if (property._type == material_property::data_type::type_image)
+    {
+        auto* t = std::any_cast<texture*>(property._value);
+        t->set_active_texture(property._special);
+        program->set_uniform(property._name, property._special);
+    }
+    else
+    {
+        program->set_uniform(property._name, property._value);
+    }
+}
 } // namespace
 
+bool material::snapshot::activate(
+    const std::function<void(shader_program&)>& set_draw_uniforms) const
+{
+    if (!program)
+    {
+        return false;
+    }
+
+    // resolved here, the program may be reloaded after the capture
+    uint32_t features = enabled_features(
+        program,
+        [ this ](std::string_view name) -> const material_property*
+    {
+        auto it = std::find_if(properties.begin(),
+                               properties.end(),
+                               [ name ](const material_property& property)
+        { return property._name == name; });
+        return it != properties.end() ? &*it : nullptr;
+    });
+
+    shader_program* prog =
+        select_program(program->get_variant(features), program);
+    for (const auto& property : properties)
+    {
+        set_property_uniform(prog, property);
+    }
+
+    if (set_draw_uniforms)
+    {
+        set_draw_uniforms(*prog);
+    }
+    prog->use();
+    return true;
+}
+
 material::material() = default;
 
+material::material(const material* parent)
+    : _parent(parent)
+    , _textures_count(parent->_textures_count)
+{
+}
+
 material::material(material&& mat)
 {
+    _parent = mat._parent;
     _shader_program = mat._shader_program;
+    _variant = mat._variant;
+    _variant_base = mat._variant_base;
+    _variant_features = mat._variant_features;
+    _variant_revision = mat._variant_revision;
     _property_map = std::move(mat._property_map);
+    _textures_count = mat._textures_count;
+    mat._parent = nullptr;
     mat._shader_program = 0;
+    mat._variant = nullptr;
 }
 
 material& material::operator=(material&& mat)
 {
+    _parent = mat._parent;
     _shader_program = mat._shader_program;
+    _variant = mat._variant;
+    _variant_base = mat._variant_base;
+    _variant_features = mat._variant_features;
+    _variant_revision = mat._variant_revision;
     _property_map = std::move(mat._property_map);
+    _textures_count = mat._textures_count;
+    mat._parent = nullptr;
     mat._shader_program = 0;
+    mat._variant = nullptr;
     return *this;
 }
 
 material::~material() = default;
 
-shader_program* material::program() const { return _shader_program; }
+void material::reload(material&& fresh)
+{
+    std::unique_lock lock { values_mutex() };
+    // the values assigned at runtime, e.g. the textures, aren't part of the
+    // material file
+    for (auto& [ name, property ] : _property_map)
+    {
+        if (!property._value.has_value())
+        {
+            continue;
+        }
+
+        if (auto it = fresh._property_map.find(name);
+            it != fresh._property_map.end() && !it->second._value.has_value())
+        {
+            it->second._value = std::move(property._value);
+        }
+    }
+
+    *this = std::move(fresh);
+}
+
+shader_program* material::program() const
+{
+    std::shared_lock lock { values_mutex() };
+    return find_program();
+}
 
 void material::set_shader_program(shader_program* prog)
 {
+    std::unique_lock lock { values_mutex() };
     _shader_program = prog;
+    _variant = nullptr;
+}
+
+const material* material::get_parent() const
+{
+    std::shared_lock lock { values_mutex() };
+    return _parent;
+}
+
+const material* material::get_base() const
+{
+    std::shared_lock lock { values_mutex() };
+    const material* base = this;
+    while (base->_parent)
+    {
+        base = base->_parent;
+    }
+    return base;
+}
+
+uint32_t material::get_shader_features() const
+{
+    std::shared_lock lock { values_mutex() };
+    shader_program* prog = find_program();
+    if (!prog)
+    {
+        return 0;
+    }
+
+    return enabled_features(prog,
+                            [ this ](std::string_view name)
+    { return find_property(name); });
 }
 
 void material::declare_property(std::string_view name,
                                 material_property::data_type type)
 {
+    std::unique_lock lock { values_mutex() };
     material_property property;
     property._name = name;
     property._type = type;
@@ -62,43 +265,118 @@ void material::declare_property(std::string_view name,
 
 bool material::has_property(std::string_view name) const
 {
-    return _property_map.contains(name);
+    std::shared_lock lock { values_mutex() };
+    return find_property(name) != nullptr;
 }
 
 void material::set_property_value(std::string_view name, std::any value)
 {
-    if (!has_property(name))
+    std::unique_lock lock { values_mutex() };
+    // not using unordered_map.at to have generic string comparison
+    property_map_t::iterator found_iterator = _property_map.find(name);
+    if (found_iterator == _property_map.end())
     {
-        log()->error("The material has no property \"{}\"", name);
-        return;
+        const material_property* inherited =
+            _parent ? _parent->find_property(name) : nullptr;
+        if (!inherited)
+        {
+            log()->error("The material has no property \"{}\"", name);
+            return;
+        }
+
+        // copy on write, the instance stores only the overridden properties
+        found_iterator =
+            _property_map.try_emplace(std::string(name), *inherited).first;
     }
 
-    // not using unordered_map.at to have generic string comparison
-    property_map_t::iterator found_iterator = _property_map.find(name);
     found_iterator->second._value = std::move(value);
 }
 
-void material::activate() const
+shader_program* material::find_program() const
 {
-    for (const auto& [ name, property ] : _property_map)
+    if (!_shader_program && _parent)
     {
-        if (!property._value.has_value())
-        {
-            continue;
-        }
+        return _parent->find_program();
+    }
+    return _shader_program;
+}
+
+const material_property*
+material::find_property(std::string_view name) const
+{
+    if (auto it = _property_map.find(name); it != _property_map.end())
+    {
+        return &it->second;
+    }
+    return _parent ? _parent->find_property(name) : nullptr;
+}
+
+void material::visit_properties(
+    const std::function<void(const material_property&)>& visitor) const
+{
+    for (const auto& [ _, property ] : _property_map)
+    {
+        visitor(property);
+    }
 
-        if (property._type == material_property::data_type::type_image)
+    if (_parent)
+    {
+        _parent->visit_properties(
+            [ & ](const material_property& property)
         {
-            auto* t = std::any_cast<texture*>(property._value);
-            t->set_active_texture(property._special);
-            _shader_program->set_uniform(name, property._special);
-        }
-        else
+            // overridden by this material
+            if (!_property_map.contains(property._name))
+            {
+                visitor(property);
+            }
+        });
+    }
+}
+
+material::snapshot material::capture() const
+{
+    std::shared_lock lock { values_mutex() };
+    snapshot result;
+    result.program = find_program();
+    visit_properties(
+        [ &result ](const material_property& property)
+    {
+        if (property._value.has_value())
         {
-            _shader_program->set_uniform(name, property._value);
+            result.properties.push_back(property);
         }
-    }
-    _shader_program->use();
+    });
+    return result;
+}
+
+void material::activate() const
+{
+    std::shared_lock lock { values_mutex() };
+    shader_program* program =
+        select_program(active_program(), find_program());
+    visit_properties([ program ](const material_property& property)
+    { set_property_uniform(program, property); });
+    program->use();
 }
 
 void material::deactivate() const { shader_program::unuse(); }
+
+shader_program* material::active_program() const
+{
+    // the features may also change through the parent, so the mask is
+    // compared instead of tracking the writes
+    shader_program* prog = find_program();
+    uint32_t features = enabled_features(prog,
+                                         [ this ](std::string_view name)
+    { return find_property(name); });
+    if (!_variant || prog != _variant_base ||
+        features != _variant_features ||
+        prog->get_revision() != _variant_revision)
+    {
+        _variant = prog->get_variant(features);
+        _variant_base = prog;
+        _variant_features = features;
+        _variant_revision = prog->get_revision();
+    }
+    return _variant;
+}
@@ -5,8 +5,40 @@
 
 class shader_program;
 
+/**
+ * @brief The shader program with the values of its parameters
+ *
+ * A material may be an instance of a parent material. The instance shares
+ * the program and the parameter values of the parent and stores only the
+ * parameters it overrides, copied from the parent on the first write.
+ */
 class material
 {
+public:
+    /**
+     * @brief Copy of the values the material is rendered with
+     *
+     * Captured into the frame packet on the game thread, so the rendering
+     * never reads the material while the game changes it.
+     */
+    struct snapshot
+    {
+        shader_program* program = nullptr;
+        // the properties having a value, the overrides of the instance
+        // included
+        std::vector<material_property> properties;
+
+        /**
+         * @brief Use the program with the captured values
+         *
+         * @param set_draw_uniforms sets the values specific to the draw, like
+         * the model matrix, right before the program is used
+         * @return false if there is no program to draw with
+         */
+        bool activate(const std::function<void(shader_program&)>&
+                          set_draw_uniforms = {}) const;
+    };
+
 private:
     using property_map_t = std::unordered_map<std::string,
                                               material_property,
@@ -15,15 +47,49 @@ private:
 
 public:
     material();
+    /**
+     * @brief Create an instance of the parent material
+     *
+     * @param parent the material providing the program and the defaults, must
+     * outlive the instance
+     */
+    explicit material(const material* parent);
     material(material&& mat);
     material(const material& mat) = delete;
     material& operator=(material&& mat);
     material& operator=(const material& mat) = delete;
     ~material();
 
+    /**
+     * @brief Take over the definition of the reloaded material
+     *
+     * The material stays at its address, so the renderers and the instances
+     * keep using it. The properties left unset by the new definition keep the
+     * values assigned to them so far.
+     *
+     * @param fresh the material loaded from the changed file
+     */
+    void reload(material&& fresh);
+
     shader_program* program() const;
     void set_shader_program(shader_program* prog);
 
+    const material* get_parent() const;
+    /**
+     * @brief Get the root of the instance chain, the material itself if it's
+     * not an instance
+     */
+    const material* get_base() const;
+
+    /**
+     * @brief Get the mask of the shader features the material uses
+     *
+     * A feature is used when the material sets its controlling property to a
+     * non-zero value. The rest of the features are compiled out of the
+     * program the material is rendered with.
+     */
+    uint32_t get_shader_features() const;
+
     void declare_property(std::string_view name,
                           material_property::data_type type);
 
@@ -41,14 +107,33 @@ public:
         set_property_value(name, std::any { element });
     }
 
+    /**
+     * @brief Copy the current values of the material
+     *
+     * May be called concurrently with the changes of the material.
+     */
+    snapshot capture() const;
+
     void activate() const;
     void deactivate() const;
 
 private:
     void set_property_value(std::string_view name, std::any value);
+    shader_program* find_program() const;
+    const material_property* find_property(std::string_view name) const;
+    void visit_properties(
+        const std::function<void(const material_property&)>& visitor) const;
+    shader_program* active_program() const;
 
 private:
-    shader_program* _shader_program;
+    const material* _parent = nullptr;
+    shader_program* _shader_program = nullptr;
+    // the program variant is selected lazily after the features change
+    mutable shader_program* _variant = nullptr;
+    // the program the variant was taken from, the parent may switch it
+    mutable shader_program* _variant_base = nullptr;
+    mutable uint32_t _variant_features = 0;
+    mutable unsigned _variant_revision = 0;
     property_map_t _property_map;
     unsigned _textures_count = 0;
 };
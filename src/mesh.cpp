@@ -1,7 +1,23 @@
 #include "mesh.hpp"
 
+#include "logging.hpp"
+#include "renderer/algorithms/mesh_simplification.hpp"
+
+namespace
+{
+static logger log() { return get_logger("mesh"); }
+} // namespace
+
 void mesh::init()
 {
+    calculate_bounds();
+    init(_bounds);
+}
+
+void mesh::init(const bounding_sphere& bounds)
+{
+    _bounds = bounds;
+
     _vbo.set_element_stride(vertex3d::size);
     _vbo.set_element_count(_vertices.size());
     _vbo.set_data(_vertices.data());
@@ -11,6 +27,21 @@ void mesh::init()
     _ebo.set_data(_indices.data());
 }
 
+void mesh::init(std::span<const std::byte> vertex_data,
+                std::span<const std::byte> index_data,
+                const bounding_sphere& bounds)
+{
+    _bounds = bounds;
+
+    _vbo.set_element_stride(vertex3d::size);
+    _vbo.set_element_count(vertex_data.size() / vertex3d::size);
+    _vbo.set_data(vertex_data.data());
+
+    _ebo.set_element_stride(sizeof(int));
+    _ebo.set_element_count(index_data.size() / sizeof(int));
+    _ebo.set_data(index_data.data());
+}
+
 void mesh::set_vertices(std::vector<vertex3d> positions)
 {
     _vertices = std::move(positions);
@@ -26,6 +57,149 @@ void mesh::set_submeshes(std::vector<submesh_info> submeshes)
     _submeshes = std::move(submeshes);
 }
 
+void mesh::generate_lods(const std::vector<lod_level>& levels)
+{
+    _lods.clear();
+    _lod_screen_sizes.clear();
+
+    // the index ranges of the submeshes, each one up to the next one
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (size_t i = 0; i < _submeshes.size(); ++i)
+    {
+        ranges.push_back({ _submeshes[ i ].vertex_index_offset,
+                           i + 1 < _submeshes.size()
+                               ? _submeshes[ i + 1 ].vertex_index_offset
+                               : _indices.size() });
+    }
+    if (ranges.empty())
+    {
+        ranges.push_back({ 0, _indices.size() });
+    }
+
+    // the positions used by several submeshes form the seams between them,
+    // which must stay in place for the simplified submeshes to meet
+    std::unordered_map<glm::vec3, size_t> position_range;
+    std::vector<bool> locked(_vertices.size(), false);
+    for (size_t r = 0; r < ranges.size(); ++r)
+    {
+        for (size_t i = ranges[ r ].first; i < ranges[ r ].second; ++i)
+        {
+            auto [ it, inserted ] = position_range.try_emplace(
+                _vertices[ _indices[ i ] ].position(), r);
+            if (!inserted && it->second != r)
+            {
+                it->second = ranges.size();
+            }
+        }
+    }
+    for (size_t v = 0; v < _vertices.size(); ++v)
+    {
+        auto it = position_range.find(_vertices[ v ].position());
+        locked[ v ] = it != position_range.end() && it->second == ranges.size();
+    }
+
+    size_t previous_index_count = _indices.size();
+    for (const auto& level : levels)
+    {
+        // the submeshes are simplified on their own, so no triangle moves
+        // over to another material
+        std::vector<vertex3d> vertices;
+        std::vector<int> indices;
+        std::vector<submesh_info> submeshes;
+        float error = 0.0f;
+        for (size_t r = 0; r < ranges.size(); ++r)
+        {
+            std::vector<int> range_indices(_indices.begin() + ranges[ r ].first,
+                                           _indices.begin() +
+                                               ranges[ r ].second);
+            std::vector<vertex3d> range_vertices;
+            std::vector<int> simplified;
+            error = std::max(error,
+                             simplify_mesh(_vertices,
+                                           range_indices,
+                                           level.max_error * _bounds.radius,
+                                           range_vertices,
+                                           simplified,
+                                           &locked));
+
+            if (!_submeshes.empty())
+            {
+                submeshes.push_back(
+                    { indices.size(), _submeshes[ r ].material_index });
+            }
+
+            const int base = static_cast<int>(vertices.size());
+            vertices.insert(
+                vertices.end(), range_vertices.begin(), range_vertices.end());
+            for (int index : simplified)
+            {
+                indices.push_back(base + index);
+            }
+        }
+
+        // not worth an extra level if it doesn't reduce the triangle count
+        // noticeably
+        if (indices.empty() || indices.size() * 10 > previous_index_count * 9)
+        {
+            continue;
+        }
+
+        log()->debug("LOD {}: {} -> {} triangles (error {})",
+                     _lods.size() + 1,
+                     _indices.size() / 3,
+                     indices.size() / 3,
+                     error);
+        previous_index_count = indices.size();
+
+        auto lod = std::make_unique<mesh>();
+        lod->set_vertices(std::move(vertices));
+        lod->set_indices(std::move(indices));
+        lod->set_submeshes(std::move(submeshes));
+        lod->init();
+        _lods.push_back(std::move(lod));
+        _lod_screen_sizes.push_back(level.screen_size);
+    }
+}
+
+void mesh::add_lod(std::unique_ptr<mesh> lod, float screen_size)
+{
+    _lods.push_back(std::move(lod));
+    _lod_screen_sizes.push_back(screen_size);
+}
+
+size_t mesh::get_lod_count() const { return _lods.size() + 1; }
+
+mesh* mesh::get_lod(size_t index)
+{
+    if (index == 0 || _lods.empty())
+    {
+        return this;
+    }
+
+    return _lods[ std::min(index, _lods.size()) - 1 ].get();
+}
+
+float mesh::get_lod_screen_size(size_t index) const
+{
+    if (index == 0 || _lod_screen_sizes.empty())
+    {
+        return std::numeric_limits<float>::max();
+    }
+
+    return _lod_screen_sizes[ std::min(index, _lod_screen_sizes.size()) - 1 ];
+}
+
+const mesh::bounding_sphere& mesh::get_bounds() const { return _bounds; }
+
+const std::vector<vertex3d>& mesh::get_vertices() const { return _vertices; }
+
+const std::vector<int>& mesh::get_indices() const { return _indices; }
+
+const std::vector<mesh::submesh_info>& mesh::get_submeshes() const
+{
+    return _submeshes;
+}
+
 void mesh::render()
 {
     if (_vao.activate())
@@ -36,10 +210,46 @@ void mesh::render()
     }
 
     vertex3d::activate_attributes();
-    glDrawElements(GL_TRIANGLES, _indices.size(), GL_UNSIGNED_INT, 0);
+    glDrawElements(
+        GL_TRIANGLES, _ebo.get_element_count(), GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
 }
 
 const graphics_buffer& mesh::get_vertex_buffer() const { return _vbo; }
 
 const graphics_buffer& mesh::get_index_buffer() const { return _ebo; }
+
+const std::vector<mesh::lod_level>& mesh::default_lod_levels()
+{
+    static const std::vector<lod_level> levels {
+        { 0.005f, 0.5f },
+        { 0.02f, 0.25f },
+        { 0.05f, 0.1f },
+    };
+    return levels;
+}
+
+void mesh::calculate_bounds()
+{
+    if (_vertices.empty())
+    {
+        _bounds = {};
+        return;
+    }
+
+    glm::vec3 min = _vertices.front().position();
+    glm::vec3 max = min;
+    for (const auto& v : _vertices)
+    {
+        min = glm::min(min, v.position());
+        max = glm::max(max, v.position());
+    }
+
+    _bounds.center = (min + max) * 0.5f;
+    _bounds.radius = 0.0f;
+    for (const auto& v : _vertices)
+    {
+        _bounds.radius = std::max(_bounds.radius,
+                                  glm::distance(_bounds.center, v.position()));
+    }
+}
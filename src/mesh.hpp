@@ -15,13 +15,83 @@ public:
         unsigned short material_index;
     };
 
+    struct bounding_sphere
+    {
+        glm::vec3 center { 0.0f, 0.0f, 0.0f };
+        float radius { 0.0f };
+    };
+
+    /**
+     * @brief Description of a single level of detail
+     *
+     * The level is used while the projected size of the mesh on the screen
+     * (the fraction of the screen height it covers) is below @ref
+     * screen_size.
+     */
+    struct lod_level
+    {
+        // maximum allowed deviation relative to the bounding sphere radius
+        float max_error;
+        float screen_size;
+    };
+
 public:
     void init();
+    /**
+     * @brief Initialize with the known bounds, skips their calculation
+     */
+    void init(const bounding_sphere& bounds);
+    /**
+     * @brief Upload the raw geometry without keeping a copy of it
+     *
+     * For the meshes that are only drawn, e.g. the levels of detail loaded
+     * from a cache. The vertices and the indices of the mesh stay empty.
+     *
+     * @param vertex_data the tightly packed vertices
+     * @param index_data the indices
+     * @param bounds the bounds of the geometry
+     */
+    void init(std::span<const std::byte> vertex_data,
+              std::span<const std::byte> index_data,
+              const bounding_sphere& bounds);
 
     void set_vertices(std::vector<vertex3d> positions);
     void set_indices(std::vector<int> indices);
     void set_submeshes(std::vector<submesh_info> submeshes);
 
+    /**
+     * @brief Build the chain of simplified meshes
+     *
+     * Each level is simplified from the full resolution mesh. Every submesh
+     * is simplified on its own, with the vertices on the seams between the
+     * submeshes kept in place, and the levels get the matching submeshes.
+     * Levels that can't be simplified any further than the previous one are
+     * dropped.
+     *
+     * @param levels the levels ordered from the finest to the coarsest
+     */
+    void generate_lods(const std::vector<lod_level>& levels);
+
+    /**
+     * @brief Append a prebuilt level of detail, e.g. loaded from a cache
+     *
+     * @param lod the initialized mesh of the level
+     * @param screen_size the screen size below which the level is used
+     */
+    void add_lod(std::unique_ptr<mesh> lod, float screen_size);
+
+    /**
+     * @brief Get the number of the levels of detail including the mesh itself
+     */
+    size_t get_lod_count() const;
+    mesh* get_lod(size_t index);
+    float get_lod_screen_size(size_t index) const;
+
+    const bounding_sphere& get_bounds() const;
+    const std::vector<vertex3d>& get_vertices() const;
+    const std::vector<int>& get_indices() const;
+    const std::vector<submesh_info>& get_submeshes() const;
+
     // TODO: not the best approach
     // SUGGESTION: move the logic into the renderer class. The last will also
     // manage the vao creation per context
@@ -30,10 +100,18 @@ public:
     const graphics_buffer& get_vertex_buffer() const;
     const graphics_buffer& get_index_buffer() const;
 
+    static const std::vector<lod_level>& default_lod_levels();
+
+private:
+    void calculate_bounds();
+
 private:
     std::vector<vertex3d> _vertices;
     std::vector<int> _indices;
     std::vector<submesh_info> _submeshes;
+    bounding_sphere _bounds;
+    std::vector<std::unique_ptr<mesh>> _lods;
+    std::vector<float> _lod_screen_sizes;
 
     vao_map _vao;
     graphics_buffer _vbo { graphics_buffer::type::vertex };
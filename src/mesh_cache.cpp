@@ -0,0 +1,308 @@
+#include <fstream>
+
+#include "mesh_cache.hpp"
+
+#include "file_reader.hpp"
+#include "file_view.hpp"
+#include "filesystem.hpp"
+#include "logging.hpp"
+#include "utils.hpp"
+
+namespace
+{
+static inline logger log() { return get_logger("mesh_cache"); }
+
+constexpr std::array<char, 4> MAGIC { 'G', 'M', 'S', 'H' };
+constexpr uint32_t VERSION = 2;
+
+// the vertex blobs are uploaded as they are
+static_assert(sizeof(vertex3d) == vertex3d::size);
+
+struct file_header
+{
+    std::array<char, 4> magic;
+    uint32_t version;
+    uint32_t node_count;
+    uint32_t camera_count;
+    uint32_t light_count;
+};
+
+struct level_header
+{
+    float screen_size;
+    glm::vec4 bounds;
+    uint32_t submesh_count;
+    uint32_t vertex_count;
+    uint32_t index_count;
+};
+
+struct submesh_record
+{
+    uint64_t vertex_index_offset;
+    uint32_t material_index;
+};
+
+class blob_reader
+{
+public:
+    blob_reader(std::span<const std::byte> data)
+        : _data(data)
+    {
+    }
+
+    bool read(void* destination, size_t size)
+    {
+        if (_failed || size > _data.size() - _offset)
+        {
+            _failed = true;
+            return false;
+        }
+
+        std::memcpy(destination, _data.data() + _offset, size);
+        _offset += size;
+        return true;
+    }
+
+    std::span<const std::byte> view(size_t size)
+    {
+        if (_failed || size > _data.size() - _offset)
+        {
+            _failed = true;
+            return {};
+        }
+
+        auto result = _data.subspan(_offset, size);
+        _offset += size;
+        return result;
+    }
+
+    template <typename T>
+    bool read(T& value)
+    {
+        return read(&value, sizeof(T));
+    }
+
+    template <typename T>
+    bool read(std::vector<T>& values, size_t count)
+    {
+        values.resize(count);
+        return read(values.data(), count * sizeof(T));
+    }
+
+    bool failed() const { return _failed; }
+
+private:
+    std::span<const std::byte> _data;
+    size_t _offset { 0 };
+    bool _failed { false };
+};
+
+class blob_writer
+{
+public:
+    void write(const void* source, size_t size)
+    {
+        const auto* bytes = static_cast<const char*>(source);
+        _data.insert(_data.end(), bytes, bytes + size);
+    }
+
+    template <typename T>
+    void write(const T& value)
+    {
+        write(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void write(const std::vector<T>& values)
+    {
+        write(values.data(), values.size() * sizeof(T));
+    }
+
+    const std::vector<char>& data() const { return _data; }
+
+private:
+    std::vector<char> _data;
+};
+} // namespace
+
+std::string
+mesh_cache::make_key(std::string_view source_path,
+                     uint32_t import_flags,
+                     std::span<const mesh::lod_level> lod_levels)
+{
+    // the sources may be large, they are hashed as they are streamed in
+    file_reader source { source_path };
+    if (!source.is_open() || source.size() == 0)
+    {
+        return {};
+    }
+
+    stable_hash h;
+    for (auto chunk = source.next(); !chunk.empty(); chunk = source.next())
+    {
+        h.add(chunk.data(), chunk.size());
+    }
+    h.add_value(VERSION);
+    h.add_value(import_flags);
+    for (const auto& level : lod_levels)
+    {
+        h.add_value(level.max_error);
+        h.add_value(level.screen_size);
+    }
+    return std::format("{:016x}", h._value);
+}
+
+std::optional<mesh_cache::entry> mesh_cache::load(std::string_view key)
+{
+    if (key.empty())
+    {
+        return std::nullopt;
+    }
+
+    // the file stays mapped, the blobs of the simplified levels are uploaded
+    // straight out of it
+    std::filesystem::path path = entry_path(key);
+    if (!std::filesystem::exists(path))
+    {
+        return std::nullopt;
+    }
+
+    auto data = std::make_shared<file_view>(path.string());
+    if (data->size() == 0)
+    {
+        return std::nullopt;
+    }
+
+    blob_reader reader(data->data());
+    file_header header;
+    if (!reader.read(header) || header.magic != MAGIC ||
+        header.version != VERSION)
+    {
+        log()->warn("Ignoring the incompatible mesh cache entry {}", key);
+        return std::nullopt;
+    }
+
+    entry result;
+    result.nodes.resize(header.node_count);
+    for (auto& n : result.nodes)
+    {
+        uint32_t name_length = 0;
+        uint32_t level_count = 0;
+        reader.read(name_length);
+        n.name.resize(name_length);
+        reader.read(n.name.data(), name_length);
+        reader.read(level_count);
+        if (reader.failed())
+        {
+            break;
+        }
+
+        n.levels.resize(level_count);
+        for (size_t i = 0; i < n.levels.size(); ++i)
+        {
+            auto& l = n.levels[ i ];
+            level_header lh;
+            std::vector<submesh_record> submeshes;
+            if (!reader.read(lh) || !reader.read(submeshes, lh.submesh_count))
+            {
+                break;
+            }
+
+            // the finest level is kept on the cpu too, e.g. for the
+            // occlusion culling
+            if (i == 0)
+            {
+                reader.read(l.vertices, lh.vertex_count);
+                reader.read(l.indices, lh.index_count);
+            }
+            else
+            {
+                l.vertex_data = reader.view(
+                    static_cast<size_t>(lh.vertex_count) * sizeof(vertex3d));
+                l.index_data = reader.view(
+                    static_cast<size_t>(lh.index_count) * sizeof(int));
+            }
+            if (reader.failed())
+            {
+                break;
+            }
+
+            l.screen_size = lh.screen_size;
+            l.bounds = { glm::vec3(lh.bounds), lh.bounds.w };
+            for (const auto& s : submeshes)
+            {
+                l.submeshes.push_back(
+                    { static_cast<size_t>(s.vertex_index_offset),
+                      static_cast<unsigned short>(s.material_index) });
+            }
+        }
+    }
+
+    reader.read(result.cameras, header.camera_count);
+    reader.read(result.lights, header.light_count);
+    if (reader.failed())
+    {
+        log()->warn("Truncated mesh cache entry {}", key);
+        return std::nullopt;
+    }
+
+    result.mapping = std::move(data);
+    return result;
+}
+
+void mesh_cache::store(std::string_view key, const entry& data)
+{
+    if (key.empty())
+    {
+        return;
+    }
+
+    blob_writer writer;
+    writer.write(file_header { MAGIC,
+                               VERSION,
+                               static_cast<uint32_t>(data.nodes.size()),
+                               static_cast<uint32_t>(data.cameras.size()),
+                               static_cast<uint32_t>(data.lights.size()) });
+    for (const auto& n : data.nodes)
+    {
+        writer.write(static_cast<uint32_t>(n.name.size()));
+        writer.write(n.name.data(), n.name.size());
+        writer.write(static_cast<uint32_t>(n.levels.size()));
+        for (const auto& l : n.levels)
+        {
+            writer.write(
+                level_header { l.screen_size,
+                               glm::vec4(l.bounds.center, l.bounds.radius),
+                               static_cast<uint32_t>(l.submeshes.size()),
+                               static_cast<uint32_t>(l.vertices.size()),
+                               static_cast<uint32_t>(l.indices.size()) });
+            for (const auto& s : l.submeshes)
+            {
+                writer.write(submesh_record { s.vertex_index_offset,
+                                              s.material_index });
+            }
+            writer.write(l.vertices);
+            writer.write(l.indices);
+        }
+    }
+    writer.write(data.cameras);
+    writer.write(data.lights);
+
+    std::filesystem::path path = entry_path(key);
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        log()->warn("Failed to write the mesh cache entry {}", path.string());
+        return;
+    }
+
+    stream.write(writer.data().data(), writer.data().size());
+}
+
+std::filesystem::path mesh_cache::entry_path(std::string_view key)
+{
+    return std::filesystem::path(filesystem::mesh_cache_path()) /
+           std::format("{}.mesh", key);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <optional>
+
+#include "mesh.hpp"
+
+class file_view;
+
+/**
+ * @brief Native binary cache of the imported model files
+ *
+ * Keeps the meshes of a model file with their levels of detail in the GPU
+ * ready layout, together with the cameras and lights of the file, so the
+ * repeated imports skip the importer entirely. An entry is keyed by the hash
+ * of the source file contents, the import flags and the requested levels of
+ * detail.
+ *
+ * File layout (native endianness):
+ * - header: magic, version and the node, camera and light counts
+ * - per node: name, level count, then per level the level header (screen
+ *   size, bounds, counts), the submesh table and the vertex and index blobs
+ * - the camera and the light records
+ */
+class mesh_cache
+{
+public:
+    struct level
+    {
+        float screen_size { std::numeric_limits<float>::max() };
+        mesh::bounding_sphere bounds;
+        std::vector<mesh::submesh_info> submeshes;
+        std::vector<vertex3d> vertices;
+        std::vector<int> indices;
+        // the blobs of a loaded simplified level within the mapped entry,
+        // those levels are only drawn so their vectors are left empty
+        std::span<const std::byte> vertex_data;
+        std::span<const std::byte> index_data;
+    };
+
+    struct node
+    {
+        std::string name;
+        // the full resolution mesh followed by the simplified ones
+        std::vector<level> levels;
+    };
+
+    struct camera_record
+    {
+        float fov;
+        glm::vec3 position;
+        glm::quat rotation;
+    };
+
+    struct light_record
+    {
+        glm::vec3 position;
+        glm::vec3 color;
+        float intensity;
+    };
+
+    struct entry
+    {
+        std::vector<node> nodes;
+        std::vector<camera_record> cameras;
+        std::vector<light_record> lights;
+        // keeps the blobs of the loaded levels valid
+        std::shared_ptr<const file_view> mapping;
+    };
+
+public:
+    /**
+     * @brief Compute the cache key of the model file
+     *
+     * @param source_path the path of the source model file
+     * @param import_flags the flags the importer is run with
+     * @param lod_levels the levels of detail generated for the meshes
+     * @return std::string the key, empty if the source can't be read
+     */
+    static std::string make_key(std::string_view source_path,
+                                uint32_t import_flags,
+                                std::span<const mesh::lod_level> lod_levels);
+
+    /**
+     * @brief Load the cache entry
+     *
+     * The finest level of every node is copied out, the simplified levels
+     * reference the entry file, which stays mapped while the entry lives.
+     *
+     * @param key the key of the entry
+     * @return std::optional<entry> the entry, empty if missing or corrupted
+     */
+    static std::optional<entry> load(std::string_view key);
+    static void store(std::string_view key, const entry& data);
+
+private:
+    static std::filesystem::path entry_path(std::string_view key);
+};
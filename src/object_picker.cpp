@@ -0,0 +1,209 @@
+#include <prof/profiler.hpp>
+
+#include "object_picker.hpp"
+
+#include "framebuffer.hpp"
+#include "logging.hpp"
+#include "scene.hpp"
+
+namespace
+{
+static logger log() { return get_logger("object_picker"); }
+} // namespace
+
+object_picker::object_picker() = default;
+
+object_picker::~object_picker()
+{
+    for (auto& rb : _readbacks)
+    {
+        glDeleteSync(rb.fence);
+        glDeleteBuffers(1, &rb.buffer);
+    }
+
+    for (auto& [ buffer, size ] : _free_buffers)
+    {
+        glDeleteBuffers(1, &buffer);
+    }
+}
+
+void object_picker::pick(glm::uvec2 position, callback on_picked)
+{
+    pick(position, position, std::move(on_picked));
+}
+
+void object_picker::pick(glm::uvec2 min, glm::uvec2 max, callback on_picked)
+{
+    std::unique_lock lock { _mutex };
+    _requests.push_back(
+        { glm::min(min, max), glm::max(min, max), std::move(on_picked) });
+}
+
+bool object_picker::has_requests() const
+{
+    std::unique_lock lock { _mutex };
+    return !_requests.empty();
+}
+
+bool object_picker::has_work() const
+{
+    std::unique_lock lock { _mutex };
+    return !_requests.empty() || !_readbacks.empty();
+}
+
+void object_picker::execute(const framebuffer* frame,
+                            glm::uvec2 render_size,
+                            glm::uvec2 frame_size)
+{
+    auto sp = prof::profile(__FUNCTION__);
+    resolve_readbacks();
+    if (!frame->has_object_ids())
+    {
+        // queued after the frame target was chosen, served by the next frame
+        return;
+    }
+
+    std::vector<request> requests;
+    {
+        std::unique_lock lock { _mutex };
+        requests.swap(_requests);
+    }
+
+    for (auto& req : requests)
+    {
+        issue_readback(frame, req, render_size, frame_size);
+    }
+}
+
+void object_picker::dispatch()
+{
+    std::vector<result> results;
+    {
+        std::unique_lock lock { _mutex };
+        results.swap(_results);
+    }
+
+    scene* s = scene::get_active_scene();
+    for (auto& res : results)
+    {
+        std::vector<game_object*> picked;
+        for (uint32_t id : res.ids)
+        {
+            if (auto* object = s ? s->find_object(id) : nullptr)
+            {
+                picked.push_back(object);
+            }
+        }
+
+        if (res.on_picked)
+        {
+            res.on_picked(std::move(picked));
+        }
+    }
+}
+
+void object_picker::issue_readback(const framebuffer* frame,
+                                   request& req,
+                                   glm::uvec2 render_size,
+                                   glm::uvec2 frame_size)
+{
+    // the requests refer to the render size, the dynamic resolution renders
+    // a smaller region of the target
+    auto to_frame = [ & ](glm::uvec2 position)
+    {
+        glm::uvec2 scaled = glm::uvec2(glm::vec2(position) *
+                                       glm::vec2(frame_size) /
+                                       glm::vec2(render_size));
+        return glm::min(scaled, frame_size - 1u);
+    };
+    glm::uvec2 min = to_frame(req.min);
+    glm::uvec2 max = to_frame(req.max);
+    glm::uvec2 extent = max - min + 1u;
+    size_t pixel_count = static_cast<size_t>(extent.x) * extent.y;
+
+    readback rb;
+    std::tie(rb.buffer, rb.buffer_size) =
+        acquire_buffer(pixel_count * sizeof(unsigned));
+    rb.pixel_count = pixel_count;
+    rb.on_picked = std::move(req.on_picked);
+
+    // the copy goes into the pixel buffer, so the call returns right away
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    frame->read_object_ids(min, extent);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    rb.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    std::unique_lock lock { _mutex };
+    _readbacks.push_back(std::move(rb));
+}
+
+void object_picker::resolve_readbacks()
+{
+    std::vector<readback> finished;
+    {
+        std::unique_lock lock { _mutex };
+        for (auto it = _readbacks.begin(); it != _readbacks.end();)
+        {
+            GLenum status = glClientWaitSync(it->fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED &&
+                status != GL_CONDITION_SATISFIED)
+            {
+                ++it;
+                continue;
+            }
+
+            finished.push_back(std::move(*it));
+            it = _readbacks.erase(it);
+        }
+    }
+
+    for (auto& rb : finished)
+    {
+        glDeleteSync(rb.fence);
+
+        std::vector<uint32_t> unique_ids;
+        const size_t bytes = rb.pixel_count * sizeof(unsigned);
+        const auto* ids = static_cast<const unsigned*>(
+            glMapNamedBufferRange(rb.buffer, 0, bytes, GL_MAP_READ_BIT));
+        if (ids)
+        {
+            unique_ids.assign(ids, ids + rb.pixel_count);
+            glUnmapNamedBuffer(rb.buffer);
+
+            std::sort(unique_ids.begin(), unique_ids.end());
+            unique_ids.erase(std::unique(unique_ids.begin(), unique_ids.end()),
+                             unique_ids.end());
+            // the id 0 stands for the background
+            std::erase(unique_ids, 0u);
+        }
+        else
+        {
+            log()->error("Failed to map the picking buffer {}", rb.buffer);
+        }
+
+        _free_buffers.push_back({ rb.buffer, rb.buffer_size });
+
+        std::unique_lock lock { _mutex };
+        _results.push_back({ std::move(unique_ids), std::move(rb.on_picked) });
+    }
+}
+
+std::pair<unsigned, size_t> object_picker::acquire_buffer(size_t size)
+{
+    auto it = std::find_if(_free_buffers.begin(),
+                           _free_buffers.end(),
+                           [ size ](const auto& buffer)
+    { return buffer.second >= size; });
+    if (it != _free_buffers.end())
+    {
+        auto buffer = *it;
+        _free_buffers.erase(it);
+        return buffer;
+    }
+
+    unsigned buffer = 0;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferData(buffer, size, nullptr, GL_STREAM_READ);
+    return { buffer, size };
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <mutex>
+
+class framebuffer;
+class game_object;
+
+/**
+ * @brief Picks the objects under the screen positions of a camera
+ *
+ * The picking requests are queued and served by the next rendering of the
+ * camera: the scene pass writes the ids of the drawn objects into the id
+ * attachment of the frame and the requested pixels are read back into a
+ * pixel buffer. The readback completes asynchronously, so the results are
+ * resolved one or two frames later, once the fence of the copy signals,
+ * without stalling the pipeline.
+ *
+ * The picking is exact against the rendered geometry. The ids are resolved
+ * through the active scene and the callbacks are called by dispatch(), on
+ * the game thread, so the objects removed meanwhile are left out.
+ */
+class object_picker
+{
+public:
+    using callback = std::function<void(std::vector<game_object*>)>;
+
+public:
+    object_picker();
+    ~object_picker();
+
+    /**
+     * @brief Pick the object under the pixel
+     *
+     * @param position the pixel with the origin at the bottom-left corner
+     * @param on_picked called with the picked object, or an empty list if
+     * there is none
+     */
+    void pick(glm::uvec2 position, callback on_picked);
+
+    /**
+     * @brief Pick all the objects visible in the rectangle
+     *
+     * @param min the bottom-left corner
+     * @param max the top-right corner, inclusive
+     * @param on_picked called with the picked objects
+     */
+    void pick(glm::uvec2 min, glm::uvec2 max, callback on_picked);
+
+    /**
+     * @brief Check whether there are requests waiting for the rendering
+     */
+    bool has_requests() const;
+
+    /**
+     * @brief Check whether there are requests waiting for the rendering or
+     * readbacks waiting for the results
+     */
+    bool has_work() const;
+
+    /**
+     * @brief Serve the queued requests and resolve the finished readbacks
+     *
+     * Called on the rendering thread. The requests stay queued if the frame
+     * has no object ids.
+     *
+     * @param frame the rendered frame target
+     * @param render_size the size of the camera frame the requests refer to
+     * @param frame_size the size of the rendered region of the target
+     */
+    void execute(const framebuffer* frame,
+                 glm::uvec2 render_size,
+                 glm::uvec2 frame_size);
+
+    /**
+     * @brief Call the callbacks of the resolved requests
+     *
+     * Expected to be called by the game thread, once per frame.
+     */
+    void dispatch();
+
+private:
+    struct request
+    {
+        glm::uvec2 min;
+        glm::uvec2 max;
+        callback on_picked;
+    };
+
+    struct readback
+    {
+        unsigned buffer;
+        size_t buffer_size;
+        GLsync fence;
+        size_t pixel_count;
+        callback on_picked;
+    };
+
+    struct result
+    {
+        std::vector<uint32_t> ids;
+        callback on_picked;
+    };
+
+    void issue_readback(const framebuffer* frame,
+                        request& req,
+                        glm::uvec2 render_size,
+                        glm::uvec2 frame_size);
+    void resolve_readbacks();
+    std::pair<unsigned, size_t> acquire_buffer(size_t size);
+
+private:
+    mutable std::mutex _mutex;
+    std::vector<request> _requests;
+    std::vector<readback> _readbacks;
+    std::vector<result> _results;
+    // pixel buffers with their sizes, reused by the next readbacks
+    std::vector<std::pair<unsigned, size_t>> _free_buffers;
+};
@@ -0,0 +1,129 @@
+#include <fstream>
+
+#include "program_binary_cache.hpp"
+
+#include "filesystem.hpp"
+#include "logging.hpp"
+#include "utils.hpp"
+
+namespace
+{
+static inline logger log() { return get_logger("program_binary_cache"); }
+
+std::string_view gl_string(GLenum name)
+{
+    const auto* value = reinterpret_cast<const char*>(glGetString(name));
+    return value ? std::string_view(value) : std::string_view();
+}
+
+bool binaries_supported()
+{
+    static const bool supported = []
+    {
+        int format_count = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+        if (format_count == 0)
+        {
+            log()->info("The driver doesn't provide program binaries");
+        }
+        return format_count > 0;
+    }();
+    return supported;
+}
+} // namespace
+
+std::string
+program_binary_cache::make_key(std::span<const std::string_view> sources)
+{
+    if (!binaries_supported())
+    {
+        return {};
+    }
+
+    stable_hash h;
+    h.add(gl_string(GL_VENDOR));
+    h.add(gl_string(GL_RENDERER));
+    h.add(gl_string(GL_VERSION));
+    for (auto source : sources)
+    {
+        h.add(source);
+    }
+    return std::format("{:016x}", h._value);
+}
+
+bool program_binary_cache::load(std::string_view key, unsigned program)
+{
+    if (key.empty())
+    {
+        return false;
+    }
+
+    std::filesystem::path path = entry_path(key);
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+    {
+        return false;
+    }
+
+    GLenum format = 0;
+    stream.read(reinterpret_cast<char*>(&format), sizeof(format));
+    std::vector<char> binary { std::istreambuf_iterator<char>(stream),
+                               std::istreambuf_iterator<char>() };
+    stream.close();
+    if (binary.empty())
+    {
+        log()->warn("Truncated program binary {}", path.string());
+        std::filesystem::remove(path);
+        return false;
+    }
+
+    glProgramBinary(program, format, binary.data(), binary.size());
+    int status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE)
+    {
+        log()->info("The driver rejected the program binary {}", key);
+        std::filesystem::remove(path);
+        return false;
+    }
+
+    return true;
+}
+
+void program_binary_cache::store(std::string_view key, unsigned program)
+{
+    if (key.empty())
+    {
+        return;
+    }
+
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length == 0)
+    {
+        return;
+    }
+
+    GLenum format = 0;
+    std::vector<char> binary(length);
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::filesystem::path path = entry_path(key);
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        log()->warn("Failed to write the program binary {}", path.string());
+        return;
+    }
+
+    stream.write(reinterpret_cast<const char*>(&format), sizeof(format));
+    stream.write(binary.data(), length);
+}
+
+std::filesystem::path program_binary_cache::entry_path(std::string_view key)
+{
+    return std::filesystem::path(filesystem::shader_cache_path()) /
+           std::format("{}.bin", key);
+}
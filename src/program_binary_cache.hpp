@@ -0,0 +1,45 @@
+#pragma once
+
+/**
+ * @brief On-disk cache of the linked shader program binaries
+ *
+ * The binaries are keyed by a hash of the preprocessed stage sources and the
+ * GL vendor, renderer and version strings, so a driver update or a source
+ * change simply misses the cache. A binary rejected by the driver is removed
+ * and the program is built from the sources again.
+ */
+class program_binary_cache
+{
+public:
+    /**
+     * @brief Compute the cache key of a program
+     *
+     * Requires a current GL context.
+     *
+     * @param sources the preprocessed sources of all the stages, in the order
+     * they are attached
+     * @return std::string the key, empty if the driver can't provide the
+     * program binaries
+     */
+    static std::string make_key(std::span<const std::string_view> sources);
+
+    /**
+     * @brief Load the cached binary into the program
+     *
+     * @param key the cache key of the program
+     * @param program the GL program to load into
+     * @return true if the binary was found and accepted by the driver
+     */
+    static bool load(std::string_view key, unsigned program);
+
+    /**
+     * @brief Store the binary of the linked program
+     *
+     * @param key the cache key of the program
+     * @param program the successfully linked GL program
+     */
+    static void store(std::string_view key, unsigned program);
+
+private:
+    static std::filesystem::path entry_path(std::string_view key);
+};
@@ -0,0 +1,93 @@
+#include <prof/profiler.hpp>
+
+#include "render_thread.hpp"
+
+#include "logging.hpp"
+#include "thread.hpp"
+
+namespace
+{
+static logger log() { return get_logger("render_thread"); }
+} // namespace
+
+render_thread::render_thread()
+{
+    _thread = std::thread { [ this ] { run(); } };
+    set_thread_name(_thread, "render_thread");
+}
+
+render_thread::~render_thread() { stop(); }
+
+void render_thread::submit(std::shared_ptr<const frame_packet> packet,
+                           std::function<void()> work)
+{
+    std::unique_lock lock { _mutex };
+    _condition.wait(lock, [ this ] { return !_pending_work || _stopping; });
+    if (_stopping)
+    {
+        log()->warn("Frame {} is submitted after the thread is stopped",
+                    packet->frame_index);
+        return;
+    }
+
+    _pending_packet = std::move(packet);
+    _pending_work = std::move(work);
+    _condition.notify_all();
+}
+
+void render_thread::wait_idle()
+{
+    std::unique_lock lock { _mutex };
+    _condition.wait(lock, [ this ] { return !_pending_work && !_busy; });
+}
+
+void render_thread::stop()
+{
+    {
+        std::unique_lock lock { _mutex };
+        _stopping = true;
+        _condition.notify_all();
+    }
+
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+void render_thread::run()
+{
+    while (true)
+    {
+        std::shared_ptr<const frame_packet> packet;
+        std::function<void()> work;
+        {
+            std::unique_lock lock { _mutex };
+            _condition.wait(lock,
+                            [ this ] { return _pending_work || _stopping; });
+            if (!_pending_work)
+            {
+                return;
+            }
+
+            packet = std::move(_pending_packet);
+            work = std::move(_pending_work);
+            _pending_packet = nullptr;
+            _pending_work = nullptr;
+            _busy = true;
+            // the slot is free, the game thread may submit the next frame
+            _condition.notify_all();
+        }
+
+        {
+            auto p = prof::profile_frame(__FUNCTION__);
+            frame_packet::set_current(packet);
+            work();
+            frame_packet::set_current(nullptr);
+        }
+
+        std::unique_lock lock { _mutex };
+        _busy = false;
+        _condition.notify_all();
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+#include "frame_packet.hpp"
+
+/**
+ * @brief Renders the submitted frames on a dedicated thread
+ *
+ * The game thread extracts a @ref frame_packet at the end of its update and
+ * hands it over together with the work rendering it. While the frame is
+ * rendered, the game thread simulates the next one. At most one more frame
+ * may wait for the rendering, so @ref submit blocks when the game thread
+ * runs two frames ahead.
+ *
+ * The work runs with the submitted packet set as the current one, so the
+ * cameras render the captured state instead of the live objects. The GL
+ * contexts are made current by the work itself, so those must be released
+ * by the game thread beforehand.
+ */
+class render_thread
+{
+public:
+    render_thread();
+    ~render_thread();
+
+    /**
+     * @brief Queue the frame for rendering
+     *
+     * Blocks while the previously submitted frame waits for the rendering.
+     *
+     * @param packet the state to render
+     * @param work the rendering of the frame
+     */
+    void submit(std::shared_ptr<const frame_packet> packet,
+                std::function<void()> work);
+
+    /**
+     * @brief Wait until all the submitted frames are rendered
+     */
+    void wait_idle();
+
+    /**
+     * @brief Render the pending frame and stop the thread
+     */
+    void stop();
+
+private:
+    void run();
+
+private:
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::shared_ptr<const frame_packet> _pending_packet { nullptr };
+    std::function<void()> _pending_work {};
+    bool _busy { false };
+    bool _stopping { false };
+};
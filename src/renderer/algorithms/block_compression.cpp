@@ -0,0 +1,239 @@
+#include "block_compression.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define BLOCK_COMPRESSION_USE_SSE
+#    include <emmintrin.h>
+#endif
+
+namespace
+{
+constexpr size_t BLOCK_PIXELS = 16;
+
+uint16_t to_565(const uint8_t* color)
+{
+    return static_cast<uint16_t>(((color[ 0 ] >> 3) << 11) |
+                                 ((color[ 1 ] >> 2) << 5) | (color[ 2 ] >> 3));
+}
+
+glm::ivec3 from_565(uint16_t value)
+{
+    int r = (value >> 11) & 31;
+    int g = (value >> 5) & 63;
+    int b = value & 31;
+    return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+}
+
+void color_bounds(const uint8_t* rgba, uint8_t* min, uint8_t* max)
+{
+#ifdef BLOCK_COMPRESSION_USE_SSE
+    const auto* pixels = reinterpret_cast<const __m128i*>(rgba);
+    __m128i p0 = _mm_loadu_si128(pixels);
+    __m128i p1 = _mm_loadu_si128(pixels + 1);
+    __m128i p2 = _mm_loadu_si128(pixels + 2);
+    __m128i p3 = _mm_loadu_si128(pixels + 3);
+    __m128i lo = _mm_min_epu8(_mm_min_epu8(p0, p1), _mm_min_epu8(p2, p3));
+    __m128i hi = _mm_max_epu8(_mm_max_epu8(p0, p1), _mm_max_epu8(p2, p3));
+    // fold the four pixels of the register into the lowest one
+    lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 8));
+    lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 4));
+    hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 8));
+    hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 4));
+    int lo_pixel = _mm_cvtsi128_si32(lo);
+    int hi_pixel = _mm_cvtsi128_si32(hi);
+    std::memcpy(min, &lo_pixel, 4);
+    std::memcpy(max, &hi_pixel, 4);
+#else
+    std::fill_n(min, 4, uint8_t { 255 });
+    std::fill_n(max, 4, uint8_t { 0 });
+    for (size_t i = 0; i < BLOCK_PIXELS; ++i)
+    {
+        for (size_t c = 0; c < 4; ++c)
+        {
+            min[ c ] = std::min(min[ c ], rgba[ i * 4 + c ]);
+            max[ c ] = std::max(max[ c ], rgba[ i * 4 + c ]);
+        }
+    }
+#endif
+}
+
+void encode_color_block(const uint8_t* rgba, uint8_t* out)
+{
+    uint8_t min[ 4 ];
+    uint8_t max[ 4 ];
+    color_bounds(rgba, min, max);
+    // inset the box a bit, the extremes are rarely the best endpoints
+    for (size_t c = 0; c < 3; ++c)
+    {
+        int inset = (max[ c ] - min[ c ]) >> 4;
+        min[ c ] = static_cast<uint8_t>(min[ c ] + inset);
+        max[ c ] = static_cast<uint8_t>(max[ c ] - inset);
+    }
+
+    uint16_t c0 = to_565(max);
+    uint16_t c1 = to_565(min);
+    // the four color mode requires c0 > c1
+    if (c0 < c1)
+    {
+        std::swap(c0, c1);
+    }
+
+    uint32_t indices = 0;
+    if (c0 != c1)
+    {
+        std::array<glm::ivec3, 4> palette;
+        palette[ 0 ] = from_565(c0);
+        palette[ 1 ] = from_565(c1);
+        palette[ 2 ] = (palette[ 0 ] * 2 + palette[ 1 ]) / 3;
+        palette[ 3 ] = (palette[ 0 ] + palette[ 1 ] * 2) / 3;
+        for (size_t i = 0; i < BLOCK_PIXELS; ++i)
+        {
+            glm::ivec3 color { rgba[ i * 4 ],
+                               rgba[ i * 4 + 1 ],
+                               rgba[ i * 4 + 2 ] };
+            uint32_t best = 0;
+            int best_distance = std::numeric_limits<int>::max();
+            for (uint32_t p = 0; p < palette.size(); ++p)
+            {
+                glm::ivec3 d = color - palette[ p ];
+                int distance = d.x * d.x + d.y * d.y + d.z * d.z;
+                if (distance < best_distance)
+                {
+                    best_distance = distance;
+                    best = p;
+                }
+            }
+            indices |= best << (i * 2);
+        }
+    }
+
+    std::memcpy(out, &c0, 2);
+    std::memcpy(out + 2, &c1, 2);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+// a single channel block, also the alpha block of bc3
+void encode_channel_block(const uint8_t* rgba, size_t channel, uint8_t* out)
+{
+    uint8_t min = 255;
+    uint8_t max = 0;
+    for (size_t i = 0; i < BLOCK_PIXELS; ++i)
+    {
+        min = std::min(min, rgba[ i * 4 + channel ]);
+        max = std::max(max, rgba[ i * 4 + channel ]);
+    }
+
+    // the eight value mode: a0 > a1, the rest interpolated between them
+    uint64_t indices = 0;
+    if (max > min)
+    {
+        int range = max - min;
+        for (size_t i = 0; i < BLOCK_PIXELS; ++i)
+        {
+            int value = rgba[ i * 4 + channel ] - min;
+            int step = (value * 7 + range / 2) / range;
+            // step 7 is a0, step 0 is a1 and the interpolated values are
+            // ordered from a0 down to a1
+            uint64_t index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+            indices |= index << (i * 3);
+        }
+    }
+
+    out[ 0 ] = max;
+    out[ 1 ] = min;
+    for (size_t b = 0; b < 6; ++b)
+    {
+        out[ 2 + b ] = static_cast<uint8_t>(indices >> (b * 8));
+    }
+}
+
+void encode_block(const uint8_t* rgba, block_format format, uint8_t* out)
+{
+    switch (format)
+    {
+    case block_format::bc1: encode_color_block(rgba, out); break;
+    case block_format::bc3:
+        encode_channel_block(rgba, 3, out);
+        encode_color_block(rgba, out + 8);
+        break;
+    case block_format::bc4: encode_channel_block(rgba, 0, out); break;
+    case block_format::bc5:
+        encode_channel_block(rgba, 0, out);
+        encode_channel_block(rgba, 1, out + 8);
+        break;
+    }
+}
+} // namespace
+
+size_t block_size(block_format format)
+{
+    switch (format)
+    {
+    case block_format::bc1:
+    case block_format::bc4: return 8;
+    case block_format::bc3:
+    case block_format::bc5: return 16;
+    }
+    return 0;
+}
+
+std::vector<uint8_t> compress_blocks(const uint8_t* rgba,
+                                     size_t width,
+                                     size_t height,
+                                     block_format format)
+{
+    const size_t blocks_x = (width + 3) / 4;
+    const size_t blocks_y = (height + 3) / 4;
+    const size_t stride = block_size(format);
+    std::vector<uint8_t> result(blocks_x * blocks_y * stride);
+
+    auto encode_rows = [ & ](size_t begin, size_t end)
+    {
+        std::array<uint8_t, BLOCK_PIXELS * 4> block;
+        for (size_t by = begin; by < end; ++by)
+        {
+            for (size_t bx = 0; bx < blocks_x; ++bx)
+            {
+                // the blocks over the edge repeat the last row and column
+                for (size_t y = 0; y < 4; ++y)
+                {
+                    size_t sy = std::min(by * 4 + y, height - 1);
+                    for (size_t x = 0; x < 4; ++x)
+                    {
+                        size_t sx = std::min(bx * 4 + x, width - 1);
+                        std::memcpy(block.data() + (y * 4 + x) * 4,
+                                    rgba + (sy * width + sx) * 4,
+                                    4);
+                    }
+                }
+                encode_block(block.data(),
+                             format,
+                             result.data() + (by * blocks_x + bx) * stride);
+            }
+        }
+    };
+
+    // not worth the threads for the small mip levels
+    const size_t thread_count =
+        std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u),
+                         blocks_x * blocks_y / 256 + 1);
+    if (thread_count <= 1)
+    {
+        encode_rows(0, blocks_y);
+        return result;
+    }
+
+    std::vector<std::thread> threads;
+    const size_t rows_per_thread = (blocks_y + thread_count - 1) / thread_count;
+    for (size_t begin = 0; begin < blocks_y; begin += rows_per_thread)
+    {
+        threads.emplace_back(encode_rows,
+                             begin,
+                             std::min(begin + rows_per_thread, blocks_y));
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    return result;
+}
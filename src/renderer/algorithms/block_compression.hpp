@@ -0,0 +1,37 @@
+#pragma once
+
+/**
+ * @brief The block compressed formats of the cooked textures
+ *
+ * - bc1: RGB, 8 bytes per 4x4 block
+ * - bc3: RGBA, the alpha is encoded separately, 16 bytes per block
+ * - bc4: a single channel, 8 bytes per block
+ * - bc5: two channels, e.g. the normal maps, 16 bytes per block
+ */
+enum class block_format : uint32_t
+{
+    bc1,
+    bc3,
+    bc4,
+    bc5,
+};
+
+size_t block_size(block_format format);
+
+/**
+ * @brief Compress the image into 4x4 blocks
+ *
+ * The endpoints are fit to the bounding box of the block colors, which is
+ * fast enough for cooking at load time. The rows of the blocks are split
+ * across the hardware threads.
+ *
+ * @param rgba the pixels of the image, 4 bytes each, the rows tightly packed
+ * @param width the width of the image, doesn't need to be a multiple of 4
+ * @param height the height of the image, doesn't need to be a multiple of 4
+ * @param format the compressed format
+ * @return std::vector<uint8_t> the blocks row by row
+ */
+std::vector<uint8_t> compress_blocks(const uint8_t* rgba,
+                                     size_t width,
+                                     size_t height,
+                                     block_format format);
@@ -0,0 +1,405 @@
+#include "mesh_simplification.hpp"
+
+namespace
+{
+// weight of the planes guarding the open borders of the mesh
+static constexpr double BORDER_WEIGHT = 10.0;
+
+struct quadric
+{
+    // upper triangle of the symmetric 4x4 matrix
+    std::array<double, 10> _m {};
+
+    static quadric from_plane(glm::dvec3 normal, double d, double weight = 1.0)
+    {
+        quadric result;
+        double a = normal.x;
+        double b = normal.y;
+        double c = normal.z;
+        result._m = { a * a, a * b, a * c, a * d, b * b,
+                      b * c, b * d, c * c, c * d, d * d };
+        for (auto& v : result._m)
+        {
+            v *= weight;
+        }
+        return result;
+    }
+
+    quadric& operator+=(const quadric& other)
+    {
+        for (size_t i = 0; i < _m.size(); ++i)
+        {
+            _m[ i ] += other._m[ i ];
+        }
+        return *this;
+    }
+
+    double evaluate(glm::dvec3 p) const
+    {
+        double error = _m[ 0 ] * p.x * p.x + 2 * _m[ 1 ] * p.x * p.y +
+                       2 * _m[ 2 ] * p.x * p.z + 2 * _m[ 3 ] * p.x +
+                       _m[ 4 ] * p.y * p.y + 2 * _m[ 5 ] * p.y * p.z +
+                       2 * _m[ 6 ] * p.y + _m[ 7 ] * p.z * p.z +
+                       2 * _m[ 8 ] * p.z + _m[ 9 ];
+        return std::max(error, 0.0);
+    }
+};
+
+struct collapse_candidate
+{
+    double _cost;
+    int _from;
+    int _to;
+    unsigned _from_version;
+    unsigned _to_version;
+
+    bool operator>(const collapse_candidate& other) const
+    {
+        return _cost > other._cost;
+    }
+};
+
+uint64_t edge_key(int a, int b)
+{
+    auto [ lo, hi ] = std::minmax(a, b);
+    return (static_cast<uint64_t>(lo) << 32) | static_cast<uint32_t>(hi);
+}
+} // namespace
+
+float simplify_mesh(const std::vector<vertex3d>& vertices,
+                    const std::vector<int>& indices,
+                    float max_error,
+                    std::vector<vertex3d>& out_vertices,
+                    std::vector<int>& out_indices,
+                    const std::vector<bool>* locked)
+{
+    out_vertices.clear();
+    out_indices.clear();
+
+    // weld the vertices with the same position into groups. the topology is
+    // simplified over the groups, while the vertices keep their attributes
+    std::unordered_map<glm::vec3, int> position_groups;
+    std::vector<int> vertex_group(vertices.size());
+    std::vector<glm::dvec3> group_position;
+    std::vector<std::vector<int>> group_vertices;
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        auto [ it, inserted ] = position_groups.try_emplace(
+            vertices[ i ].position(), static_cast<int>(group_position.size()));
+        if (inserted)
+        {
+            group_position.push_back(vertices[ i ].position());
+            group_vertices.emplace_back();
+        }
+        vertex_group[ i ] = it->second;
+        group_vertices[ it->second ].push_back(static_cast<int>(i));
+    }
+
+    // a group is locked by any of its vertices
+    std::vector<bool> group_locked(group_position.size(), false);
+    if (locked)
+    {
+        for (size_t i = 0; i < vertices.size() && i < locked->size(); ++i)
+        {
+            if ((*locked)[ i ])
+            {
+                group_locked[ vertex_group[ i ] ] = true;
+            }
+        }
+    }
+
+    const size_t group_count = group_position.size();
+    std::vector<std::array<int, 3>> triangles;
+    std::vector<bool> triangle_removed;
+    std::vector<std::vector<int>> group_triangles(group_count);
+    std::vector<quadric> group_quadrics(group_count);
+    std::unordered_map<uint64_t, int> edge_usage;
+
+    auto triangle_normal = [](glm::dvec3 p0, glm::dvec3 p1, glm::dvec3 p2)
+    { return glm::cross(p1 - p0, p2 - p0); };
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::array<int, 3> tri { indices[ i ], indices[ i + 1 ],
+                                 indices[ i + 2 ] };
+        std::array<int, 3> groups { vertex_group[ tri[ 0 ] ],
+                                    vertex_group[ tri[ 1 ] ],
+                                    vertex_group[ tri[ 2 ] ] };
+        if (groups[ 0 ] == groups[ 1 ] || groups[ 1 ] == groups[ 2 ] ||
+            groups[ 0 ] == groups[ 2 ])
+        {
+            // degenerate triangle, drop it right away
+            continue;
+        }
+
+        int triangle_index = static_cast<int>(triangles.size());
+        triangles.push_back(tri);
+        triangle_removed.push_back(false);
+
+        glm::dvec3 n = triangle_normal(group_position[ groups[ 0 ] ],
+                                       group_position[ groups[ 1 ] ],
+                                       group_position[ groups[ 2 ] ]);
+        double length = glm::length(n);
+        quadric plane;
+        if (length > 0.0)
+        {
+            n /= length;
+            plane = quadric::from_plane(
+                n, -glm::dot(n, group_position[ groups[ 0 ] ]));
+        }
+
+        for (int c = 0; c < 3; ++c)
+        {
+            group_triangles[ groups[ c ] ].push_back(triangle_index);
+            group_quadrics[ groups[ c ] ] += plane;
+            ++edge_usage[ edge_key(groups[ c ], groups[ (c + 1) % 3 ]) ];
+        }
+    }
+
+    // keep the open borders in place by adding planes perpendicular to the
+    // border triangles
+    for (size_t t = 0; t < triangles.size(); ++t)
+    {
+        std::array<int, 3> groups { vertex_group[ triangles[ t ][ 0 ] ],
+                                    vertex_group[ triangles[ t ][ 1 ] ],
+                                    vertex_group[ triangles[ t ][ 2 ] ] };
+        glm::dvec3 n = triangle_normal(group_position[ groups[ 0 ] ],
+                                       group_position[ groups[ 1 ] ],
+                                       group_position[ groups[ 2 ] ]);
+        for (int c = 0; c < 3; ++c)
+        {
+            int a = groups[ c ];
+            int b = groups[ (c + 1) % 3 ];
+            if (edge_usage[ edge_key(a, b) ] != 1)
+            {
+                continue;
+            }
+
+            glm::dvec3 border_normal =
+                glm::cross(group_position[ b ] - group_position[ a ], n);
+            double length = glm::length(border_normal);
+            if (length == 0.0)
+            {
+                continue;
+            }
+
+            border_normal /= length;
+            quadric border = quadric::from_plane(
+                border_normal,
+                -glm::dot(border_normal, group_position[ a ]),
+                BORDER_WEIGHT);
+            group_quadrics[ a ] += border;
+            group_quadrics[ b ] += border;
+        }
+    }
+
+    std::vector<unsigned> group_version(group_count, 0);
+    std::vector<bool> group_alive(group_count, true);
+    std::priority_queue<collapse_candidate,
+                        std::vector<collapse_candidate>,
+                        std::greater<>>
+        candidates;
+
+    auto push_candidate = [ & ](int a, int b)
+    {
+        if (group_locked[ a ] && group_locked[ b ])
+        {
+            return;
+        }
+
+        quadric q = group_quadrics[ a ];
+        q += group_quadrics[ b ];
+        // the locked group is only ever the target of the collapse
+        double a_into_b = group_locked[ a ]
+                              ? std::numeric_limits<double>::max()
+                              : q.evaluate(group_position[ b ]);
+        double b_into_a = group_locked[ b ]
+                              ? std::numeric_limits<double>::max()
+                              : q.evaluate(group_position[ a ]);
+        if (a_into_b <= b_into_a)
+        {
+            candidates.push({ a_into_b,
+                              a,
+                              b,
+                              group_version[ a ],
+                              group_version[ b ] });
+        }
+        else
+        {
+            candidates.push({ b_into_a,
+                              b,
+                              a,
+                              group_version[ b ],
+                              group_version[ a ] });
+        }
+    };
+
+    for (const auto& [ key, _ ] : edge_usage)
+    {
+        push_candidate(static_cast<int>(key >> 32),
+                       static_cast<int>(key & 0xffffffff));
+    }
+
+    auto triangle_has_group = [ & ](int t, int group)
+    {
+        return vertex_group[ triangles[ t ][ 0 ] ] == group ||
+               vertex_group[ triangles[ t ][ 1 ] ] == group ||
+               vertex_group[ triangles[ t ][ 2 ] ] == group;
+    };
+
+    // the collapse must not flip any of the remaining triangles around
+    auto collapse_flips = [ & ](int from, int to)
+    {
+        for (int t : group_triangles[ from ])
+        {
+            if (triangle_removed[ t ] || triangle_has_group(t, to))
+            {
+                continue;
+            }
+
+            std::array<glm::dvec3, 3> before;
+            std::array<glm::dvec3, 3> after;
+            for (int c = 0; c < 3; ++c)
+            {
+                int g = vertex_group[ triangles[ t ][ c ] ];
+                before[ c ] = group_position[ g ];
+                after[ c ] = g == from ? group_position[ to ] : before[ c ];
+            }
+
+            glm::dvec3 n0 =
+                triangle_normal(before[ 0 ], before[ 1 ], before[ 2 ]);
+            glm::dvec3 n1 =
+                triangle_normal(after[ 0 ], after[ 1 ], after[ 2 ]);
+            double l0 = glm::length(n0);
+            double l1 = glm::length(n1);
+            if (l1 <= std::numeric_limits<double>::epsilon() ||
+                (l0 > 0.0 && glm::dot(n0 / l0, n1 / l1) < 0.2))
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // among the vertices of the target group pick the one with the closest
+    // attributes, so uv seams survive the collapse
+    auto pick_vertex = [ & ](int group, int source_vertex)
+    {
+        const vertex3d& source = vertices[ source_vertex ];
+        int best = group_vertices[ group ].front();
+        float best_distance = std::numeric_limits<float>::max();
+        for (int candidate : group_vertices[ group ])
+        {
+            const vertex3d& v = vertices[ candidate ];
+            float distance = glm::distance(v.uv(), source.uv()) +
+                             glm::distance(v.normal(), source.normal());
+            if (distance < best_distance)
+            {
+                best_distance = distance;
+                best = candidate;
+            }
+        }
+        return best;
+    };
+
+    const double max_cost = static_cast<double>(max_error) * max_error;
+    double applied_error = 0.0;
+    std::vector<int> neighbours;
+    while (!candidates.empty())
+    {
+        collapse_candidate candidate = candidates.top();
+        if (candidate._cost > max_cost)
+        {
+            break;
+        }
+        candidates.pop();
+
+        int from = candidate._from;
+        int to = candidate._to;
+        if (!group_alive[ from ] || !group_alive[ to ] ||
+            group_version[ from ] != candidate._from_version ||
+            group_version[ to ] != candidate._to_version)
+        {
+            // stale entry, the edge was updated after it was queued
+            continue;
+        }
+
+        if (collapse_flips(from, to))
+        {
+            continue;
+        }
+
+        for (int t : group_triangles[ from ])
+        {
+            if (triangle_removed[ t ])
+            {
+                continue;
+            }
+
+            if (triangle_has_group(t, to))
+            {
+                triangle_removed[ t ] = true;
+                continue;
+            }
+
+            for (auto& v : triangles[ t ])
+            {
+                if (vertex_group[ v ] == from)
+                {
+                    v = pick_vertex(to, v);
+                }
+            }
+            group_triangles[ to ].push_back(t);
+        }
+
+        group_quadrics[ to ] += group_quadrics[ from ];
+        group_alive[ from ] = false;
+        group_triangles[ from ].clear();
+        std::erase_if(group_triangles[ to ],
+                      [ & ](int t) { return triangle_removed[ t ]; });
+        ++group_version[ to ];
+        applied_error = std::max(applied_error, candidate._cost);
+
+        neighbours.clear();
+        for (int t : group_triangles[ to ])
+        {
+            for (int v : triangles[ t ])
+            {
+                int g = vertex_group[ v ];
+                if (g != to &&
+                    std::find(neighbours.begin(), neighbours.end(), g) ==
+                        neighbours.end())
+                {
+                    neighbours.push_back(g);
+                }
+            }
+        }
+
+        for (int n : neighbours)
+        {
+            push_candidate(to, n);
+        }
+    }
+
+    // compact the survived vertices
+    std::vector<int> remap(vertices.size(), -1);
+    for (size_t t = 0; t < triangles.size(); ++t)
+    {
+        if (triangle_removed[ t ])
+        {
+            continue;
+        }
+
+        for (int v : triangles[ t ])
+        {
+            if (remap[ v ] < 0)
+            {
+                remap[ v ] = static_cast<int>(out_vertices.size());
+                out_vertices.push_back(vertices[ v ]);
+            }
+            out_indices.push_back(remap[ v ]);
+        }
+    }
+
+    return static_cast<float>(std::sqrt(applied_error));
+}
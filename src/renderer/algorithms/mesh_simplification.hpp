@@ -0,0 +1,27 @@
+#pragma once
+
+#include "vertex.hpp"
+
+/**
+ * @brief Simplifies a triangle mesh using quadric error metrics
+ *
+ * Edges are collapsed in the order of the smallest quadric error (Garland &
+ * Heckbert) until the next collapse would introduce an error bigger than
+ * @p max_error. Vertices sharing the same position are treated as a single
+ * topological vertex, so attribute seams don't tear apart.
+ *
+ * @param vertices source vertices
+ * @param indices source triangle list indices
+ * @param max_error the maximum allowed geometric deviation in model units
+ * @param out_vertices the simplified vertices
+ * @param out_indices the simplified triangle list indices
+ * @param locked the flags of the source vertices that must stay in place,
+ * none if null. The other vertices may still collapse into them
+ * @return float the error of the last collapse that was applied
+ */
+float simplify_mesh(const std::vector<vertex3d>& vertices,
+                    const std::vector<int>& indices,
+                    float max_error,
+                    std::vector<vertex3d>& out_vertices,
+                    std::vector<int>& out_indices,
+                    const std::vector<bool>* locked = nullptr);
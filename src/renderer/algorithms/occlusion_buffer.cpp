@@ -0,0 +1,288 @@
+#include "occlusion_buffer.hpp"
+
+#if defined(__AVX2__)
+#    define OCCLUSION_BUFFER_USE_AVX2
+#    include <immintrin.h>
+#endif
+
+namespace
+{
+static constexpr float FAR_DEPTH = 1.0f;
+static constexpr uint32_t ROW_ALIGNMENT = 8;
+
+// edge function a * x + b * y + c, positive on the inner side
+struct edge
+{
+    float a;
+    float b;
+    float c;
+
+    edge(glm::vec3 from, glm::vec3 to)
+        : a(from.y - to.y)
+        , b(to.x - from.x)
+        , c(-(a * from.x + b * from.y))
+    {
+    }
+};
+} // namespace
+
+occlusion_buffer::occlusion_buffer(glm::uvec2 size) { set_size(size); }
+
+void occlusion_buffer::set_size(glm::uvec2 size)
+{
+    size = glm::max(size, glm::uvec2 { 1, 1 });
+    size.x = (size.x + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+    _size = size;
+
+    _levels.clear();
+    while (true)
+    {
+        _levels.push_back({ size, std::vector<float>(size.x * size.y) });
+        if (size.x == 1 && size.y == 1)
+        {
+            break;
+        }
+        size = (size + 1u) / 2u;
+    }
+
+    clear();
+}
+
+glm::uvec2 occlusion_buffer::get_size() const { return _size; }
+
+void occlusion_buffer::clear()
+{
+    std::fill(_levels[ 0 ].depth.begin(), _levels[ 0 ].depth.end(), FAR_DEPTH);
+}
+
+void occlusion_buffer::rasterize(std::span<const vertex3d> vertices,
+                                 std::span<const int> indices,
+                                 const glm::mat4& mvp)
+{
+    const glm::vec2 half_size = glm::vec2 { _size } * 0.5f;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::array<glm::vec3, 3> screen;
+        bool clipped = false;
+        for (int c = 0; c < 3; ++c)
+        {
+            glm::vec4 clip =
+                mvp * glm::vec4(vertices[ indices[ i + c ] ].position(), 1.0f);
+            if (clip.w <= std::numeric_limits<float>::epsilon() ||
+                clip.z < -clip.w)
+            {
+                clipped = true;
+                break;
+            }
+
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            screen[ c ] = { (ndc.x + 1.0f) * half_size.x,
+                            (ndc.y + 1.0f) * half_size.y,
+                            std::min(ndc.z * 0.5f + 0.5f, FAR_DEPTH) };
+        }
+
+        if (!clipped)
+        {
+            rasterize_triangle(screen[ 0 ], screen[ 1 ], screen[ 2 ]);
+        }
+    }
+}
+
+void occlusion_buffer::build_hierarchy()
+{
+    for (size_t l = 1; l < _levels.size(); ++l)
+    {
+        const level& source = _levels[ l - 1 ];
+        level& target = _levels[ l ];
+        for (uint32_t y = 0; y < target.size.y; ++y)
+        {
+            uint32_t y0 = y * 2;
+            uint32_t y1 = std::min(y0 + 1, source.size.y - 1);
+            for (uint32_t x = 0; x < target.size.x; ++x)
+            {
+                uint32_t x0 = x * 2;
+                uint32_t x1 = std::min(x0 + 1, source.size.x - 1);
+                target.depth[ y * target.size.x + x ] =
+                    std::max({ source.depth[ y0 * source.size.x + x0 ],
+                               source.depth[ y0 * source.size.x + x1 ],
+                               source.depth[ y1 * source.size.x + x0 ],
+                               source.depth[ y1 * source.size.x + x1 ] });
+            }
+        }
+    }
+}
+
+bool occlusion_buffer::is_visible(glm::vec4 sphere, const glm::mat4& vp) const
+{
+    // the projected box around the sphere bounds the projected sphere
+    glm::vec3 center { sphere };
+    glm::vec2 min { std::numeric_limits<float>::max() };
+    glm::vec2 max { std::numeric_limits<float>::lowest() };
+    float depth = FAR_DEPTH;
+    const glm::vec2 half_size = glm::vec2 { _size } * 0.5f;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        glm::vec3 offset { corner & 1 ? sphere.w : -sphere.w,
+                           corner & 2 ? sphere.w : -sphere.w,
+                           corner & 4 ? sphere.w : -sphere.w };
+        glm::vec4 clip = vp * glm::vec4(center + offset, 1.0f);
+        if (clip.w <= std::numeric_limits<float>::epsilon() ||
+            clip.z < -clip.w)
+        {
+            // reaches behind the near plane, can't be occluded
+            return true;
+        }
+
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        glm::vec2 screen = (glm::vec2(ndc) + 1.0f) * half_size;
+        min = glm::min(min, screen);
+        max = glm::max(max, screen);
+        depth = std::min(depth, ndc.z * 0.5f + 0.5f);
+    }
+
+    return is_visible(min, max, depth);
+}
+
+bool occlusion_buffer::is_visible(glm::vec2 min,
+                                  glm::vec2 max,
+                                  float depth) const
+{
+    min = glm::max(min, glm::vec2 { 0.0f });
+    max = glm::min(max, glm::vec2 { _size } - 0.001f);
+    if (min.x > max.x || min.y > max.y)
+    {
+        // off the screen, left to the frustum culling
+        return true;
+    }
+
+    // the level where the rectangle covers at most 3x3 texels
+    float extent = std::max(max.x - min.x, max.y - min.y);
+    size_t level_index = 0;
+    while (level_index + 1 < _levels.size() &&
+           static_cast<float>(2u << level_index) < extent)
+    {
+        ++level_index;
+    }
+
+    const level& lvl = _levels[ level_index ];
+    const float scale = 1.0f / static_cast<float>(1u << level_index);
+    glm::uvec2 from = glm::uvec2 { min * scale };
+    glm::uvec2 to = glm::min(glm::uvec2 { max * scale }, lvl.size - 1u);
+    for (uint32_t y = from.y; y <= to.y; ++y)
+    {
+        for (uint32_t x = from.x; x <= to.x; ++x)
+        {
+            if (depth <= lvl.depth[ y * lvl.size.x + x ])
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+float occlusion_buffer::get_depth(glm::uvec2 pixel) const
+{
+    return _levels[ 0 ].depth[ pixel.y * _size.x + pixel.x ];
+}
+
+void occlusion_buffer::rasterize_triangle(glm::vec3 v0,
+                                          glm::vec3 v1,
+                                          glm::vec3 v2)
+{
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (area == 0.0f)
+    {
+        return;
+    }
+
+    // both windings occlude, make the triangle counter-clockwise
+    if (area < 0.0f)
+    {
+        std::swap(v1, v2);
+        area = -area;
+    }
+
+    glm::vec2 bb_min = glm::min(glm::min(glm::vec2(v0), glm::vec2(v1)),
+                                glm::vec2(v2));
+    glm::vec2 bb_max = glm::max(glm::max(glm::vec2(v0), glm::vec2(v1)),
+                                glm::vec2(v2));
+    int min_x = std::max(static_cast<int>(std::floor(bb_min.x)), 0);
+    int min_y = std::max(static_cast<int>(std::floor(bb_min.y)), 0);
+    int max_x = std::min(static_cast<int>(std::ceil(bb_max.x)),
+                         static_cast<int>(_size.x) - 1);
+    int max_y = std::min(static_cast<int>(std::ceil(bb_max.y)),
+                         static_cast<int>(_size.y) - 1);
+    if (min_x > max_x || min_y > max_y)
+    {
+        return;
+    }
+
+    // the weight of each vertex is the edge function of the opposite edge
+    const edge e0 { v1, v2 };
+    const edge e1 { v2, v0 };
+    const edge e2 { v0, v1 };
+    const float inv_area = 1.0f / area;
+    const float z_dx = (e0.a * v0.z + e1.a * v1.z + e2.a * v2.z) * inv_area;
+    const float z_dy = (e0.b * v0.z + e1.b * v1.z + e2.b * v2.z) * inv_area;
+    const float z_c = (e0.c * v0.z + e1.c * v1.z + e2.c * v2.z) * inv_area;
+
+    std::vector<float>& depth = _levels[ 0 ].depth;
+    for (int y = min_y; y <= max_y; ++y)
+    {
+        const float py = static_cast<float>(y) + 0.5f;
+        const float row0 = e0.b * py + e0.c;
+        const float row1 = e1.b * py + e1.c;
+        const float row2 = e2.b * py + e2.c;
+        const float row_z = z_dy * py + z_c;
+        float* row = depth.data() + static_cast<size_t>(y) * _size.x;
+
+#ifdef OCCLUSION_BUFFER_USE_AVX2
+        // the rows are padded to whole blocks, so the blocks never cross the
+        // end of the row
+        const __m256 lane_offsets =
+            _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+        const __m256 zero = _mm256_setzero_ps();
+        for (int x = min_x & ~(ROW_ALIGNMENT - 1); x <= max_x;
+             x += ROW_ALIGNMENT)
+        {
+            __m256 px = _mm256_add_ps(
+                _mm256_set1_ps(static_cast<float>(x)), lane_offsets);
+            __m256 w0 = _mm256_add_ps(
+                _mm256_mul_ps(_mm256_set1_ps(e0.a), px), _mm256_set1_ps(row0));
+            __m256 w1 = _mm256_add_ps(
+                _mm256_mul_ps(_mm256_set1_ps(e1.a), px), _mm256_set1_ps(row1));
+            __m256 w2 = _mm256_add_ps(
+                _mm256_mul_ps(_mm256_set1_ps(e2.a), px), _mm256_set1_ps(row2));
+            __m256 inside = _mm256_and_ps(
+                _mm256_and_ps(_mm256_cmp_ps(w0, zero, _CMP_GE_OQ),
+                              _mm256_cmp_ps(w1, zero, _CMP_GE_OQ)),
+                _mm256_cmp_ps(w2, zero, _CMP_GE_OQ));
+            if (_mm256_movemask_ps(inside) == 0)
+            {
+                continue;
+            }
+
+            __m256 z = _mm256_add_ps(
+                _mm256_mul_ps(_mm256_set1_ps(z_dx), px), _mm256_set1_ps(row_z));
+            __m256 old_z = _mm256_loadu_ps(row + x);
+            _mm256_storeu_ps(
+                row + x,
+                _mm256_blendv_ps(old_z, _mm256_min_ps(old_z, z), inside));
+        }
+#else
+        for (int x = min_x; x <= max_x; ++x)
+        {
+            const float px = static_cast<float>(x) + 0.5f;
+            if (e0.a * px + row0 < 0.0f || e1.a * px + row1 < 0.0f ||
+                e2.a * px + row2 < 0.0f)
+            {
+                continue;
+            }
+
+            row[ x ] = std::min(row[ x ], z_dx * px + row_z);
+        }
+#endif
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "vertex.hpp"
+
+/**
+ * @brief Low resolution depth buffer for the CPU occlusion culling
+ *
+ * The designated occluders are rasterized on the CPU into a small depth
+ * buffer, which is then reduced into a hierarchical Z pyramid keeping the
+ * farthest depth of every block. A bounding volume is occluded when its
+ * nearest depth lies behind the farthest occluder depth over its whole
+ * screen rectangle, which takes only a few texel reads at the matching
+ * pyramid level.
+ *
+ * The result depends only on the input, so the buffer can be tested without
+ * a GPU. Rows are rasterized eight pixels at a time when AVX2 is available.
+ */
+class occlusion_buffer
+{
+public:
+    explicit occlusion_buffer(glm::uvec2 size = { 256, 128 });
+
+    /**
+     * @brief Resize the buffer
+     *
+     * The width is rounded up to a multiple of eight.
+     *
+     * @param size the resolution in pixels
+     */
+    void set_size(glm::uvec2 size);
+    glm::uvec2 get_size() const;
+
+    /**
+     * @brief Reset the depth to the far plane
+     */
+    void clear();
+
+    /**
+     * @brief Rasterize the triangles of the occluder
+     *
+     * Triangles crossing the near plane are skipped, which can only make the
+     * culling less aggressive.
+     *
+     * @param vertices the vertices of the occluder
+     * @param indices triangle list indices
+     * @param mvp the model view projection matrix
+     */
+    void rasterize(std::span<const vertex3d> vertices,
+                   std::span<const int> indices,
+                   const glm::mat4& mvp);
+
+    /**
+     * @brief Build the hierarchical Z pyramid from the rasterized depth
+     *
+     * Must be called after the occluders are rasterized and before the
+     * visibility tests.
+     */
+    void build_hierarchy();
+
+    /**
+     * @brief Test the world space bounding sphere against the occluders
+     *
+     * @param sphere the center and the radius of the sphere
+     * @param vp the view projection matrix the occluders were rendered with
+     * @return true if any part of the sphere may be visible
+     */
+    bool is_visible(glm::vec4 sphere, const glm::mat4& vp) const;
+
+    /**
+     * @brief Test the screen rectangle against the occluders
+     *
+     * @param min the bottom-left corner in pixels
+     * @param max the top-right corner in pixels
+     * @param depth the nearest depth in [0, 1]
+     * @return true if any part of the rectangle may be visible
+     */
+    bool is_visible(glm::vec2 min, glm::vec2 max, float depth) const;
+
+    /**
+     * @brief Get the rasterized depth of the pixel
+     */
+    float get_depth(glm::uvec2 pixel) const;
+
+private:
+    void rasterize_triangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2);
+
+private:
+    struct level
+    {
+        glm::uvec2 size;
+        std::vector<float> depth;
+    };
+
+    glm::uvec2 _size;
+    // level 0 is the full resolution depth
+    std::vector<level> _levels;
+};
@@ -0,0 +1,196 @@
+#include <prof/profiler.hpp>
+
+#include "frame_graph.hpp"
+
+#include "logging.hpp"
+
+namespace
+{
+static logger log() { return get_logger("frame_graph"); }
+} // namespace
+
+frame_graph::builder::builder(frame_graph& graph, size_t pass)
+    : _graph(graph)
+    , _pass(pass)
+{
+}
+
+frame_graph::resource
+frame_graph::builder::create(std::string_view name,
+                             render_target_description description)
+{
+    _graph._physical_resources.push_back(
+        { std::string(name), description, nullptr, false });
+    _graph._resources.push_back({ _graph._physical_resources.size() - 1 });
+    return _graph._resources.size() - 1;
+}
+
+void frame_graph::builder::read(resource r)
+{
+    _graph._passes[ _pass ]._reads.push_back(r);
+}
+
+frame_graph::resource frame_graph::builder::write(resource r)
+{
+    // every write produces a new version of the same physical resource
+    _graph._resources.push_back(
+        { _graph._resources[ r ]._physical, static_cast<int>(_pass) });
+    resource version = _graph._resources.size() - 1;
+    _graph._passes[ _pass ]._writes.push_back(version);
+    return version;
+}
+
+void frame_graph::builder::set_side_effect()
+{
+    _graph._passes[ _pass ]._side_effect = true;
+}
+
+frame_graph::context::context(const frame_graph& graph)
+    : _graph(graph)
+{
+}
+
+framebuffer* frame_graph::context::get(resource r) const
+{
+    return _graph._physical_resources[ _graph._resources[ r ]._physical ]
+        ._target;
+}
+
+void frame_graph::add_pass(std::string_view name, setup_function setup)
+{
+    _passes.push_back({ std::string(name) });
+    builder b(*this, _passes.size() - 1);
+    auto execute = setup(b);
+    _passes.back()._execute = std::move(execute);
+}
+
+frame_graph::resource frame_graph::import_target(std::string_view name,
+                                                 framebuffer* target)
+{
+    _physical_resources.push_back({ std::string(name), {}, target, true });
+    _resources.push_back({ _physical_resources.size() - 1 });
+    return _resources.size() - 1;
+}
+
+void frame_graph::execute()
+{
+    auto sp = prof::profile(__FUNCTION__);
+    cull();
+
+    // lifetimes of the physical resources over the surviving passes
+    for (int i = 0; i < static_cast<int>(_passes.size()); ++i)
+    {
+        const auto& pass = _passes[ i ];
+        if (pass._ref_count == 0)
+        {
+            continue;
+        }
+
+        for (const auto* list : { &pass._reads, &pass._writes })
+        {
+            for (resource r : *list)
+            {
+                auto& physical =
+                    _physical_resources[ _resources[ r ]._physical ];
+                if (physical._first_pass < 0)
+                {
+                    physical._first_pass = i;
+                }
+                physical._last_pass = i;
+            }
+        }
+    }
+
+    auto* pool = render_target_pool::instance();
+    context ctx(*this);
+    for (int i = 0; i < static_cast<int>(_passes.size()); ++i)
+    {
+        auto& pass = _passes[ i ];
+        if (pass._ref_count == 0)
+        {
+            log()->trace("Pass {} is culled", pass._name);
+            continue;
+        }
+
+        for (auto& physical : _physical_resources)
+        {
+            if (!physical._imported && physical._first_pass == i)
+            {
+                physical._target = pool->acquire(physical._description);
+            }
+        }
+
+        if (pass._execute)
+        {
+            pass._execute(ctx);
+        }
+
+        // the memory can be reused by the next passes right away
+        for (auto& physical : _physical_resources)
+        {
+            if (!physical._imported && physical._last_pass == i)
+            {
+                pool->release(physical._target);
+                physical._target = nullptr;
+            }
+        }
+    }
+
+    pool->trim();
+}
+
+void frame_graph::cull()
+{
+    for (auto& pass : _passes)
+    {
+        pass._ref_count = static_cast<int>(pass._writes.size()) +
+                          (pass._side_effect ? 1 : 0);
+        for (resource r : pass._reads)
+        {
+            ++_resources[ r ]._ref_count;
+        }
+    }
+
+    std::vector<resource> unused;
+    auto release_inputs = [ & ](const pass_node& pass)
+    {
+        for (resource input : pass._reads)
+        {
+            if (--_resources[ input ]._ref_count == 0)
+            {
+                unused.push_back(input);
+            }
+        }
+    };
+
+    for (resource r = 0; r < _resources.size(); ++r)
+    {
+        if (_resources[ r ]._ref_count == 0)
+        {
+            unused.push_back(r);
+        }
+    }
+
+    for (const auto& pass : _passes)
+    {
+        if (pass._ref_count == 0)
+        {
+            release_inputs(pass);
+        }
+    }
+
+    // a pass is culled once none of its results are consumed, which in turn
+    // may leave its inputs without consumers
+    while (!unused.empty())
+    {
+        resource r = unused.back();
+        unused.pop_back();
+        int producer = _resources[ r ]._producer;
+        if (producer < 0 || --_passes[ producer ]._ref_count > 0)
+        {
+            continue;
+        }
+
+        release_inputs(_passes[ producer ]);
+    }
+}
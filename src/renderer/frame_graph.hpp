@@ -0,0 +1,142 @@
+#pragma once
+
+#include "render_target_pool.hpp"
+
+class framebuffer;
+
+/**
+ * @brief Declarative description of the rendering work of a frame
+ *
+ * Passes declare the render targets they create, read and write. Writing a
+ * resource produces its new version, so the graph knows exactly which pass
+ * consumes which result. On @ref execute the passes whose results nothing
+ * consumes are culled, unless they are marked as having side effects (e.g.
+ * presenting to the window), and the transient targets are acquired from
+ * the shared @ref render_target_pool for the span between their first and
+ * last use only. This way the equally described targets of different
+ * passes and different graphs alias the same memory as long as their
+ * lifetimes don't overlap.
+ *
+ * The passes are executed in the declaration order, which is always a valid
+ * order as a pass can only reference the resources declared before it.
+ */
+class frame_graph
+{
+public:
+    using resource = size_t;
+
+    class context;
+    using execute_function = std::function<void(const context&)>;
+
+    class builder
+    {
+    public:
+        /**
+         * @brief Declare a transient render target
+         *
+         * @param name the name of the resource, used for debugging
+         * @param description the description of the target
+         * @return resource the initial version of the target
+         */
+        resource create(std::string_view name,
+                        render_target_description description);
+
+        /**
+         * @brief Declare that the pass reads the resource version
+         */
+        void read(resource r);
+
+        /**
+         * @brief Declare that the pass writes the resource
+         *
+         * @param r the version to write
+         * @return resource the version produced by the pass
+         */
+        resource write(resource r);
+
+        /**
+         * @brief Keep the pass even when nothing consumes its results
+         */
+        void set_side_effect();
+
+    private:
+        builder(frame_graph& graph, size_t pass);
+
+    private:
+        frame_graph& _graph;
+        size_t _pass;
+
+        friend class frame_graph;
+    };
+
+    class context
+    {
+    public:
+        framebuffer* get(resource r) const;
+
+    private:
+        context(const frame_graph& graph);
+
+    private:
+        const frame_graph& _graph;
+
+        friend class frame_graph;
+    };
+
+    /**
+     * @brief The function declaring the resources of a pass
+     *
+     * Returns the function executing the pass, which can capture the
+     * resource versions declared in the setup.
+     */
+    using setup_function = std::function<execute_function(builder&)>;
+
+public:
+    void add_pass(std::string_view name, setup_function setup);
+
+    /**
+     * @brief Use a target that is not owned by the graph
+     *
+     * @param name the name of the resource, used for debugging
+     * @param target the target
+     * @return resource the initial version of the target
+     */
+    resource import_target(std::string_view name, framebuffer* target);
+
+    void execute();
+
+private:
+    void cull();
+
+private:
+    struct physical_resource
+    {
+        std::string _name;
+        render_target_description _description;
+        framebuffer* _target { nullptr };
+        bool _imported { false };
+        int _first_pass { -1 };
+        int _last_pass { -1 };
+    };
+
+    struct resource_node
+    {
+        size_t _physical;
+        int _producer { -1 };
+        int _ref_count { 0 };
+    };
+
+    struct pass_node
+    {
+        std::string _name;
+        std::vector<resource> _reads;
+        std::vector<resource> _writes;
+        bool _side_effect { false };
+        int _ref_count { 0 };
+        execute_function _execute;
+    };
+
+    std::vector<physical_resource> _physical_resources;
+    std::vector<resource_node> _resources;
+    std::vector<pass_node> _passes;
+};
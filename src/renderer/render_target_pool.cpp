@@ -0,0 +1,97 @@
+#include "render_target_pool.hpp"
+
+#include "framebuffer.hpp"
+#include "logging.hpp"
+
+namespace
+{
+static logger log() { return get_logger("render_target_pool"); }
+} // namespace
+
+framebuffer*
+render_target_pool::acquire(const render_target_description& description)
+{
+    context_targets& targets = current_targets();
+    for (auto& e : targets._entries)
+    {
+        if (!e._in_use && e._description == description)
+        {
+            e._in_use = true;
+            e._last_use = targets._execution;
+            return e._target.get();
+        }
+    }
+
+    auto target = std::make_unique<framebuffer>();
+    target->set_samples(description.samples);
+    target->set_object_ids(description.object_ids);
+    target->resize(description.size);
+    target->initialize();
+    target->unbind();
+
+    log()->debug("New render target {}x{} ({} samples), {} in the context",
+                 description.size.x,
+                 description.size.y,
+                 description.samples,
+                 targets._entries.size() + 1);
+    targets._entries.push_back(
+        { description, std::move(target), true, targets._execution });
+    return targets._entries.back()._target.get();
+}
+
+void render_target_pool::release(framebuffer* target)
+{
+    context_targets& targets = current_targets();
+    for (auto& e : targets._entries)
+    {
+        if (e._target.get() == target)
+        {
+            e._in_use = false;
+            e._last_use = targets._execution;
+            return;
+        }
+    }
+
+    log()->warn("Released a render target not acquired in this context");
+}
+
+void render_target_pool::trim()
+{
+    // the other contexts trim their targets while they are current, so the
+    // framebuffer names are deleted in the context owning them
+    context_targets& targets = current_targets();
+    ++targets._execution;
+    std::erase_if(targets._entries,
+                  [ &targets ](const entry& e)
+                  {
+                      return !e._in_use && targets._execution - e._last_use >
+                                               max_idle_executions;
+                  });
+}
+
+size_t render_target_pool::get_target_count() const
+{
+    size_t count = 0;
+    for (const auto& [ _, targets ] : _contexts)
+    {
+        count += targets._entries.size();
+    }
+    return count;
+}
+
+render_target_pool* render_target_pool::instance()
+{
+    if (!_instance)
+    {
+        _instance = new render_target_pool;
+    }
+
+    return _instance;
+}
+
+render_target_pool::context_targets& render_target_pool::current_targets()
+{
+    return _contexts[ glfwGetCurrentContext() ];
+}
+
+render_target_pool* render_target_pool::_instance = nullptr;
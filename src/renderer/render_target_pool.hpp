@@ -0,0 +1,75 @@
+#pragma once
+
+class framebuffer;
+struct GLFWwindow;
+
+struct render_target_description
+{
+    glm::uvec2 size { 1, 1 };
+    unsigned samples { 1 };
+    bool object_ids { false };
+
+    bool operator==(const render_target_description& other) const = default;
+};
+
+/**
+ * @brief Shared storage of the transient render targets
+ *
+ * The frame graphs acquire the targets for the lifetime of their resources
+ * and release them right after the last pass using them, so the targets
+ * with the same description are reused by the later passes and graphs.
+ * Targets that stay unused for a while are destroyed.
+ *
+ * The aliasing is by the lifetime only: a released target is handed out
+ * again for an equal description, never for a smaller size or a subset of
+ * its attachments. The passes render to, sample and blit the whole target
+ * and the framebuffer has no way to restrict those to a sub-rectangle, so a
+ * larger target would change their results. The resources of the same size
+ * share the targets, e.g. the consecutive cameras rendering to same-sized
+ * viewports, while a resized viewport gets new targets and its old ones are
+ * trimmed once idle.
+ *
+ * The framebuffer objects aren't shared between the GL contexts, so every
+ * context has its own set of targets. All the calls work on the targets of
+ * the current context.
+ */
+class render_target_pool
+{
+public:
+    framebuffer* acquire(const render_target_description& description);
+    void release(framebuffer* target);
+
+    /**
+     * @brief Destroy the targets of the current context unused for too long
+     *
+     * Expected to be called once per frame graph execution.
+     */
+    void trim();
+
+    size_t get_target_count() const;
+
+    static render_target_pool* instance();
+
+private:
+    struct entry
+    {
+        render_target_description _description;
+        std::unique_ptr<framebuffer> _target;
+        bool _in_use { false };
+        uint64_t _last_use { 0 };
+    };
+
+    struct context_targets
+    {
+        std::vector<entry> _entries;
+        uint64_t _execution { 0 };
+    };
+
+    context_targets& current_targets();
+
+    // the executions a target may stay unused before being destroyed
+    static constexpr uint64_t max_idle_executions = 240;
+
+    std::unordered_map<GLFWwindow*, context_targets> _contexts;
+    static render_target_pool* _instance;
+};
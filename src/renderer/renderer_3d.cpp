@@ -5,14 +5,35 @@
 #include "asset_manager.hpp"
 #include "camera.hpp"
 #include "experimental/viewport.hpp"
+#include "font.hpp"
 #include "glad/gl.h"
 #include "graphics_buffer.hpp"
-#include "material.hpp"
 #include "mesh.hpp"
+#include "shader.hpp"
 #include "vaomap.hpp"
 #include "vertex.hpp"
 
-void renderer_3d::draw_mesh(mesh* m, material* mat)
+namespace
+{
+void set_draw_uniforms(shader_program& program,
+                       const glm::mat4& model_matrix,
+                       uint32_t object_id)
+{
+    program.set_uniform("u_model_matrix", model_matrix);
+    program.set_uniform("u_object_id", static_cast<unsigned>(object_id));
+    if (auto cam = camera::active_camera())
+    {
+        program.set_uniform("u_vp_matrix", cam->frame_vp_matrix());
+        program.set_uniform("u_camera_position",
+                            cam->get_frame_transform().get_position());
+    }
+}
+} // namespace
+
+void renderer_3d::draw_mesh(mesh* m,
+                            const material::snapshot& mat,
+                            const glm::mat4& model_matrix,
+                            uint32_t object_id)
 {
     auto sp = prof::profile(__FUNCTION__);
     if (_vao.activate())
@@ -25,17 +46,81 @@ void renderer_3d::draw_mesh(mesh* m, material* mat)
 
     vertex3d::activate_attributes();
 
-    if (auto cam = camera::active_camera())
+    // the values of the draw go to the program, the material is shared
+    auto set_uniforms = [ &model_matrix, object_id ](shader_program& program)
+    { set_draw_uniforms(program, model_matrix, object_id); };
+    if (!mat.activate(set_uniforms))
     {
-        mat->set_property_value("u_vp_matrix", cam->vp_matrix());
-        mat->set_property_value("u_camera_position",
-                                cam->get_transform().get_position());
+        return;
     }
 
-    mat->activate();
-
     glDrawElements(GL_TRIANGLES,
                    m->get_index_buffer().get_element_count(),
                    GL_UNSIGNED_INT,
                    0);
 }
+
+void renderer_3d::draw_text(const font& f,
+                            std::string_view text,
+                            const material::snapshot& mat,
+                            const glm::mat4& model_matrix,
+                            uint32_t object_id)
+{
+    auto sp = prof::profile(__FUNCTION__);
+    if (text.empty())
+    {
+        return;
+    }
+
+    // a quad of the positions and the texture coordinates per glyph
+    std::vector<glm::vec4> vertices;
+    vertices.reserve(text.size() * 6);
+    float cursor = 0.0f;
+    for (char c : text)
+    {
+        const font::character& ch = f[ c ];
+        float x = cursor + ch._bearing.x;
+        float y = -static_cast<float>(ch._size.y - ch._bearing.y);
+        float w = ch._size.x;
+        float h = ch._size.y;
+        vertices.insert(vertices.end(),
+                        { { x, y + h, 0.0f, 0.0f },
+                          { x, y, 0.0f, 1.0f },
+                          { x + w, y, 1.0f, 1.0f },
+                          { x, y + h, 0.0f, 0.0f },
+                          { x + w, y, 1.0f, 1.0f },
+                          { x + w, y + h, 1.0f, 0.0f } });
+        // the advance is in 1/64 pixels
+        cursor += ch._advance >> 6;
+    }
+
+    graphics_buffer vbo(graphics_buffer::type::vertex);
+    vbo.set_element_stride(sizeof(glm::vec4));
+    vbo.set_element_count(vertices.size());
+    vbo.set_data(vertices.data());
+
+    if (_vao.activate())
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo.get_handle());
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), 0);
+        glEnableVertexAttribArray(0);
+    }
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    auto set_uniforms = [ &model_matrix, object_id ](shader_program& program)
+    { set_draw_uniforms(program, model_matrix, object_id); };
+    if (mat.activate(set_uniforms))
+    {
+        glActiveTexture(GL_TEXTURE0);
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            glBindTexture(GL_TEXTURE_2D, f[ text[ i ] ]._texture_id);
+            glDrawArrays(GL_TRIANGLES, i * 6, 6);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        shader_program::unuse();
+    }
+    glBindVertexArray(0);
+    glDisable(GL_BLEND);
+}
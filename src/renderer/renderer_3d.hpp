@@ -1,15 +1,42 @@
 #pragma once
 
+#include "material.hpp"
 #include "renderer.hpp"
 #include "vaomap.hpp"
 
-class material;
+class font;
 class mesh;
 
 class renderer_3d : public renderer
 {
 public:
-    void draw_mesh(mesh* m, material* mat);
+    /**
+     * @brief Draw the mesh with the material
+     *
+     * @param m the mesh to draw
+     * @param mat the material the mesh is drawn with
+     * @param model_matrix the transform of the mesh
+     * @param object_id the id written for the picking, 0 for none
+     */
+    void draw_mesh(mesh* m,
+                   const material::snapshot& mat,
+                   const glm::mat4& model_matrix,
+                   uint32_t object_id = 0);
+
+    /**
+     * @brief Draw the text in the plane of the model, starting at its origin
+     *
+     * @param f the font providing the glyphs
+     * @param text the text to draw
+     * @param mat the material the glyphs are drawn with
+     * @param model_matrix the transform of the text
+     * @param object_id the id written for the picking, 0 for none
+     */
+    void draw_text(const font& f,
+                   std::string_view text,
+                   const material::snapshot& mat,
+                   const glm::mat4& model_matrix,
+                   uint32_t object_id = 0);
 
 private:
     vao_map _vao;
@@ -0,0 +1,132 @@
+#include "resolution_scaler.hpp"
+
+namespace
+{
+// the weight of the newest measurement in the smoothed frame time
+static constexpr double SMOOTHING = 0.1;
+// the relative change of the scale that is not worth reacting to, so the
+// resolution doesn't flicker around the budget
+static constexpr float DEAD_ZONE = 0.02f;
+// the fraction of the correction applied per measurement
+static constexpr float RESPONSE = 0.25f;
+} // namespace
+
+resolution_scaler::resolution_scaler() = default;
+
+resolution_scaler::~resolution_scaler()
+{
+    if (_queries[ 0 ] != 0)
+    {
+        glDeleteQueries(_queries.size(), _queries.data());
+    }
+}
+
+void resolution_scaler::set_target_frame_time(
+    std::chrono::duration<double> frame_time)
+{
+    _target_frame_time = frame_time;
+}
+
+std::chrono::duration<double> resolution_scaler::get_target_frame_time() const
+{
+    return _target_frame_time;
+}
+
+void resolution_scaler::set_scale_range(float min_scale, float max_scale)
+{
+    _min_scale = std::clamp(min_scale, 0.1f, 1.0f);
+    _max_scale = std::clamp(max_scale, _min_scale, 1.0f);
+    _scale = std::clamp(_scale, _min_scale, _max_scale);
+}
+
+float resolution_scaler::get_min_scale() const { return _min_scale; }
+
+float resolution_scaler::get_max_scale() const { return _max_scale; }
+
+float resolution_scaler::get_scale() const { return _scale; }
+
+void resolution_scaler::begin_frame()
+{
+    if (_queries[ 0 ] == 0)
+    {
+        glGenQueries(_queries.size(), _queries.data());
+    }
+
+    end_frame();
+    _current_query = (_current_query + 1) % query_count;
+    glBeginQuery(GL_TIME_ELAPSED, _queries[ _current_query ]);
+    _query_active = true;
+}
+
+void resolution_scaler::end_frame()
+{
+    if (!_query_active)
+    {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    _query_pending[ _current_query ] = true;
+    _query_active = false;
+}
+
+void resolution_scaler::reset()
+{
+    _smoothed_frame_time = 0.0;
+    _scale = _max_scale;
+}
+
+void resolution_scaler::update()
+{
+    if (_queries[ 0 ] == 0)
+    {
+        return;
+    }
+
+    // visit the queries from the oldest to the newest
+    for (size_t i = 1; i <= query_count; ++i)
+    {
+        size_t index = (_current_query + i) % query_count;
+        if (!_query_pending[ index ])
+        {
+            continue;
+        }
+
+        int available = 0;
+        glGetQueryObjectiv(
+            _queries[ index ], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            // the newer ones can't be ready either
+            break;
+        }
+
+        uint64_t elapsed = 0;
+        glGetQueryObjectui64v(_queries[ index ], GL_QUERY_RESULT, &elapsed);
+        _query_pending[ index ] = false;
+        update_scale(static_cast<double>(elapsed) * 1e-9);
+    }
+}
+
+void resolution_scaler::update_scale(double frame_time)
+{
+    _smoothed_frame_time =
+        _smoothed_frame_time == 0.0
+            ? frame_time
+            : std::lerp(_smoothed_frame_time, frame_time, SMOOTHING);
+    if (_smoothed_frame_time <= 0.0)
+    {
+        return;
+    }
+
+    float desired_scale = _scale * static_cast<float>(std::sqrt(
+                                       _target_frame_time.count() /
+                                       _smoothed_frame_time));
+    desired_scale = std::clamp(desired_scale, _min_scale, _max_scale);
+    if (std::abs(desired_scale - _scale) < _scale * DEAD_ZONE)
+    {
+        return;
+    }
+
+    _scale += (desired_scale - _scale) * RESPONSE;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+/**
+ * @brief Adjusts the render resolution to keep the GPU time within a budget
+ *
+ * The GPU time of every frame is measured with timer queries. The results
+ * are read back a few frames later, so the measurement never stalls the
+ * pipeline. The scale is then moved towards the value that would fit the
+ * smoothed frame time into the budget, taking into account that the cost
+ * grows with the pixel count, i.e. with the square of the scale.
+ */
+class resolution_scaler
+{
+public:
+    resolution_scaler();
+    ~resolution_scaler();
+
+    /**
+     * @brief Set the GPU time budget of a single frame
+     *
+     * @param frame_time the budget
+     */
+    void set_target_frame_time(std::chrono::duration<double> frame_time);
+    std::chrono::duration<double> get_target_frame_time() const;
+
+    void set_scale_range(float min_scale, float max_scale);
+    float get_min_scale() const;
+    float get_max_scale() const;
+
+    /**
+     * @brief Get the factor applied to the both dimensions of the target
+     *
+     * @return float the scale within the configured range
+     */
+    float get_scale() const;
+
+    /**
+     * @brief Update the scale from the measurements that became available
+     *
+     * Never waits for the GPU.
+     */
+    void update();
+
+    void begin_frame();
+    void end_frame();
+
+    void reset();
+
+private:
+    void update_scale(double frame_time);
+
+private:
+    static constexpr size_t query_count = 4;
+
+    std::array<unsigned, query_count> _queries {};
+    std::array<bool, query_count> _query_pending {};
+    size_t _current_query { 0 };
+    bool _query_active { false };
+
+    std::chrono::duration<double> _target_frame_time { 1.0 / 60.0 };
+    double _smoothed_frame_time { 0.0 };
+    float _min_scale { 0.5f };
+    float _max_scale { 1.0f };
+    float _scale { 1.0f };
+};
@@ -1,11 +1,24 @@
 #include "scene.hpp"
 
+#include "game_object.hpp"
+
 scene::scene() { _scene_instance = this; }
 
 const std::vector<game_object*>& scene::objects() const { return _objects; }
 
 void scene::add_object(game_object* object) { _objects.push_back(object); }
 
+game_object* scene::find_object(uint32_t id) const
+{
+    auto it = std::find_if(_objects.begin(),
+                           _objects.end(),
+                           [ id ](const game_object* object)
+    { return object->get_id() == id; });
+    return it == _objects.end() ? nullptr : *it;
+}
+
+light_registry& scene::get_light_registry() { return _light_registry; }
+
 scene* scene::get_active_scene() { return _scene_instance; }
 
 scene* scene::_scene_instance = nullptr;
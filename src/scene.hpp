@@ -1,5 +1,7 @@
 #pragma once
 
+#include "light_registry.hpp"
+
 // TODO: the implementation is very draft and needs redoing
 
 class game_object;
@@ -12,9 +14,19 @@ public:
     const std::vector<game_object*>& objects() const;
     void add_object(game_object* object);
 
+    /**
+     * @brief Find the object by its id
+     *
+     * @return the object, or null if it isn't in the scene
+     */
+    game_object* find_object(uint32_t id) const;
+
+    light_registry& get_light_registry();
+
     static scene* get_active_scene();
 
 private:
     std::vector<game_object*> _objects;
+    light_registry _light_registry;
     static scene* _scene_instance;
 };
@@ -3,10 +3,39 @@
 #include "camera.hpp"
 #include "file.hpp"
 #include "logging.hpp"
+#include "program_binary_cache.hpp"
+#include "shader_preprocessor.hpp"
 
 namespace
 {
 static inline logger log() { return get_logger("shader"); }
+
+// GL_KHR_parallel_shader_compile isn't part of the generated loader
+constexpr GLenum COMPLETION_STATUS_KHR = 0x91B1;
+using max_shader_compiler_threads_proc = void(GLAD_API_PTR*)(GLuint);
+
+bool parallel_compile_supported()
+{
+    static const bool supported = []
+    {
+        if (!glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+        {
+            log()->info("Parallel shader compiling is not supported");
+            return false;
+        }
+
+        auto max_threads =
+            reinterpret_cast<max_shader_compiler_threads_proc>(
+                glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+        if (max_threads)
+        {
+            // let the driver decide how many threads to use
+            max_threads(0xFFFFFFFF);
+        }
+        return true;
+    }();
+    return supported;
+}
 } // namespace
 
 shader::shader(shader_type type)
@@ -59,7 +88,18 @@ void shader::compile()
         return;
     }
 
+    // the compiler threads must be set up before the first submission
+    parallel_compile_supported();
     glCompileShader(_id);
+    _status = status::compiling;
+}
+
+bool shader::finish_compile()
+{
+    if (_status != status::compiling)
+    {
+        return _status == status::compiled;
+    }
 
     int error_code;
     glGetShaderiv(_id, GL_COMPILE_STATUS, &error_code);
@@ -68,11 +108,23 @@ void shader::compile()
         int log_length = 0;
         char msg[ 1024 ];
         glGetShaderInfoLog(_id, 1024, &log_length, msg);
-        log()->error("Failed to compile shader {}({}): {}", _id, _path, msg);
-        return;
+        // the messages refer to the files by their indices
+        std::string files;
+        for (size_t i = 0; i < _files.size(); ++i)
+        {
+            files += "\n\t" + std::to_string(i) + ": " + _files[ i ].string();
+        }
+        log()->error("Failed to compile shader {}({}): {}\nSource files:{}",
+                     _id,
+                     _path,
+                     msg,
+                     files);
+        _status = status::updated;
+        return false;
     }
 
     _status = status::compiled;
+    return true;
 }
 
 void shader::deinit()
@@ -99,7 +151,18 @@ void shader::set_path(std::string_view path) { _path = path; }
 
 int shader::id() const { return _id; }
 
-shader shader::from_file(std::string_view path)
+shader shader::from_file(std::string_view path,
+                         const std::vector<std::string>& defines)
+{
+    std::vector<std::filesystem::path> files;
+    std::string code =
+        shader_preprocessor::process(path, defines, nullptr, &files);
+    return from_source(path, code, std::move(files));
+}
+
+shader shader::from_source(std::string_view path,
+                           std::string_view code,
+                           std::vector<std::filesystem::path> files)
 {
     std::string_view extension = path.substr(path.find_last_of("."));
     shader_type type = shader_type::VERTEX;
@@ -113,10 +176,10 @@ shader shader::from_file(std::string_view path)
     }
     shader result(type);
 
-    std::string data = file::read_all(path);
     result.set_path(path);
+    result._files = std::move(files);
     result.init();
-    result.set_source(data);
+    result.set_source(code);
     result.compile();
     return result;
 }
@@ -128,6 +191,13 @@ shader_program::shader_program(shader_program&& other)
     _status = other._status;
     _id = other._id;
     _shaders = std::move(other._shaders);
+    _sources = std::move(other._sources);
+    _source_files = std::move(other._source_files);
+    _stage_sources = std::move(other._stage_sources);
+    _cache_key = std::move(other._cache_key);
+    _features = std::move(other._features);
+    _variants = std::move(other._variants);
+    _name = std::move(other._name);
     _properties = std::move(other._properties);
     _name_property_map = std::move(other._name_property_map);
     other._id = 0;
@@ -136,9 +206,24 @@ shader_program::shader_program(shader_program&& other)
 
 shader_program& shader_program::operator=(shader_program&& other)
 {
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    // the program is replaced, e.g. by the reloaded one
+    deinit();
+    ++_revision;
     _status = other._status;
     _id = other._id;
     _shaders = std::move(other._shaders);
+    _sources = std::move(other._sources);
+    _source_files = std::move(other._source_files);
+    _stage_sources = std::move(other._stage_sources);
+    _cache_key = std::move(other._cache_key);
+    _features = std::move(other._features);
+    _variants = std::move(other._variants);
+    _name = std::move(other._name);
     _properties = std::move(other._properties);
     _name_property_map = std::move(other._name_property_map);
     other._id = 0;
@@ -176,7 +261,74 @@ void shader_program::link()
         return;
     }
 
+    if (!_stage_sources.empty())
+    {
+        std::vector<std::string_view> codes;
+        for (const auto& stage : _stage_sources)
+        {
+            codes.push_back(stage.code);
+        }
+
+        _cache_key = program_binary_cache::make_key(codes);
+        if (program_binary_cache::load(_cache_key, _id))
+        {
+            _stage_sources.clear();
+            _cache_key.clear();
+            _status = status::linked;
+            resolve_uniforms();
+            return;
+        }
+
+        for (const auto& stage : _stage_sources)
+        {
+            _shaders.push_back(
+                shader::from_source(stage.path, stage.code, stage.files));
+            glAttachShader(_id, _shaders.back().id());
+        }
+        _stage_sources.clear();
+        glProgramParameteri(_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     glLinkProgram(_id);
+    _status = status::linking;
+}
+
+bool shader_program::is_ready()
+{
+    if (_status != status::linking)
+    {
+        return true;
+    }
+
+    if (!parallel_compile_supported())
+    {
+        finish();
+        return true;
+    }
+
+    int completed = GL_FALSE;
+    glGetProgramiv(_id, COMPLETION_STATUS_KHR, &completed);
+    if (completed == GL_FALSE)
+    {
+        return false;
+    }
+
+    finish();
+    return true;
+}
+
+void shader_program::finish()
+{
+    if (_status != status::linking)
+    {
+        return;
+    }
+
+    // the link failure alone doesn't tell which stage is broken
+    for (auto& sh : _shaders)
+    {
+        sh.finish_compile();
+    }
 
     int error_code;
     glGetProgramiv(_id, GL_LINK_STATUS, &error_code);
@@ -185,16 +337,24 @@ void shader_program::link()
         int log_length = 0;
         char msg[ 1024 ];
         glGetProgramInfoLog(_id, 1024, &log_length, msg);
-        log()->error("Failed to link program {}: {}", _id, msg);
+        log()->error("Failed to link program {}({}): {}", _id, _name, msg);
+        _status = status::failed;
         return;
     }
 
     _status = status::linked;
     resolve_uniforms();
+
+    if (!_cache_key.empty())
+    {
+        program_binary_cache::store(_cache_key, _id);
+        _cache_key.clear();
+    }
 }
 
-void shader_program::use() const
+void shader_program::use()
 {
+    finish();
     if (_status != status::linked)
     {
         log()->warn("The shader program is not linked");
@@ -220,18 +380,80 @@ void shader_program::deinit()
     _status = status::uninitialized;
 }
 
+void shader_program::declare_feature(std::string define, std::string property)
+{
+    if (_features.size() == max_features)
+    {
+        log()->error("Shader program {} can't have more than {} features",
+                     _name,
+                     max_features);
+        return;
+    }
+
+    _features.push_back({ std::move(define), std::move(property) });
+}
+
+const std::vector<shader_program::feature>& shader_program::get_features() const
+{
+    return _features;
+}
+
+uint32_t shader_program::get_all_features() const
+{
+    return _features.size() == max_features
+               ? ~uint32_t { 0 }
+               : (uint32_t { 1 } << _features.size()) - 1;
+}
+
+shader_program* shader_program::get_variant(uint32_t features)
+{
+    features &= get_all_features();
+    if (features == get_all_features())
+    {
+        return this;
+    }
+
+    if (auto it = _variants.find(features); it != _variants.end())
+    {
+        return it->second.get();
+    }
+
+    auto variant = std::make_unique<shader_program>();
+    variant->init();
+    variant->set_name(std::format("{}#{:x}", _name, features));
+    std::vector<std::string> defines = feature_defines(features);
+    for (const auto& source : _sources)
+    {
+        variant->add_stage(source, defines);
+    }
+    variant->link();
+
+    // a failed variant stays cached, so it's not rebuilt on every use
+    log()->debug("Submitted the shader variant {}", variant->get_name());
+    return _variants.emplace(features, std::move(variant)).first->second.get();
+}
+
 void shader_program::add_shader(std::string_view path)
 {
-    _shaders.push_back(shader::from_file(path));
-    glAttachShader(_id, _shaders.back().id());
+    _sources.emplace_back(path);
+    add_stage(path, feature_defines(get_all_features()));
+}
+
+const std::set<std::filesystem::path>& shader_program::get_source_files() const
+{
+    return _source_files;
 }
 
 void shader_program::release_shaders() { _shaders.clear(); }
 
 int shader_program::id() const { return _id; }
 
+unsigned shader_program::get_revision() const { return _revision; }
+
 bool shader_program::linked() const { return _status == status::linked; }
 
+bool shader_program::failed() const { return _status == status::failed; }
+
 void shader_program::set_name(std::string name) { _name = std::move(name); }
 
 std::string shader_program::get_name() const { return _name; }
@@ -240,6 +462,8 @@ void shader_program::unuse() { glUseProgram(0); }
 
 void shader_program::set_uniform(std::string_view name, std::any value)
 {
+    // the uniforms are known only after linking
+    finish();
     auto iterator = _name_property_map.find(name);
     if (iterator != _name_property_map.end())
     {
@@ -247,6 +471,29 @@ void shader_program::set_uniform(std::string_view name, std::any value)
     }
 }
 
+void shader_program::add_stage(std::string_view path,
+                               const std::vector<std::string>& defines)
+{
+    stage_source stage { std::string(path) };
+    stage.code = shader_preprocessor::process(
+        path, defines, &_source_files, &stage.files);
+    _stage_sources.push_back(std::move(stage));
+}
+
+std::vector<std::string>
+shader_program::feature_defines(uint32_t features) const
+{
+    std::vector<std::string> defines;
+    for (size_t i = 0; i < _features.size(); ++i)
+    {
+        if (features & (uint32_t { 1 } << i))
+        {
+            defines.push_back(_features[ i ].define);
+        }
+    }
+    return defines;
+}
+
 void shader_program::resolve_uniforms()
 {
     use();
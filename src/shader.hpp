@@ -18,6 +18,7 @@ public:
         uninitialized,
         initialized,
         updated,
+        compiling,
         compiled,
     };
 
@@ -25,19 +26,45 @@ public:
     shader(shader_type type);
 
     void init();
+    /**
+     * @brief Submit the shader for compiling
+     *
+     * The result isn't queried here, so the driver may compile several
+     * shaders at once. See @ref finish_compile.
+     */
     void compile();
+    /**
+     * @brief Wait for the submitted compile and report its result
+     *
+     * @return true if the shader compiled successfully
+     */
+    bool finish_compile();
     void deinit();
     void set_source(std::string_view source_code);
     void set_path(std::string_view path);
     int id() const;
 
-    static shader from_file(std::string_view path);
+    static shader from_file(std::string_view path,
+                            const std::vector<std::string>& defines = {});
+    /**
+     * @brief Create and submit the shader for compiling
+     *
+     * @param path the path the shader is reported by
+     * @param code the preprocessed source
+     * @param files the files by the indices of the `#line` directives of the
+     * source, listed with the compile errors
+     */
+    static shader
+    from_source(std::string_view path,
+                std::string_view code,
+                std::vector<std::filesystem::path> files = {});
 
 private:
     status _status = status::uninitialized;
     int _id = 0;
     shader_type _type;
     std::string _path = "unknown";
+    std::vector<std::filesystem::path> _files;
 };
 
 class shader_program
@@ -48,9 +75,25 @@ public:
         uninitialized,
         initialized,
         updated,
+        linking,
         linked,
+        failed,
     };
 
+    /**
+     * @brief Optional part of the shader, compiled in by defining the macro
+     *
+     * A material enables the feature when it sets the controlling property
+     * to a non-zero value.
+     */
+    struct feature
+    {
+        std::string define;
+        std::string property;
+    };
+
+    static constexpr size_t max_features = 32;
+
 public:
     shader_program();
     shader_program(const shader_program& other) = delete;
@@ -60,13 +103,77 @@ public:
     ~shader_program();
 
     void init();
+    /**
+     * @brief Submit the program for linking
+     *
+     * The added shaders are compiled here, unless the program binary cache
+     * has the program already. Doesn't wait for the driver, the program
+     * becomes usable once @ref is_ready reports true or it's finished on the
+     * first use.
+     */
     void link();
-    void use() const;
+    /**
+     * @brief Check whether the submitted compile and link are done
+     *
+     * Never blocks when GL_KHR_parallel_shader_compile is available.
+     * Otherwise the completion can't be polled, so the program is finished
+     * here. Either way a ready program is linked or has failed.
+     */
+    bool is_ready();
+    /**
+     * @brief Block until the program is linked and resolve its uniforms
+     */
+    void finish();
+    void use();
     void deinit();
+    /**
+     * @brief Declare an optional feature of the shader
+     *
+     * Must be declared before adding the shaders. The program itself is
+     * compiled with all the features enabled.
+     *
+     * @param define the macro guarding the feature in the sources
+     * @param property the material property controlling the feature
+     */
+    void declare_feature(std::string define, std::string property);
+    const std::vector<feature>& get_features() const;
+    uint32_t get_all_features() const;
+
+    /**
+     * @brief Get the program specialized for the subset of the features
+     *
+     * The variants are submitted for compiling on the first request and
+     * cached by the feature mask. A fresh variant may not be ready yet and a
+     * failed one is never linked, check both before drawing with it.
+     *
+     * @param features the mask of the enabled features, bit i stands for
+     * the feature i in the declaration order
+     * @return shader_program* the variant, this program if all the features
+     * are enabled
+     */
+    shader_program* get_variant(uint32_t features);
+
     void add_shader(std::string_view path);
+    /**
+     * @brief Get the files the stages are built from, including the files
+     * included by the sources
+     */
+    const std::set<std::filesystem::path>& get_source_files() const;
     void release_shaders();
     int id() const;
+    /**
+     * @brief Get the number of the times the program was replaced by moving
+     * another one into it
+     *
+     * The variants of the replaced program are gone, so the users caching
+     * them compare the revision.
+     */
+    unsigned get_revision() const;
     bool linked() const;
+    /**
+     * @brief Check whether the last link of the program failed
+     */
+    bool failed() const;
     void set_name(std::string name);
     std::string get_name() const;
 
@@ -75,14 +182,32 @@ public:
     void set_uniform(std::string_view name, std::any value);
 
 private:
+    struct stage_source
+    {
+        std::string path;
+        std::string code;
+        std::vector<std::filesystem::path> files;
+    };
+
+    void add_stage(std::string_view path,
+                   const std::vector<std::string>& defines);
     void resolve_uniforms();
     void setup_property_values() const;
+    std::vector<std::string> feature_defines(uint32_t features) const;
 
 private:
     status _status = status::uninitialized;
     int _id = 0;
     std::vector<shader> _shaders;
+    std::vector<std::string> _sources;
+    std::set<std::filesystem::path> _source_files;
+    // preprocessed, but not yet compiled stages
+    std::vector<stage_source> _stage_sources;
+    std::string _cache_key;
+    std::vector<feature> _features;
+    std::unordered_map<uint32_t, std::unique_ptr<shader_program>> _variants;
     std::string _name;
+    unsigned _revision = 0;
     static glm::mat4 _view_matrix;
     static glm::mat4 _projection_matrix;
     std::vector<uniform_info> _properties;
@@ -0,0 +1,134 @@
+#include "shader_preprocessor.hpp"
+
+#include "file.hpp"
+#include "file_view.hpp"
+#include "logging.hpp"
+
+namespace
+{
+static inline logger log() { return get_logger("shader_preprocessor"); }
+
+std::string_view trim(std::string_view line)
+{
+    size_t begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos)
+    {
+        return {};
+    }
+
+    size_t end = line.find_last_not_of(" \t\r");
+    return line.substr(begin, end - begin + 1);
+}
+
+// the quoted path of an include directive, empty if the line isn't one
+std::string_view include_path(std::string_view line)
+{
+    static constexpr std::string_view directive = "#include";
+    line = trim(line);
+    if (!line.starts_with(directive))
+    {
+        return {};
+    }
+
+    line = trim(line.substr(directive.size()));
+    if (line.size() < 2 || line.front() != '"' || line.back() != '"')
+    {
+        return {};
+    }
+
+    return line.substr(1, line.size() - 2);
+}
+} // namespace
+
+std::string
+shader_preprocessor::process(std::string_view path,
+                             const std::vector<std::string>& defines,
+                             std::set<std::filesystem::path>* included,
+                             std::vector<std::filesystem::path>* files)
+{
+    shader_preprocessor preprocessor;
+    std::string expanded;
+    preprocessor.expand(std::filesystem::path(path), expanded);
+    if (included)
+    {
+        included->insert(preprocessor._included.begin(),
+                         preprocessor._included.end());
+    }
+
+    if (files)
+    {
+        *files = preprocessor._files;
+    }
+
+    if (defines.empty())
+    {
+        return expanded;
+    }
+
+    std::string define_block;
+    for (const auto& define : defines)
+    {
+        define_block += "#define " + define + "\n";
+    }
+
+    // the version directive must stay the first statement of the source
+    size_t insert_position = 0;
+    if (size_t version = expanded.find("#version");
+        version != std::string::npos)
+    {
+        size_t line_end = expanded.find('\n', version);
+        insert_position =
+            line_end == std::string::npos ? expanded.size() : line_end + 1;
+        define_block += "#line 2 0\n";
+    }
+
+    expanded.insert(insert_position, define_block);
+    return expanded;
+}
+
+void shader_preprocessor::expand(const std::filesystem::path& path,
+                                 std::string& output)
+{
+    std::filesystem::path normalized = path.lexically_normal();
+    if (!_included.insert(normalized).second)
+    {
+        return;
+    }
+
+    if (!file::exists(normalized.string()))
+    {
+        log()->error("Shader source {} doesn't exist", normalized.string());
+        return;
+    }
+
+    const size_t file_index = _files.size();
+    _files.push_back(normalized);
+
+    // the lines are copied into the output straight from the mapped file
+    file_view source { normalized.string() };
+    std::string_view remaining = source.text();
+    size_t line_number = 0;
+    while (!remaining.empty())
+    {
+        size_t line_end = remaining.find('\n');
+        std::string_view line = remaining.substr(0, line_end);
+        remaining.remove_prefix(
+            line_end == std::string_view::npos ? remaining.size()
+                                               : line_end + 1);
+        ++line_number;
+        std::string_view included = include_path(line);
+        if (included.empty())
+        {
+            output += line;
+            output += '\n';
+            continue;
+        }
+
+        // the index the file gets, no lines follow if it's skipped
+        output += "#line 1 " + std::to_string(_files.size()) + "\n";
+        expand(normalized.parent_path() / included, output);
+        // keep the compiler messages pointing at the lines of this file
+        output += "#line " + std::to_string(line_number + 1) + " " +
+                  std::to_string(file_index) + "\n";
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+/**
+ * @brief Prepares the shader sources for the compilation
+ *
+ * Resolves the `#include "path"` directives, with the paths relative to the
+ * including file. Every file is included at most once per source, so the
+ * shared pieces don't need include guards. The included text is surrounded
+ * by `#line` directives numbering the files in the order of their inclusion,
+ * so the compiler messages refer to the line and the index of the file they
+ * belong to, with 0 standing for the source itself. The given defines are
+ * inserted right after the `#version` directive, which is how the feature
+ * variants of a shader are specialized.
+ */
+class shader_preprocessor
+{
+public:
+    /**
+     * @brief Load and preprocess the shader source
+     *
+     * @param path the path of the shader source
+     * @param defines the macros to define
+     * @param included receives the source itself and the files it includes,
+     * if given
+     * @param files receives the files by the indices used in the `#line`
+     * directives, if given
+     * @return std::string the source ready for the compilation
+     */
+    static std::string
+    process(std::string_view path,
+            const std::vector<std::string>& defines = {},
+            std::set<std::filesystem::path>* included = nullptr,
+            std::vector<std::filesystem::path>* files = nullptr);
+
+private:
+    shader_preprocessor() = default;
+
+    void expand(const std::filesystem::path& path, std::string& output);
+
+private:
+    std::set<std::filesystem::path> _included;
+    // the files by their indices in the line directives
+    std::vector<std::filesystem::path> _files;
+};
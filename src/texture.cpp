@@ -1,15 +1,17 @@
-// TODO: investigate PBO and integrate
-// https://www.songho.ca/opengl/gl_pbo.html
-
 #include "texture.hpp"
 
 #include "image.hpp"
+#include "image_resampling.hpp"
 #include "logging.hpp"
 #include "utils.hpp"
 
 namespace
 {
 logger log() { return get_logger("texture"); }
+
+// not exposed by the loader, the values are from EXT_texture_compression_s3tc
+constexpr int COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+constexpr int COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
 } // namespace
 
 template <>
@@ -59,6 +61,7 @@ texture::texture(texture&& other)
     _width = other._width;
     _height = other._height;
     _format = other._format;
+    _ready = other._ready;
     other._texture_id = 0;
     _textures.push_back(this);
     log()->info("New texture created {}. Total number of textures {}",
@@ -68,10 +71,18 @@ texture::texture(texture&& other)
 
 texture& texture::operator=(texture&& other)
 {
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    // the texture is replaced, e.g. by the reloaded one
+    glDeleteTextures(1, &_texture_id);
     _texture_id = other._texture_id;
     _width = other._width;
     _height = other._height;
     _format = other._format;
+    _ready = other._ready;
     other._texture_id = 0;
     return *this;
 }
@@ -88,6 +99,12 @@ texture::~texture()
 
 void texture::init(size_t width, size_t height, format texture_format)
 {
+    if (is_compressed(texture_format))
+    {
+        log()->error("Compressed textures need their data to be initialized");
+        return;
+    }
+
     _width = width;
     _height = height;
     if (_width == 0 || _height == 0)
@@ -130,6 +147,78 @@ void texture::init(size_t width, size_t height, format texture_format)
     return;
 }
 
+void texture::init_compressed(size_t width,
+                              size_t height,
+                              format texture_format,
+                              std::span<const std::span<const char>> levels)
+{
+    if (!is_compressed(texture_format) || levels.empty())
+    {
+        log()->error("Invalid compressed texture data");
+        return;
+    }
+
+    _width = width;
+    _height = height;
+    _format = texture_format;
+    _samples = 1;
+    glBindTexture(GL_TEXTURE_2D, _texture_id);
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        glCompressedTexImage2D(GL_TEXTURE_2D,
+                               i,
+                               convert_to_gl_internal_format(texture_format),
+                               std::max<size_t>(width >> i, 1),
+                               std::max<size_t>(height >> i, 1),
+                               0,
+                               levels[ i ].size(),
+                               levels[ i ].data());
+    }
+
+    auto error = glGetError();
+    if (error != GL_NO_ERROR)
+    {
+        log()->error("Error ocurred {}", error);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels.size() - 1);
+    glTexParameteri(
+        GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+}
+
+void texture::init_levels(size_t width,
+                          size_t height,
+                          format texture_format,
+                          size_t level_count)
+{
+    _width = width;
+    _height = height;
+    _format = texture_format;
+    _samples = 1;
+    if (_width == 0 || _height == 0 || level_count == 0)
+    {
+        return;
+    }
+
+    // the names of glGenTextures get their object on the first bind only,
+    // the direct state access calls need the object
+    glBindTexture(GL_TEXTURE_2D, _texture_id);
+    glTextureStorage2D(_texture_id,
+                       level_count,
+                       convert_to_gl_sized_format(texture_format),
+                       _width,
+                       _height);
+    glTextureParameteri(_texture_id, GL_TEXTURE_MAX_LEVEL, level_count - 1);
+    glTextureParameteri(_texture_id,
+                        GL_TEXTURE_MIN_FILTER,
+                        level_count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTextureParameteri(_texture_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(_texture_id, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(_texture_id, GL_TEXTURE_WRAP_T, GL_REPEAT);
+}
+
 void texture::set_samples(int sample_count)
 {
     _samples = sample_count;
@@ -147,9 +236,13 @@ size_t texture::get_channel_count() const
     switch (_format)
     {
     case format::GRAYSCALE:
-    case format::DEPTH: return 1;
-    case format::RGB: return 3;
-    case format::RGBA: return 4;
+    case format::DEPTH:
+    case format::BC4: return 1;
+    case format::BC5: return 2;
+    case format::RGB:
+    case format::BC1: return 3;
+    case format::RGBA:
+    case format::BC3: return 4;
     default: return 0;
     }
 }
@@ -166,6 +259,60 @@ void texture::set_data(const char* data_ptr)
     set_rect_data({ 0, 0 }, { _width, _height }, data_ptr);
 }
 
+void texture::set_level_data(size_t level,
+                             size_t width,
+                             size_t height,
+                             const char* data_ptr)
+{
+    glBindTexture(GL_TEXTURE_2D, _texture_id);
+    glTexImage2D(GL_TEXTURE_2D,
+                 level,
+                 convert_to_gl_internal_format(_format),
+                 width,
+                 height,
+                 0,
+                 convert_to_gl_format(_format),
+                 GL_UNSIGNED_BYTE,
+                 data_ptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level);
+}
+
+void texture::set_level_sub_data(size_t level,
+                                 size_t width,
+                                 size_t height,
+                                 const char* data_ptr,
+                                 size_t size)
+{
+    if (is_compressed(_format))
+    {
+        glCompressedTextureSubImage2D(_texture_id,
+                                      level,
+                                      0,
+                                      0,
+                                      width,
+                                      height,
+                                      convert_to_gl_internal_format(_format),
+                                      size,
+                                      data_ptr);
+    }
+    else
+    {
+        glTextureSubImage2D(_texture_id,
+                            level,
+                            0,
+                            0,
+                            width,
+                            height,
+                            convert_to_gl_format(_format),
+                            GL_UNSIGNED_BYTE,
+                            data_ptr);
+    }
+}
+
+bool texture::is_ready() const { return _ready; }
+
+void texture::set_ready(bool ready) { _ready = ready; }
+
 void texture::set_rect_data(glm::vec<2, size_t> pos,
                             glm::vec<2, size_t> size,
                             const char* data_ptr)
@@ -189,7 +336,7 @@ void texture::unbind() const { static_unbind(_samples > 1); }
 void texture::set_active_texture(size_t index) const
 {
     glActiveTexture(GL_TEXTURE0 + index);
-    glBindTexture(GL_TEXTURE_2D, _texture_id);
+    glBindTexture(GL_TEXTURE_2D, _ready ? _texture_id : 0);
 }
 
 void texture::set_wrapping_mode(bool x, bool y, wrapping_mode mode)
@@ -315,33 +462,28 @@ unsigned texture::native_id() const { return _texture_id; }
 
 texture texture::from_image(image* img)
 {
-    auto md = img->get_metadata();
     texture result;
-    format tformat = format::UNSPECIFIED;
-    switch (md._color_type)
-    {
-    case image::color_type::GRAYSCALE:
-    {
-        tformat = format::GRAYSCALE;
-        break;
-    }
-    case image::color_type::RGB:
+    // normalized to RGBA on the CPU, instead of relying on the conversions
+    // of the driver. The grayscale images are rather data than colors
+    const bool srgb =
+        img->get_metadata()._color_type != image::color_type::GRAYSCALE;
+    auto levels = generate_mip_chain(*img, resampling_filter::kaiser, srgb);
+    if (levels.empty())
     {
-        tformat = format::RGB;
-        break;
-    }
-    case image::color_type::RGBA:
-    {
-        tformat = format::RGBA;
-        break;
+        return result;
     }
-    default:
+
+    result.init(levels.front()->get_width(),
+                levels.front()->get_height(),
+                format::RGBA);
+    for (size_t i = 0; i < levels.size(); ++i)
     {
-        break;
-    }
+        result.set_level_data(i,
+                              levels[ i ]->get_width(),
+                              levels[ i ]->get_height(),
+                              levels[ i ]->get_data());
     }
-    result.init(img->get_width(), img->get_height(), tformat);
-    result.set_data(img->get_data());
+    result.set_sampling_mode_min(sampling_mode::linear_linear);
     return result;
 }
 
@@ -363,6 +505,10 @@ int texture::convert_to_gl_internal_format(format f)
     case format::GRAYSCALE: return GL_RED;
     case format::RGB: return GL_RGB;
     case format::RGBA: return GL_RGBA;
+    case format::BC1: return COMPRESSED_RGB_S3TC_DXT1;
+    case format::BC3: return COMPRESSED_RGBA_S3TC_DXT5;
+    case format::BC4: return GL_COMPRESSED_RED_RGTC1;
+    case format::BC5: return GL_COMPRESSED_RG_RGTC2;
     default: return GL_NONE;
     }
 }
@@ -379,6 +525,30 @@ int texture::convert_to_gl_format(format f)
     }
 }
 
+int texture::convert_to_gl_sized_format(format f)
+{
+    switch (f)
+    {
+    case format::DEPTH: return GL_DEPTH_COMPONENT24;
+    case format::GRAYSCALE: return GL_R8;
+    case format::RGB: return GL_RGB8;
+    case format::RGBA: return GL_RGBA8;
+    default: return convert_to_gl_internal_format(f);
+    }
+}
+
+bool texture::is_compressed(format f)
+{
+    switch (f)
+    {
+    case format::BC1:
+    case format::BC3:
+    case format::BC4:
+    case format::BC5: return true;
+    default: return false;
+    }
+}
+
 unsigned texture::target() const
 {
     return _samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
@@ -12,6 +12,11 @@ public:
         DEPTH,
         RGB,
         RGBA,
+        // block compressed, only created with @ref init_compressed
+        BC1,
+        BC3,
+        BC4,
+        BC5,
     };
 
     enum class sampling_mode
@@ -42,6 +47,30 @@ public:
 
     void init(size_t width, size_t height, format texture_format = format::RGB);
 
+    /**
+     * @brief Initialize with the prebuilt, block compressed mip chain
+     *
+     * @param width the width of the base level
+     * @param height the height of the base level
+     * @param texture_format one of the block compressed formats
+     * @param levels the compressed data of the levels starting from the base
+     */
+    void init_compressed(size_t width,
+                         size_t height,
+                         format texture_format,
+                         std::span<const std::span<const char>> levels);
+
+    /**
+     * @brief Allocate the immutable storage of the mip chain without data
+     *
+     * The data of the levels is set later, e.g. streamed by @ref
+     * texture_uploader.
+     */
+    void init_levels(size_t width,
+                     size_t height,
+                     format texture_format,
+                     size_t level_count);
+
     void set_samples(int sample_count);
 
     glm::uvec2 get_size() const;
@@ -50,6 +79,41 @@ public:
     size_t get_channel_count() const;
     void get_data(char* data_ptr);
     void set_data(const char* data_ptr);
+
+    /**
+     * @brief Set the data of a mip level, in the format of the texture
+     *
+     * The levels must be set in order, the texture samples up to the last
+     * level set.
+     */
+    void set_level_data(size_t level,
+                        size_t width,
+                        size_t height,
+                        const char* data_ptr);
+
+    /**
+     * @brief Overwrite the whole mip level of the allocated storage
+     *
+     * With a pixel unpack buffer bound, the data pointer is the offset into
+     * the buffer.
+     *
+     * @param size the size of the data, used by the compressed formats
+     */
+    void set_level_sub_data(size_t level,
+                            size_t width,
+                            size_t height,
+                            const char* data_ptr,
+                            size_t size);
+
+    /**
+     * @brief Check whether the data of the texture has arrived
+     *
+     * A texture still being streamed is bound as no texture, so it's
+     * sampled as black meanwhile.
+     */
+    bool is_ready() const;
+    void set_ready(bool ready);
+
     void set_rect_data(glm::vec<2, size_t> pos,
                        glm::vec<2, size_t> size,
                        const char* data_ptr);
@@ -68,6 +132,9 @@ public:
 
     unsigned native_id() const;
 
+    /**
+     * @brief Create the texture of the image with its full mip chain
+     */
     static texture from_image(image* img);
 
     static void static_bind(size_t id, bool ms);
@@ -76,6 +143,8 @@ public:
 private:
     static int convert_to_gl_internal_format(format f);
     static int convert_to_gl_format(format f);
+    static int convert_to_gl_sized_format(format f);
+    static bool is_compressed(format f);
     unsigned target() const;
 
 private:
@@ -84,6 +153,7 @@ private:
     unsigned _texture_id { 0 };
     format _format { format::UNSPECIFIED };
     int _samples { 1 };
+    bool _ready { true };
 
 public:
     // TODO: may not be the best place for this object
@@ -0,0 +1,290 @@
+#include <fstream>
+
+#include "texture_cache.hpp"
+
+#include "file_view.hpp"
+#include "filesystem.hpp"
+#include "image.hpp"
+#include "image_resampling.hpp"
+#include "logging.hpp"
+#include "texture.hpp"
+#include "utils.hpp"
+
+namespace
+{
+static inline logger log() { return get_logger("texture_cache"); }
+
+constexpr std::array<char, 4> MAGIC { 'G', 'T', 'E', 'X' };
+constexpr uint32_t VERSION = 1;
+
+struct file_header
+{
+    std::array<char, 4> magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t level_count;
+    uint64_t source_size;
+    int64_t source_time;
+};
+
+struct source_stamp
+{
+    uint64_t size { 0 };
+    int64_t time { 0 };
+};
+
+std::optional<source_stamp> stamp_of(std::string_view source_path)
+{
+    std::error_code error;
+    std::filesystem::path path { source_path };
+    auto size = std::filesystem::file_size(path, error);
+    if (error)
+    {
+        return std::nullopt;
+    }
+
+    auto time = std::filesystem::last_write_time(path, error);
+    if (error)
+    {
+        return std::nullopt;
+    }
+
+    return source_stamp { size, time.time_since_epoch().count() };
+}
+
+texture::format to_texture_format(block_format format)
+{
+    switch (format)
+    {
+    case block_format::bc1: return texture::format::BC1;
+    case block_format::bc3: return texture::format::BC3;
+    case block_format::bc4: return texture::format::BC4;
+    case block_format::bc5: return texture::format::BC5;
+    }
+    return texture::format::UNSPECIFIED;
+}
+} // namespace
+
+std::optional<texture_cache::entry>
+texture_cache::load(std::string_view source_path)
+{
+    auto stamp = stamp_of(source_path);
+    if (!stamp)
+    {
+        return std::nullopt;
+    }
+
+    std::filesystem::path path = entry_path(source_path);
+    if (!std::filesystem::exists(path))
+    {
+        return std::nullopt;
+    }
+
+    // the file stays mapped, the levels are copied out of it by the upload
+    auto view = std::make_shared<file_view>(path.string());
+    std::span<const std::byte> blob = view->data();
+    if (blob.size() < sizeof(file_header))
+    {
+        return std::nullopt;
+    }
+
+    file_header header;
+    std::memcpy(&header, blob.data(), sizeof(header));
+    if (header.magic != MAGIC || header.version != VERSION)
+    {
+        log()->warn("Ignoring incompatible cooked texture of {}", source_path);
+        return std::nullopt;
+    }
+
+    if (header.source_size != stamp->size || header.source_time != stamp->time)
+    {
+        log()->debug("Cooked texture of {} is out of date", source_path);
+        return std::nullopt;
+    }
+
+    const size_t table_size = header.level_count * sizeof(level);
+    if (header.format > static_cast<uint32_t>(block_format::bc5) ||
+        header.level_count == 0 || blob.size() < sizeof(header) + table_size)
+    {
+        log()->warn("Ignoring corrupted cooked texture of {}", source_path);
+        return std::nullopt;
+    }
+
+    entry result;
+    result.format = static_cast<block_format>(header.format);
+    result.levels.resize(header.level_count);
+    std::memcpy(
+        result.levels.data(), blob.data() + sizeof(header), table_size);
+    result.mapping_offset = sizeof(header) + table_size;
+    const size_t payload_size = blob.size() - result.mapping_offset;
+    for (const auto& l : result.levels)
+    {
+        // checked apart, so the sum of the corrupted values can't overflow
+        if (l.width == 0 || l.height == 0 || l.offset > payload_size ||
+            l.size > payload_size - l.offset)
+        {
+            log()->warn("Ignoring corrupted cooked texture of {}", source_path);
+            return std::nullopt;
+        }
+    }
+
+    result.mapping = std::move(view);
+    return result;
+}
+
+void texture_cache::store(std::string_view source_path, const entry& data)
+{
+    auto stamp = stamp_of(source_path);
+    if (!stamp)
+    {
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(filesystem::texture_cache_path(),
+                                        error);
+    if (error)
+    {
+        log()->warn("Failed to create the texture cache directory: {}",
+                    error.message());
+        return;
+    }
+
+    file_header header { MAGIC,
+                         VERSION,
+                         static_cast<uint32_t>(data.format),
+                         static_cast<uint32_t>(data.levels.size()),
+                         stamp->size,
+                         stamp->time };
+
+    // written next to the entry and moved over it, so a concurrent reader
+    // never sees a partially written file
+    auto path = entry_path(source_path);
+    auto temporary_path = path;
+    temporary_path += ".tmp";
+    {
+        std::ofstream stream(temporary_path, std::ios::binary);
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        stream.write(reinterpret_cast<const char*>(data.levels.data()),
+                     data.levels.size() * sizeof(level));
+        std::span<const char> payload = data.payload();
+        stream.write(payload.data(), payload.size());
+        if (!stream)
+        {
+            log()->warn("Failed to write the cooked texture of {}",
+                        source_path);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporary_path, path, error);
+    if (error)
+    {
+        log()->warn("Failed to store the cooked texture of {}: {}",
+                    source_path,
+                    error.message());
+    }
+}
+
+std::optional<texture_cache::entry> texture_cache::cook(const image& img)
+{
+    if (img.get_width() == 0 || img.get_height() == 0)
+    {
+        return std::nullopt;
+    }
+
+    // the grayscale images are rather data than colors
+    const auto color_type = img.get_metadata()._color_type;
+    const bool srgb = color_type != image::color_type::GRAYSCALE;
+    auto levels = generate_mip_chain(img, resampling_filter::kaiser, srgb);
+    if (levels.empty())
+    {
+        return std::nullopt;
+    }
+
+    entry result;
+    switch (color_type)
+    {
+    case image::color_type::GRAYSCALE: result.format = block_format::bc4; break;
+    case image::color_type::GRAYSCALE_ALPHA:
+    case image::color_type::RGBA: result.format = block_format::bc3; break;
+    default: result.format = block_format::bc1; break;
+    }
+
+    for (const auto& level : levels)
+    {
+        std::vector<uint8_t> blocks =
+            compress_blocks(level->get_data<unsigned char>(),
+                            level->get_width(),
+                            level->get_height(),
+                            result.format);
+        result.levels.push_back({ static_cast<uint32_t>(level->get_width()),
+                                  static_cast<uint32_t>(level->get_height()),
+                                  result.data.size(),
+                                  blocks.size() });
+        result.data.insert(result.data.end(), blocks.begin(), blocks.end());
+    }
+
+    return result;
+}
+
+void texture_cache::upload(const entry& data, texture& target)
+{
+    std::span<const char> payload = data.payload();
+    std::vector<std::span<const char>> levels;
+    levels.reserve(data.levels.size());
+    for (const auto& l : data.levels)
+    {
+        levels.push_back(payload.subspan(l.offset, l.size));
+    }
+
+    target.init_compressed(data.levels.front().width,
+                           data.levels.front().height,
+                           to_texture_format(data.format),
+                           levels);
+}
+
+texture_uploader::staging
+texture_cache::stage(const entry& data, texture_uploader& uploader)
+{
+    std::span<const char> payload = data.payload();
+    std::vector<texture_uploader::level_data> levels;
+    levels.reserve(data.levels.size());
+    for (const auto& l : data.levels)
+    {
+        levels.push_back(
+            { l.width, l.height, payload.subspan(l.offset, l.size) });
+    }
+    return uploader.stage(levels);
+}
+
+void texture_cache::submit(const entry& data,
+                           texture_uploader::staging staged,
+                           texture& target,
+                           texture_uploader& uploader)
+{
+    target.init_levels(data.levels.front().width,
+                       data.levels.front().height,
+                       to_texture_format(data.format),
+                       data.levels.size());
+    uploader.submit(&target, std::move(staged));
+}
+
+std::span<const char> texture_cache::entry::payload() const
+{
+    if (!mapping)
+    {
+        return data;
+    }
+
+    auto bytes = mapping->data().subspan(mapping_offset);
+    return { reinterpret_cast<const char*>(bytes.data()), bytes.size() };
+}
+
+std::filesystem::path texture_cache::entry_path(std::string_view source_path)
+{
+    stable_hash h;
+    h.add(source_path);
+    return std::filesystem::path(filesystem::texture_cache_path()) /
+           std::format("{:016x}.gtex", h._value);
+}
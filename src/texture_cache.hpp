@@ -0,0 +1,108 @@
+#pragma once
+
+#include <optional>
+
+#include "renderer/algorithms/block_compression.hpp"
+#include "texture_uploader.hpp"
+
+class file_view;
+class image;
+class texture;
+
+/**
+ * @brief Cache of the cooked, GPU ready textures
+ *
+ * A cooked texture keeps the full mip chain block compressed, so creating
+ * the texture is a plain copy of the levels to the driver. An entry is up to
+ * date while the size and the modification time of its source image match
+ * the recorded ones.
+ *
+ * File layout (native endianness):
+ * - header: magic, version, format, size, level count and the source stamp
+ * - the level table: size, offset and length of the data of each level
+ * - the data of the levels
+ */
+class texture_cache
+{
+public:
+    struct level
+    {
+        uint32_t width;
+        uint32_t height;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct entry
+    {
+        block_format format;
+        std::vector<level> levels;
+        // the data of all the levels of a freshly cooked image, referenced by
+        // their offsets
+        std::vector<char> data;
+        // the mapped cache file holding the data of the levels instead, when
+        // the entry is loaded
+        std::shared_ptr<const file_view> mapping;
+        size_t mapping_offset { 0 };
+
+        /**
+         * @brief Get the data the offsets of the levels refer to
+         */
+        std::span<const char> payload() const;
+    };
+
+public:
+    /**
+     * @brief Load the cooked form of the image
+     *
+     * The cache file stays mapped while the entry references it, the levels
+     * are copied out of the mapping by the upload only.
+     *
+     * @param source_path the path of the source image
+     * @return std::optional<entry> the entry, empty if there is none or the
+     * source was modified since it was cooked
+     */
+    static std::optional<entry> load(std::string_view source_path);
+    static void store(std::string_view source_path, const entry& data);
+
+    /**
+     * @brief Build the mip chain of the image and compress it
+     *
+     * Grayscale images are compressed to bc4, the opaque ones to bc1 and the
+     * ones with alpha to bc3.
+     *
+     * @return std::optional<entry> the cooked image, empty if the pixel
+     * format of the image isn't supported
+     */
+    static std::optional<entry> cook(const image& img);
+
+    /**
+     * @brief Create the texture of the cooked image
+     *
+     * Must be called on the thread owning the GL context.
+     */
+    static void upload(const entry& data, texture& target);
+
+    /**
+     * @brief Copy the levels of the cooked image into the staging ring
+     *
+     * May be called on any thread, the data of the entry isn't needed after,
+     * so the mapping can be released.
+     */
+    static texture_uploader::staging stage(const entry& data,
+                                           texture_uploader& uploader);
+
+    /**
+     * @brief Create the texture of the staged image and stream the levels
+     *
+     * Must be called on the thread owning the GL context. The texture is
+     * flagged ready once the levels arrive.
+     */
+    static void submit(const entry& data,
+                       texture_uploader::staging staged,
+                       texture& target,
+                       texture_uploader& uploader);
+
+private:
+    static std::filesystem::path entry_path(std::string_view source_path);
+};
@@ -0,0 +1,318 @@
+#include "texture_uploader.hpp"
+
+#include "logging.hpp"
+#include "texture.hpp"
+
+namespace
+{
+static logger log() { return get_logger("texture_uploader"); }
+
+// keeps the staged levels aligned for any of the pixel formats
+constexpr size_t LEVEL_ALIGNMENT = 16;
+
+size_t align_up(size_t value)
+{
+    return (value + LEVEL_ALIGNMENT - 1) & ~(LEVEL_ALIGNMENT - 1);
+}
+} // namespace
+
+texture_uploader::texture_uploader(size_t capacity, size_t bytes_per_process)
+    : _capacity(capacity)
+    , _bytes_per_process(bytes_per_process)
+{
+    constexpr GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &_buffer);
+    glNamedBufferStorage(_buffer, _capacity, nullptr, flags);
+    _mapped = static_cast<char*>(
+        glMapNamedBufferRange(_buffer, 0, _capacity, flags));
+    if (!_mapped)
+    {
+        log()->error("Failed to map the staging ring, uploading directly");
+        _capacity = 0;
+    }
+}
+
+texture_uploader::~texture_uploader()
+{
+    for (auto& region : _regions)
+    {
+        if (region->fence)
+        {
+            glDeleteSync(region->fence);
+        }
+    }
+
+    if (_mapped)
+    {
+        glUnmapNamedBuffer(_buffer);
+    }
+    glDeleteBuffers(1, &_buffer);
+}
+
+texture_uploader::staging
+texture_uploader::stage(std::span<const level_data> levels)
+{
+    staging result;
+    size_t total_size = 0;
+    for (const auto& l : levels)
+    {
+        result.levels.push_back(
+            { l.width, l.height, total_size, l.data.size() });
+        total_size += align_up(l.data.size());
+    }
+
+    char* target = nullptr;
+    {
+        std::unique_lock lock { _mutex };
+        result.region = allocate(total_size);
+    }
+
+    if (result.region)
+    {
+        target = _mapped + result.region->begin;
+    }
+    else
+    {
+        result.pending_data.resize(total_size);
+        target = result.pending_data.data();
+    }
+
+    // the copying itself is out of the lock, the range is owned already
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        std::memcpy(target + result.levels[ i ].offset,
+                    levels[ i ].data.data(),
+                    levels[ i ].data.size());
+    }
+    return result;
+}
+
+void texture_uploader::submit(texture* target, staging data)
+{
+    target->set_ready(false);
+    std::unique_lock lock { _mutex };
+    _submitted.push_back({ target, std::move(data) });
+}
+
+void texture_uploader::process()
+{
+    retire_regions();
+
+    std::vector<upload> issued;
+    size_t issued_bytes = 0;
+    while (issued_bytes < _bytes_per_process)
+    {
+        upload job;
+        {
+            std::unique_lock lock { _mutex };
+            if (_submitted.empty())
+            {
+                break;
+            }
+
+            auto& front = _submitted.front();
+            const size_t size = front.data.pending_data.size();
+            // the empty data needs no range, it's completed directly
+            if (!front.data.region && size > 0 && size <= _capacity)
+            {
+                front.data.region = allocate(size);
+                if (!front.data.region)
+                {
+                    // the order is kept, retried once the ring drains
+                    break;
+                }
+                std::memcpy(_mapped + front.data.region->begin,
+                            front.data.pending_data.data(),
+                            size);
+                front.data.pending_data = {};
+            }
+
+            job = std::move(front);
+            _submitted.pop_front();
+        }
+
+        for (const auto& l : job.data.levels)
+        {
+            issued_bytes += l.size;
+        }
+
+        if (job.data.region)
+        {
+            issue(job);
+            _in_flight.push_back(std::move(job));
+        }
+        else
+        {
+            upload_directly(job);
+        }
+    }
+}
+
+void texture_uploader::finish()
+{
+    process();
+    while (!idle())
+    {
+        // the oldest copy frees the ranges the queued ones wait for
+        GLsync fence = nullptr;
+        {
+            std::unique_lock lock { _mutex };
+            if (!_regions.empty())
+            {
+                fence = _regions.front()->fence;
+            }
+        }
+
+        if (fence)
+        {
+            glClientWaitSync(
+                fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+        process();
+    }
+}
+
+bool texture_uploader::idle() const
+{
+    std::unique_lock lock { _mutex };
+    return _submitted.empty() && _in_flight.empty();
+}
+
+std::shared_ptr<texture_uploader::ring_region>
+texture_uploader::allocate(size_t size)
+{
+    size = align_up(size);
+    if (size == 0 || size > _capacity)
+    {
+        return nullptr;
+    }
+
+    size_t begin = 0;
+    if (_regions.empty())
+    {
+        // nothing in use, start over from the beginning
+        begin = 0;
+    }
+    else
+    {
+        const size_t tail = _regions.front()->begin;
+        if (_head == tail)
+        {
+            // the ring is full
+            return nullptr;
+        }
+
+        if (_head > tail)
+        {
+            if (_capacity - _head >= size)
+            {
+                begin = _head;
+            }
+            else if (tail >= size)
+            {
+                // wrap around, the end of the ring stays unused this round
+                begin = 0;
+            }
+            else
+            {
+                return nullptr;
+            }
+        }
+        else if (tail - _head >= size)
+        {
+            begin = _head;
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+    auto region =
+        std::make_shared<ring_region>(ring_region { begin, begin + size });
+    _head = region->end == _capacity ? 0 : region->end;
+    _regions.push_back(region);
+    return region;
+}
+
+void texture_uploader::retire_regions()
+{
+    {
+        std::unique_lock lock { _mutex };
+        // retired in the allocation order, a region staged but not issued
+        // yet holds the ones behind it
+        while (!_regions.empty() && _regions.front()->fence)
+        {
+            auto& region = _regions.front();
+            GLenum status = glClientWaitSync(region->fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED &&
+                status != GL_CONDITION_SATISFIED)
+            {
+                break;
+            }
+
+            glDeleteSync(region->fence);
+            region->fence = nullptr;
+            region->done = true;
+            _regions.pop_front();
+        }
+    }
+
+    std::erase_if(_in_flight,
+                  [](upload& job)
+    {
+        if (!job.data.region->done)
+        {
+            return false;
+        }
+
+        job.target->set_ready(true);
+        return true;
+    });
+}
+
+void texture_uploader::issue(upload& job)
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t i = 0; i < job.data.levels.size(); ++i)
+    {
+        const auto& l = job.data.levels[ i ];
+        // with the unpack buffer bound the pointer is the offset into it
+        job.target->set_level_sub_data(
+            i,
+            l.width,
+            l.height,
+            reinterpret_cast<const char*>(job.data.region->begin + l.offset),
+            l.size);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    job.data.region->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void texture_uploader::upload_directly(upload& job)
+{
+    if (!job.data.pending_data.empty())
+    {
+        log()->debug("Uploading {} bytes directly, more than the staging ring",
+                     job.data.pending_data.size());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t i = 0; i < job.data.levels.size(); ++i)
+    {
+        const auto& l = job.data.levels[ i ];
+        job.target->set_level_sub_data(i,
+                                       l.width,
+                                       l.height,
+                                       job.data.pending_data.data() + l.offset,
+                                       l.size);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    job.target->set_ready(true);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+
+class texture;
+
+/**
+ * @brief Streams the texture data through a persistently mapped pixel buffer
+ *
+ * The data is staged into a ring buffer, which may happen on any thread, so
+ * the loader threads do the copying. The copies from the ring into the
+ * textures are issued on the thread owning the GL context, a limited amount
+ * per @ref process call. They execute asynchronously, a fence marks the
+ * completion, after which the ring range is reused and the texture is
+ * flagged ready. The data larger than the whole ring is uploaded directly.
+ */
+class texture_uploader
+{
+private:
+    struct ring_region;
+
+public:
+    struct level_data
+    {
+        size_t width;
+        size_t height;
+        std::span<const char> data;
+    };
+
+    struct staging
+    {
+        struct level
+        {
+            size_t width;
+            size_t height;
+            size_t offset;
+            size_t size;
+        };
+
+        std::vector<level> levels;
+        // the data not fitting the ring at the staging time, moved into the
+        // ring once there is space
+        std::vector<char> pending_data;
+        std::shared_ptr<ring_region> region;
+    };
+
+public:
+    /**
+     * @brief Create the ring buffer, on the thread owning the GL context
+     *
+     * @param capacity the size of the ring in bytes
+     * @param bytes_per_process the amount of the data copied into the
+     * textures per @ref process call, bounding the time spent per frame
+     */
+    texture_uploader(size_t capacity = 64 << 20,
+                     size_t bytes_per_process = 16 << 20);
+    ~texture_uploader();
+
+    /**
+     * @brief Copy the levels of a texture into the ring
+     *
+     * May be called on any thread.
+     */
+    staging stage(std::span<const level_data> levels);
+
+    /**
+     * @brief Queue the copy of the staged data into the texture
+     *
+     * The texture must have the storage of the levels allocated. It's
+     * flagged not ready until the copy completes. May be called on any
+     * thread.
+     */
+    void submit(texture* target, staging data);
+
+    /**
+     * @brief Issue the queued copies and complete the finished ones
+     *
+     * Must be called on the thread owning the GL context, e.g. once per
+     * frame.
+     */
+    void process();
+
+    /**
+     * @brief Issue all the queued copies and wait for their completion
+     *
+     * Must be called on the thread owning the GL context.
+     */
+    void finish();
+
+    /**
+     * @brief Check whether there are copies queued or in flight
+     */
+    bool idle() const;
+
+private:
+    struct ring_region
+    {
+        size_t begin;
+        size_t end;
+        GLsync fence { nullptr };
+        bool done { false };
+    };
+
+    struct upload
+    {
+        texture* target;
+        staging data;
+    };
+
+    std::shared_ptr<ring_region> allocate(size_t size);
+    void retire_regions();
+    void issue(upload& job);
+    void upload_directly(upload& job);
+
+private:
+    mutable std::mutex _mutex;
+    unsigned _buffer { 0 };
+    char* _mapped { nullptr };
+    size_t _capacity { 0 };
+    size_t _bytes_per_process { 0 };
+    size_t _head { 0 };
+    // the allocated ranges of the ring in the allocation order
+    std::deque<std::shared_ptr<ring_region>> _regions;
+    std::deque<upload> _submitted;
+    std::vector<upload> _in_flight;
+};
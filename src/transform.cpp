@@ -5,13 +5,26 @@ transform::transform()
     , _rotation(glm::identity<glm::quat>())
     , _scale({ 1, 1, 1 })
 {
+    touch();
 }
 
-void transform::set_position(glm::vec3 position) { _position = position; }
+void transform::set_position(glm::vec3 position)
+{
+    _position = position;
+    touch();
+}
 
-void transform::set_rotation(glm::quat rotation) { _rotation = rotation; }
+void transform::set_rotation(glm::quat rotation)
+{
+    _rotation = rotation;
+    touch();
+}
 
-void transform::set_scale(glm::vec3 scale) { _scale = scale; }
+void transform::set_scale(glm::vec3 scale)
+{
+    _scale = scale;
+    touch();
+}
 
 glm::vec3 transform::get_position() const { return _position; }
 
@@ -27,3 +40,9 @@ glm::mat4 transform::get_matrix() const
     matrix = glm::scale(matrix, _scale);
     return matrix;
 }
+
+uint64_t transform::get_version() const { return _version; }
+
+void transform::touch() { _version = ++_version_counter; }
+
+std::atomic_uint64_t transform::_version_counter { 0 };
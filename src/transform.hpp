@@ -15,8 +15,22 @@ public:
 
     glm::mat4 get_matrix() const;
 
+    /**
+     * @brief Get the stamp of the last modification
+     *
+     * Stamps are unique across all the transforms and grow with every
+     * modification, so a copied transform keeps the stamp of its source.
+     */
+    uint64_t get_version() const;
+
+private:
+    void touch();
+
 private:
     glm::vec3 _position;
     glm::quat _rotation;
     glm::vec3 _scale;
+    uint64_t _version { 0 };
+
+    static std::atomic_uint64_t _version_counter;
 };
@@ -16,6 +16,40 @@ struct string_hash
     }
 };
 
+/**
+ * @brief FNV-1a hash, unlike std::hash stable across the runs
+ *
+ * Used for keying the on-disk caches.
+ */
+struct stable_hash
+{
+    uint64_t _value = 0xcbf29ce484222325ull;
+
+    void add(const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            _value ^= bytes[ i ];
+            _value *= 0x100000001b3ull;
+        }
+    }
+
+    void add(std::string_view data)
+    {
+        add(data.data(), data.size());
+        // separate the consequent pieces, so "ab" + "c" != "a" + "bc"
+        add_value(data.size());
+    }
+
+    template <typename T>
+    void add_value(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        add(&value, sizeof(T));
+    }
+};
+
 // geometry utils
 
 template <typename T>
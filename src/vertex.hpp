@@ -84,6 +84,14 @@ struct vertex
         return std::get<attribute_count - I - 1>(_attributes).data;
     }
 
+    template <size_t I>
+    const std::tuple_element<attribute_count - I - 1,
+                             tuple_type>::type::attribute_data_storage_type&
+    get() const
+    {
+        return std::get<attribute_count - I - 1>(_attributes).data;
+    }
+
     static void activate_attributes()
     {
         for (int i = 0; i < attribute_count; ++i)
@@ -118,12 +126,28 @@ struct vertex3d
     {
         return get<0>();
     }
+    const position_3d_attribute::attribute_data_storage_type& position() const
+    {
+        return get<0>();
+    }
     normal_3d_attribute::attribute_data_storage_type& normal()
     {
         return get<1>();
     }
+    const normal_3d_attribute::attribute_data_storage_type& normal() const
+    {
+        return get<1>();
+    }
     uv_attribute::attribute_data_storage_type& uv() { return get<2>(); }
+    const uv_attribute::attribute_data_storage_type& uv() const
+    {
+        return get<2>();
+    }
     color_attribute::attribute_data_storage_type& color() { return get<3>(); }
+    const color_attribute::attribute_data_storage_type& color() const
+    {
+        return get<3>();
+    }
 };
 
 struct vertex2d : vertex<position_2d_attribute, uv_attribute>
@@ -0,0 +1,210 @@
+#include <prof/profiler.hpp>
+
+#include "view_visibility.hpp"
+
+#include "frame_packet.hpp"
+#include "material.hpp"
+#include "mesh.hpp"
+
+namespace
+{
+using frustum = std::array<glm::vec4, 6>;
+
+frustum extract_frustum(const glm::mat4& vp)
+{
+    // rows of the view projection matrix, glm matrices are column major
+    glm::mat4 m = glm::transpose(vp);
+    frustum planes { m[ 3 ] + m[ 0 ], m[ 3 ] - m[ 0 ], m[ 3 ] + m[ 1 ],
+                     m[ 3 ] - m[ 1 ], m[ 3 ] + m[ 2 ], m[ 3 ] - m[ 2 ] };
+    for (auto& plane : planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return planes;
+}
+
+bool intersects(const frustum& planes, glm::vec4 sphere)
+{
+    for (const auto& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w <
+            -sphere.w)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+view_visibility::view_visibility(const frame_packet& packet)
+    : _packet(packet)
+{
+    auto sp = prof::profile(__FUNCTION__);
+    cull();
+    _draw_lists.resize(packet.cameras.size());
+}
+
+view_visibility::view_mask view_visibility::get_mask(size_t renderable) const
+{
+    return _masks[ renderable ];
+}
+
+const view_visibility::draw_lists&
+view_visibility::get_draw_lists(size_t view) const
+{
+    std::unique_lock lock { _draw_lists_mutex };
+    if (!_draw_lists[ view ])
+    {
+        _draw_lists[ view ] = build_draw_lists(view);
+    }
+    return *_draw_lists[ view ];
+}
+
+void view_visibility::cull()
+{
+    const size_t view_count = std::min(_packet.cameras.size(), max_views);
+    std::vector<frustum> frusta;
+    frusta.reserve(view_count);
+    for (size_t view = 0; view < view_count; ++view)
+    {
+        frusta.push_back(extract_frustum(_packet.cameras[ view ].vp_matrix));
+    }
+
+    const view_mask all_views =
+        view_count == max_views ? ~view_mask { 0 }
+                                : (view_mask { 1 } << view_count) - 1;
+
+    _masks.resize(_packet.renderables.size());
+    for (size_t i = 0; i < _packet.renderables.size(); ++i)
+    {
+        glm::vec4 sphere = _packet.renderables[ i ].world_bounds;
+        if (sphere.w < 0.0f)
+        {
+            // unbounded, visible from everywhere
+            _masks[ i ] = all_views;
+            continue;
+        }
+
+        view_mask mask = 0;
+        for (size_t view = 0; view < view_count; ++view)
+        {
+            if (intersects(frusta[ view ], sphere))
+            {
+                mask |= view_mask { 1 } << view;
+            }
+        }
+        _masks[ i ] = mask;
+    }
+}
+
+bool view_visibility::is_visible(size_t renderable, size_t view) const
+{
+    // the views that don't fit into the mask aren't culled
+    return view >= max_views ||
+           (_masks[ renderable ] & (view_mask { 1 } << view)) != 0;
+}
+
+bool view_visibility::build_occlusion(size_t view) const
+{
+    const glm::mat4& vp = _packet.cameras[ view ].vp_matrix;
+    bool has_occluders = false;
+    for (size_t i = 0; i < _packet.renderables.size(); ++i)
+    {
+        const auto& renderable = _packet.renderables[ i ];
+        if (!renderable.occluder || !is_visible(i, view))
+        {
+            continue;
+        }
+
+        if (!has_occluders)
+        {
+            _occlusion.clear();
+            has_occluders = true;
+        }
+
+        _occlusion.rasterize(renderable.occluder->get_vertices(),
+                             renderable.occluder->get_indices(),
+                             vp * renderable.model_matrix);
+    }
+
+    if (has_occluders)
+    {
+        _occlusion.build_hierarchy();
+    }
+    return has_occluders;
+}
+
+view_visibility::draw_lists
+view_visibility::build_draw_lists(size_t view) const
+{
+    auto sp = prof::profile(__FUNCTION__);
+    // the instances of a material share its program, so the draws are
+    // grouped by the program
+    struct draw_key
+    {
+        const shader_program* program;
+        float depth;
+        uint32_t index;
+    };
+
+    const bool occlusion = build_occlusion(view);
+    const glm::mat4& vp = _packet.cameras[ view ].vp_matrix;
+    glm::vec3 eye = _packet.cameras[ view ].camera_transform.get_position();
+    std::vector<draw_key> keys;
+    std::vector<draw_key> transparent_keys;
+    keys.reserve(_packet.renderables.size());
+    for (uint32_t i = 0; i < _packet.renderables.size(); ++i)
+    {
+        if (!is_visible(i, view))
+        {
+            continue;
+        }
+
+        const auto& renderable = _packet.renderables[ i ];
+        // the occluders are drawn anyway, testing them against themselves
+        // would hide them
+        if (occlusion && !renderable.occluder &&
+            renderable.world_bounds.w >= 0.0f &&
+            !_occlusion.is_visible(renderable.world_bounds, vp))
+        {
+            continue;
+        }
+
+        (renderable.transparent ? transparent_keys : keys)
+            .push_back(
+                { _packet.materials[ renderable.material_index ].program,
+                  glm::distance(eye, glm::vec3(renderable.world_bounds)),
+                  i });
+    }
+
+    std::sort(keys.begin(),
+              keys.end(),
+              [](const draw_key& lhs, const draw_key& rhs)
+    {
+        return std::tie(lhs.program, lhs.depth, lhs.index) <
+               std::tie(rhs.program, rhs.depth, rhs.index);
+    });
+
+    // the blending needs the farther renderables drawn first, regardless of
+    // the program
+    std::sort(transparent_keys.begin(),
+              transparent_keys.end(),
+              [](const draw_key& lhs, const draw_key& rhs)
+    {
+        return std::tie(rhs.depth, lhs.index) < std::tie(lhs.depth, rhs.index);
+    });
+
+    draw_lists lists;
+    lists.opaque.reserve(keys.size());
+    for (const auto& key : keys)
+    {
+        lists.opaque.push_back(key.index);
+    }
+    lists.transparent.reserve(transparent_keys.size());
+    for (const auto& key : transparent_keys)
+    {
+        lists.transparent.push_back(key.index);
+    }
+    return lists;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <mutex>
+#include <optional>
+
+#include "renderer/algorithms/occlusion_buffer.hpp"
+
+struct frame_packet;
+
+/**
+ * @brief Visibility of the frame packet renderables from all the cameras
+ *
+ * The renderables are tested against the frusta of all the captured cameras
+ * in a single pass and the results are kept as a bitmask per renderable.
+ * The per-camera draw lists are then built from the masks on the first
+ * request, so the work left for each camera rendering the frame is sorting
+ * its own visible set. The captured cameras not rendering the frame cost
+ * the frustum test only.
+ *
+ * When the camera sees any occluders, those are rasterized into an @ref
+ * occlusion_buffer and the rest of the visible renderables are dropped from
+ * the draw list of the camera if hidden behind them.
+ *
+ * The opaque draw list is sorted by the shader program to reduce the state
+ * changes and front to back within the program to reduce the overdraw. The
+ * transparent renderables are kept in a separate list sorted far to near, to
+ * be drawn after the opaque ones so they blend over them in order.
+ */
+class view_visibility
+{
+public:
+    using view_mask = uint64_t;
+    static constexpr size_t max_views = sizeof(view_mask) * 8;
+
+    struct draw_lists
+    {
+        // the indices of the renderables to draw first
+        std::vector<uint32_t> opaque;
+        // the indices of the blended renderables to draw after the opaque
+        std::vector<uint32_t> transparent;
+    };
+
+public:
+    explicit view_visibility(const frame_packet& packet);
+
+    /**
+     * @brief Get the mask of the cameras the renderable is visible from
+     *
+     * @param renderable the index of the renderable in the packet
+     * @return view_mask bit i is set if visible from the camera i
+     */
+    view_mask get_mask(size_t renderable) const;
+
+    /**
+     * @brief Get the sorted indices of the renderables visible by the camera
+     *
+     * The lists are built by the first call for the camera.
+     *
+     * @param view the index of the camera in the packet
+     */
+    const draw_lists& get_draw_lists(size_t view) const;
+
+private:
+    void cull();
+    bool is_visible(size_t renderable, size_t view) const;
+    bool build_occlusion(size_t view) const;
+    draw_lists build_draw_lists(size_t view) const;
+
+private:
+    // owns the visibility, so outlives it
+    const frame_packet& _packet;
+    std::vector<view_mask> _masks;
+    mutable std::mutex _draw_lists_mutex;
+    mutable occlusion_buffer _occlusion;
+    mutable std::vector<std::optional<draw_lists>> _draw_lists;
+};
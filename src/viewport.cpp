@@ -1,10 +1,8 @@
 #include "viewport.hpp"
 
 #include "camera.hpp"
-#include "game_object.hpp"
 #include "gizmo_drawer.hpp"
 #include "logging.hpp"
-#include "scene.hpp"
 #include "window.hpp"
 
 namespace
@@ -102,19 +100,12 @@ void viewport::draw() const
 {
     render_camera()->render();
 
-    glEnable(GL_BLEND);
-    if (const auto* s = scene::get_active_scene())
+    // the gizmos were recorded with the frame, if any camera shows them
+    if (auto packet = frame_packet::current())
     {
-        for (auto* obj : s->objects())
-        {
-            if (!obj->is_active())
-            {
-                continue;
-            }
-            gizmo_drawer::instance()->get_shader().set_uniform(
-                "model_matrix", obj->get_transform().get_matrix());
-            obj->draw_gizmos();
-        }
+        glEnable(GL_BLEND);
+        gizmo_drawer::instance()->draw_recorded(
+            packet->gizmos, render_camera()->frame_vp_matrix());
+        glDisable(GL_BLEND);
     }
-    glDisable(GL_BLEND);
 }
@@ -0,0 +1,59 @@
+#include <prof/profiler.hpp>
+
+#include "worker_pool.hpp"
+
+#include "thread.hpp"
+
+worker_pool::worker_pool(size_t thread_count, std::string_view name)
+{
+    thread_count = std::max<size_t>(thread_count, 1);
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        _threads.emplace_back([ this ] { run(); });
+        set_thread_name(_threads.back(), std::format("{}_{}", name, i));
+    }
+}
+
+worker_pool::~worker_pool()
+{
+    {
+        std::unique_lock lock { _mutex };
+        _stopping = true;
+        _condition.notify_all();
+    }
+
+    for (auto& thread : _threads)
+    {
+        thread.join();
+    }
+}
+
+void worker_pool::submit(std::function<void()> job)
+{
+    std::unique_lock lock { _mutex };
+    _jobs.push(std::move(job));
+    _condition.notify_one();
+}
+
+void worker_pool::run()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock lock { _mutex };
+            _condition.wait(lock,
+                            [ this ] { return !_jobs.empty() || _stopping; });
+            if (_jobs.empty())
+            {
+                return;
+            }
+
+            job = std::move(_jobs.front());
+            _jobs.pop();
+        }
+
+        auto sp = prof::profile(__FUNCTION__);
+        job();
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * @brief Runs the submitted jobs on a fixed set of background threads
+ *
+ * The jobs start in the submission order, but may finish in any order. The
+ * jobs still queued at destruction are run before the threads exit.
+ */
+class worker_pool
+{
+public:
+    /**
+     * @param thread_count the number of the threads, at least one is started
+     * @param name the name the threads are given for the debuggers
+     */
+    worker_pool(size_t thread_count, std::string_view name);
+    ~worker_pool();
+
+    void submit(std::function<void()> job);
+
+private:
+    void run();
+
+private:
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::queue<std::function<void()>> _jobs;
+    bool _stopping { false };
+};
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include "renderer/algorithms/occlusion_buffer.hpp"
+
+namespace
+{
+// the vertices are given in the clip space, so the identity is the mvp
+const glm::mat4 identity { 1.0f };
+
+// the rectangle of the normalized device coordinates at the depth
+std::vector<vertex3d> make_quad(glm::vec2 min, glm::vec2 max, float z)
+{
+    std::vector<vertex3d> vertices(4);
+    vertices[ 0 ].position() = { min.x, min.y, z };
+    vertices[ 1 ].position() = { max.x, min.y, z };
+    vertices[ 2 ].position() = { max.x, max.y, z };
+    vertices[ 3 ].position() = { min.x, max.y, z };
+    return vertices;
+}
+
+const std::vector<int> quad_indices { 0, 1, 2, 0, 2, 3 };
+
+occlusion_buffer make_buffer(const std::vector<vertex3d>& occluder)
+{
+    occlusion_buffer buffer;
+    buffer.clear();
+    buffer.rasterize(occluder, quad_indices, identity);
+    buffer.build_hierarchy();
+    return buffer;
+}
+} // namespace
+
+TEST(occlusion_buffer, full_occluder)
+{
+    // the depth of the occluder is 0.5
+    auto buffer =
+        make_buffer(make_quad({ -1.0f, -1.0f }, { 1.0f, 1.0f }, 0.0f));
+
+    EXPECT_FLOAT_EQ(buffer.get_depth({ 0, 0 }), 0.5f);
+    EXPECT_FLOAT_EQ(buffer.get_depth(buffer.get_size() - 1u), 0.5f);
+    EXPECT_FALSE(buffer.is_visible({ 0.0f, 0.0f, 0.8f, 0.1f }, identity));
+    EXPECT_FALSE(buffer.is_visible({ 0.6f, -0.6f, 0.8f, 0.1f }, identity));
+    EXPECT_TRUE(buffer.is_visible({ 0.0f, 0.0f, -0.5f, 0.1f }, identity));
+}
+
+TEST(occlusion_buffer, partial_occluder)
+{
+    // covers the left half of the screen only
+    auto buffer =
+        make_buffer(make_quad({ -1.0f, -1.0f }, { 0.0f, 1.0f }, 0.0f));
+
+    EXPECT_FLOAT_EQ(buffer.get_depth({ 0, 0 }), 0.5f);
+    EXPECT_FLOAT_EQ(buffer.get_depth(buffer.get_size() - 1u), 1.0f);
+    EXPECT_FALSE(buffer.is_visible({ -0.5f, 0.0f, 0.8f, 0.1f }, identity));
+    EXPECT_TRUE(buffer.is_visible({ 0.5f, 0.0f, 0.8f, 0.1f }, identity));
+    // partly behind the edge of the occluder
+    EXPECT_TRUE(buffer.is_visible({ 0.0f, 0.0f, 0.8f, 0.1f }, identity));
+}
+
+TEST(occlusion_buffer, near_plane_clipping)
+{
+    // the triangles crossing the near plane are not rasterized
+    auto vertices = make_quad({ -1.0f, -1.0f }, { 1.0f, 1.0f }, 0.0f);
+    // the bottom-right corner belongs to the bottom-right triangle only
+    vertices[ 1 ].position().z = -2.0f;
+    auto buffer = make_buffer(vertices);
+
+    glm::uvec2 size = buffer.get_size();
+    EXPECT_FLOAT_EQ(buffer.get_depth({ size.x / 4, size.y * 3 / 4 }), 0.5f);
+    EXPECT_FLOAT_EQ(buffer.get_depth({ size.x * 3 / 4, size.y / 4 }), 1.0f);
+    EXPECT_TRUE(buffer.is_visible({ 0.5f, -0.5f, 0.8f, 0.1f }, identity));
+
+    // the spheres reaching behind the near plane are never occluded
+    auto full = make_buffer(make_quad({ -1.0f, -1.0f }, { 1.0f, 1.0f }, 0.0f));
+    EXPECT_TRUE(full.is_visible({ 0.0f, 0.0f, -0.95f, 0.1f }, identity));
+}
+
+TEST(occlusion_buffer, empty_bounds)
+{
+    // nothing rasterized, nothing occluded
+    occlusion_buffer empty;
+    empty.clear();
+    empty.build_hierarchy();
+    EXPECT_TRUE(empty.is_visible({ 0.0f, 0.0f, 0.8f, 0.1f }, identity));
+
+    // the empty rectangles and the ones off the screen are left to the
+    // frustum culling
+    auto full = make_buffer(make_quad({ -1.0f, -1.0f }, { 1.0f, 1.0f }, 0.0f));
+    EXPECT_TRUE(full.is_visible({ 10.0f, 10.0f }, { 5.0f, 5.0f }, 0.9f));
+    EXPECT_TRUE(full.is_visible({ 3.0f, 0.0f, 0.8f, 0.1f }, identity));
+}